@@ -0,0 +1,284 @@
+#include "bench_suite.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+struct bench_shape_set_t {
+    const char *    name;
+    float           beta;
+    size_t          shapes[32][3];     // m,n,k, end with 0
+};
+
+static const bench_shape_set_t bench_shape_set_list[] = {
+    {"square", 1.0f, {
+        {96,96,96}, {192,192,192}, {384,384,384}, {768,768,768}, {1152,1152,1152},
+        {1536,1536,1536}, {2304,2304,2304}, {3072,3072,3072}, {4608,4608,4608},
+        {0,0,0}}},
+    // tokens x out x in. qkv, attn out, ffn up, ffn down, then per head score/context
+    {"transformer", 0.0f, {
+        {128,2304,768}, {128,768,768}, {128,3072,768}, {128,768,3072},
+        {384,2304,768}, {384,768,768}, {384,3072,768}, {384,768,3072},
+        {384,384,64}, {384,64,384},
+        {384,3072,1024}, {384,4096,1024}, {384,1024,4096},
+        {3072,768,3072},
+        {0,0,0}}},
+    {"tall_skinny", 1.0f, {
+        {9216,48,384}, {9216,16,1536}, {3072,32,3072}, {48,9216,384},
+        {6,4096,4096}, {96,96,9216},
+        {0,0,0}}},
+    {"batch_small", 1.0f, {
+        {6,16,64}, {24,32,64}, {48,48,48}, {48,64,128}, {96,96,96}, {96,128,64},
+        {192,192,192},
+        {0,0,0}}},
+};
+
+#define BENCH_SHAPE_SET_NUM (sizeof(bench_shape_set_list)/sizeof(bench_shape_set_list[0]))
+
+std::string bench_shape_set_names(){
+    std::string s;
+    for(size_t i=0;i<BENCH_SHAPE_SET_NUM;i++){
+        s += bench_shape_set_list[i].name;
+        s += "|";
+    }
+    return s + "all";
+}
+
+static void bench_shape_set_append(const bench_shape_set_t & set, std::vector<bench_shape_t> & shapes){
+    for(int i=0; set.shapes[i][0]; i++){
+        bench_shape_t s;
+        s.set = set.name;
+        s.m = set.shapes[i][0];
+        s.n = set.shapes[i][1];
+        s.k = set.shapes[i][2];
+        s.alpha = 1.0f;
+        s.beta = set.beta;
+        shapes.push_back(s);
+    }
+}
+
+bool bench_shape_sets(const std::string & names, std::vector<bench_shape_t> & shapes){
+    std::istringstream iss(names);
+    std::string name;
+    while(std::getline(iss, name, ',')){
+        bool found = false;
+        for(size_t i=0;i<BENCH_SHAPE_SET_NUM;i++){
+            if(name == "all" || name == bench_shape_set_list[i].name){
+                bench_shape_set_append(bench_shape_set_list[i], shapes);
+                found = true;
+            }
+        }
+        if(!found){
+            std::cerr<<"unknown shape set "<<name<<", available:"<<bench_shape_set_names()<<std::endl;
+            return false;
+        }
+    }
+    return !shapes.empty();
+}
+
+std::string bench_record_t::key() const{
+    std::ostringstream oss;
+    oss<<set<<":"<<m<<"x"<<n<<"x"<<k;
+    return oss.str();
+}
+
+void bench_record_stats(bench_record_t & rec, std::vector<double> & gflops_samples){
+    rec.samples = (int)gflops_samples.size();
+    if(gflops_samples.empty())
+        return;
+    std::sort(gflops_samples.begin(), gflops_samples.end());
+    size_t cnt = gflops_samples.size();
+    double sum = 0;
+    for(double g : gflops_samples)
+        sum += g;
+    double mean = sum / cnt;
+    double var = 0;
+    for(double g : gflops_samples)
+        var += (g-mean)*(g-mean);
+    rec.gflops_min = gflops_samples.front();
+    rec.gflops_max = gflops_samples.back();
+    rec.gflops_mean = mean;
+    rec.gflops_median = (cnt % 2) ? gflops_samples[cnt/2] :
+                            (gflops_samples[cnt/2-1] + gflops_samples[cnt/2]) / 2;
+    rec.gflops_stddev = cnt > 1 ? sqrt(var / (cnt-1)) : 0;
+}
+
+// keep the column order stable, baseline reader map column by header name
+static const char * bench_csv_header =
+    "set,m,n,k,alpha,beta,mc,nc,kc,mr,nr,kernel,tuned,skipped,samples,"
+    "gflops_min,gflops_max,gflops_mean,gflops_median,gflops_stddev,freq_mhz,peak_pct,roof_pct,ref_gflops,threshold";
+
+static void bench_write_csv(std::ostream & os, const std::vector<bench_record_t> & records){
+    os<<bench_csv_header<<"\n";
+    char buf[512];
+    for(const auto & r : records){
+        snprintf(buf, sizeof(buf),
+            "%s,%lu,%lu,%lu,%.2f,%.2f,%lu,%lu,%lu,%lu,%lu,%s,%d,%d,%d,"
+            "%.3f,%.3f,%.3f,%.3f,%.3f,%.1f,%.2f,%.2f,%.3f,%.2f\n",
+            r.set.c_str(), r.m, r.n, r.k, r.alpha, r.beta,
+            r.mc, r.nc, r.kc, r.mr, r.nr, r.kernel.c_str(), r.tuned ? 1:0, r.skipped ? 1:0, r.samples,
+            r.gflops_min, r.gflops_max, r.gflops_mean, r.gflops_median, r.gflops_stddev,
+            r.freq_mhz, r.peak_pct, r.roof_pct, r.ref_gflops, r.threshold);
+        os<<buf;
+    }
+}
+
+static void bench_write_json(std::ostream & os, const std::vector<bench_record_t> & records){
+    char buf[1024];
+    os<<"[\n";
+    for(size_t i=0;i<records.size();i++){
+        const bench_record_t & r = records[i];
+        snprintf(buf, sizeof(buf),
+            "  {\"set\":\"%s\", \"m\":%lu, \"n\":%lu, \"k\":%lu, \"alpha\":%.2f, \"beta\":%.2f,\n"
+            "   \"blocking\":{\"mc\":%lu, \"nc\":%lu, \"kc\":%lu, \"mr\":%lu, \"nr\":%lu, \"kernel\":\"%s\", \"tuned\":%s},\n"
+            "   \"skipped\":%s, \"samples\":%d,\n"
+            "   \"gflops\":{\"min\":%.3f, \"max\":%.3f, \"mean\":%.3f, \"median\":%.3f, \"stddev\":%.3f},\n"
+            "   \"freq_mhz\":%.1f, \"peak_pct\":%.2f, \"roof_pct\":%.2f, \"ref_gflops\":%.3f, \"threshold\":%.2f}%s\n",
+            r.set.c_str(), r.m, r.n, r.k, r.alpha, r.beta,
+            r.mc, r.nc, r.kc, r.mr, r.nr, r.kernel.c_str(), r.tuned ? "true":"false",
+            r.skipped ? "true":"false", r.samples,
+            r.gflops_min, r.gflops_max, r.gflops_mean, r.gflops_median, r.gflops_stddev,
+            r.freq_mhz, r.peak_pct, r.roof_pct, r.ref_gflops, r.threshold, (i+1 == records.size()) ? "" : ",");
+        os<<buf;
+    }
+    os<<"]\n";
+}
+
+bool bench_write_report(const std::string & path, const std::vector<bench_record_t> & records){
+    if(path == "-"){
+        bench_write_csv(std::cout, records);
+        return true;
+    }
+    std::ofstream ofs(path, std::ios::out | std::ios::trunc);
+    if(!ofs.is_open()){
+        std::cerr<<"can't open "<<path<<" to write report"<<std::endl;
+        return false;
+    }
+    bool json = path.size() >= 5 && path.compare(path.size()-5, 5, ".json") == 0;
+    if(json)
+        bench_write_json(ofs, records);
+    else
+        bench_write_csv(ofs, records);
+    return true;
+}
+
+static void bench_split_csv(const std::string & line, std::vector<std::string> & fields){
+    fields.clear();
+    std::istringstream iss(line);
+    std::string f;
+    while(std::getline(iss, f, ','))
+        fields.push_back(f);
+}
+
+bool bench_read_baseline(const std::string & path, std::vector<bench_record_t> & records){
+    std::ifstream ifs(path, std::ios::in);
+    if(!ifs.is_open()){
+        std::cerr<<"can't open baseline "<<path<<std::endl;
+        return false;
+    }
+    std::string line;
+    std::vector<std::string> fields;
+    std::unordered_map<std::string, size_t> col;
+    if(!std::getline(ifs, line)){
+        std::cerr<<"empty baseline "<<path<<std::endl;
+        return false;
+    }
+    bench_split_csv(line, fields);
+    for(size_t i=0;i<fields.size();i++)
+        col[fields[i]] = i;
+    for(const char * need : {"set", "m", "n", "k", "gflops_median"}){
+        if(!col.count(need)){
+            std::cerr<<"baseline "<<path<<" has no column "<<need<<", need a csv written by -out"<<std::endl;
+            return false;
+        }
+    }
+
+    auto get = [&](const char * name) -> std::string {
+        if(!col.count(name) || col[name] >= fields.size())
+            return "";
+        return fields[col[name]];
+    };
+    auto get_num = [&](const char * name) -> double {
+        std::string s = get(name);
+        return s.empty() ? 0 : atof(s.c_str());
+    };
+    while(std::getline(ifs, line)){
+        if(line.empty() || line[0] == '#')
+            continue;
+        bench_split_csv(line, fields);
+        bench_record_t r;
+        r.set = get("set");
+        r.m = (size_t)get_num("m");
+        r.n = (size_t)get_num("n");
+        r.k = (size_t)get_num("k");
+        r.alpha = (float)get_num("alpha");
+        r.beta = (float)get_num("beta");
+        r.mc = (size_t)get_num("mc");
+        r.nc = (size_t)get_num("nc");
+        r.kc = (size_t)get_num("kc");
+        r.mr = (size_t)get_num("mr");
+        r.nr = (size_t)get_num("nr");
+        r.kernel = get("kernel");
+        r.tuned = get_num("tuned") != 0;
+        r.skipped = get_num("skipped") != 0;
+        r.samples = (int)get_num("samples");
+        r.gflops_min = get_num("gflops_min");
+        r.gflops_max = get_num("gflops_max");
+        r.gflops_mean = get_num("gflops_mean");
+        r.gflops_median = get_num("gflops_median");
+        r.gflops_stddev = get_num("gflops_stddev");
+        r.freq_mhz = get_num("freq_mhz");
+        r.peak_pct = get_num("peak_pct");
+        r.roof_pct = get_num("roof_pct");
+        r.ref_gflops = get_num("ref_gflops");
+        r.threshold = get_num("threshold");
+        records.push_back(r);
+    }
+    return true;
+}
+
+int bench_compare_baseline(const std::vector<bench_record_t> & baseline,
+    const std::vector<bench_record_t> & current, double default_threshold)
+{
+    std::unordered_map<std::string, const bench_record_t *> base_map;
+    for(const auto & r : baseline)
+        base_map[r.key()] = &r;
+
+    int regressions = 0;
+    printf("baseline compare, median gflops, drop over threshold is regression\n");
+    printf(" %-30s %10s %10s %8s %9s  %s\n", "shape", "base", "current", "delta%", "thresh%", "status");
+    for(const auto & r : current){
+        std::string key = r.key();
+        auto it = base_map.find(key);
+        if(it == base_map.end()){
+            printf(" %-30s %10s %10.2f %8s %9s  new\n", key.c_str(), "-", r.gflops_median, "-", "-");
+            continue;
+        }
+        const bench_record_t & b = *it->second;
+        base_map.erase(it);
+        if(b.skipped || r.skipped || b.gflops_median <= 0){
+            printf(" %-30s %10s %10s %8s %9s  skip\n", key.c_str(), "-", "-", "-", "-");
+            continue;
+        }
+        double threshold = b.threshold > 0 ? b.threshold : default_threshold;
+        double delta = (r.gflops_median - b.gflops_median) / b.gflops_median * 100;
+        const char * status = "ok";
+        if(delta < -threshold){
+            status = "REGRESS";
+            regressions++;
+        }else if(delta > threshold)
+            status = "improve";
+        printf(" %-30s %10.2f %10.2f %+8.2f %9.2f  %s\n", key.c_str(),
+            b.gflops_median, r.gflops_median, delta, threshold, status);
+    }
+    for(const auto & it : base_map)
+        printf(" %-30s %10.2f %10s %8s %9s  missing\n", it.first.c_str(),
+            it.second->gflops_median, "-", "-", "-");
+    printf("%d regression(s)\n", regressions);
+    return regressions;
+}
@@ -0,0 +1,80 @@
+#ifndef __BENCH_SUITE_H
+#define __BENCH_SUITE_H
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+/*
+* named shape sets for the benchmark suite, row major NN, packed ld (lda=k, ldb=n, ldc=n):
+*   square          M=N=K, 96 ~ 4608
+*   transformer     per layer gemm of bert-base/large like models, M is token count
+*   tall_skinny     one of M/N much larger than the other, and large K inner product
+*   batch_small     small gemm called back to back, dominated by pack and call overhead
+*
+* shape is not rounded to the kernel tile, shape that the kernel can not take
+* (M%mr, N%nr) is reported as skipped, so the set is the same for every kernel.
+*/
+struct bench_shape_t {
+    std::string     set;
+    size_t          m;
+    size_t          n;
+    size_t          k;
+    float           alpha;
+    float           beta;
+};
+
+// "square,transformer" or "all". false if any name is unknown
+bool bench_shape_sets(const std::string & names, std::vector<bench_shape_t> & shapes);
+std::string bench_shape_set_names();
+
+/*
+* one row of the report. gflops stats are over per sample timing, each sample
+* repeat the call enough times to last ~1ms so small shape is not timer noise.
+*/
+struct bench_record_t {
+    std::string     set;
+    size_t          m {0};
+    size_t          n {0};
+    size_t          k {0};
+    float           alpha {1.0f};
+    float           beta {0.0f};
+    size_t          mc {0};
+    size_t          nc {0};
+    size_t          kc {0};
+    size_t          mr {0};
+    size_t          nr {0};
+    std::string     kernel;
+    bool            tuned {false};      // blocking from tuned db
+    bool            skipped {false};    // kernel tile does not divide M/N
+    int             samples {0};
+    double          gflops_min {0};
+    double          gflops_max {0};
+    double          gflops_mean {0};
+    double          gflops_median {0};
+    double          gflops_stddev {0};
+    double          freq_mhz {0};       // core clock over the samples
+    double          peak_pct {0};       // median against tier peak at freq_mhz
+    double          roof_pct {0};       // median against roofline, min(peak, flop/byte * stream bw)
+    double          ref_gflops {0};     // cblas median, 0 if not run
+    double          threshold {0};      // allowed drop in %, for baseline compare
+
+    std::string key() const;            // "set:MxNxK"
+};
+
+void bench_record_stats(bench_record_t & rec, std::vector<double> & gflops_samples);
+
+// format by extension, .json is json, anything else csv. "-" write csv to stdout
+bool bench_write_report(const std::string & path, const std::vector<bench_record_t> & records);
+// csv written by bench_write_report. threshold column can be edited per shape
+bool bench_read_baseline(const std::string & path, std::vector<bench_record_t> & records);
+
+/*
+* median gflops of current run vs baseline, per shape key. a drop larger than the
+* baseline row threshold (or default_threshold if the row has none) is a regression.
+* print a table, return number of regressions
+*/
+int bench_compare_baseline(const std::vector<bench_record_t> & baseline,
+    const std::vector<bench_record_t> & current, double default_threshold);
+
+#endif
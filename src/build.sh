@@ -2,13 +2,19 @@
 
 OPENBLAS_DIR=/opt/OpenBLAS/
 CC=/opt/clang+llvm-7.0.0-x86_64-linux-gnu-ubuntu-16.04/bin/clang++
-SRC="gemm_driver.cc gemm_opt.cc util.cc kernel/sgemm_c.cc kernel/sgemm_pack.cc  \
+LIB_SRC="gemm_opt.cc gemm_plan.cc gemm_strassen.cc gemm_conv.cc gemm_cgemm.cc gemm_level3.cc gemm_autotune.cc gemm_ooc.cc gemm_numa.cc gemm_pipe.cc gemm_steal.cc util.cc topology.cc kernel/sgemm_jit.cc kernel/sgemm_intrin.cc kernel/sgemm_kernel_list.cc kernel/sgemm_c.cc kernel/sgemm_pack.cc kernel/strsm_micro_kernel.cc \
     kernel/sgemm_asm_4x8.cc kernel/sgemm_asm_8x8.cc kernel/sgemm_asm_4x16.cc \
     kernel/sgemm_asm_6x16.cc"
-CXXFLAGS=" -pthread -std=c++11 -Wall -O3 -I${OPENBLAS_DIR}/include/ -m64 -mfma -msse -msse2"
+SRC="gemm_driver.cc bench_suite.cc freq.cc ${LIB_SRC}"
+CXXFLAGS=" -pthread -std=c++11 -Wall -O3 -I${OPENBLAS_DIR}/include/ -m64 -msse -msse2"
 CXXFLAGS="${CXXFLAGS} -g "
 LDFLAGS=" -L${OPENBLAS_DIR}/lib -lopenblas -lm -Wl,-rpath,${OPENBLAS_DIR}/lib"
 TARGET=gemm_driver
+BLAS_TARGET=libgemm_opt.so
 
-rm -rf $TARGET
+rm -rf $TARGET $BLAS_TARGET
 $CC $CXXFLAGS $SRC $LDFLAGS -o $TARGET
+# drop-in blas, only the blas entry points of gemm_blas.map are exported (cblas_sgemm/sgemm_,
+# cblas_cgemm/cgemm_, cblas_ssyrk/ssymm/strmm/strsm). no openblas link, cblas.h is for the enum only
+$CC $CXXFLAGS -fPIC -fvisibility=hidden -shared -Wl,--no-undefined -Wl,--version-script=gemm_blas.map \
+    gemm_blas.cc $LIB_SRC -lm -o $BLAS_TARGET
@@ -0,0 +1,236 @@
+#include "freq.h"
+
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <immintrin.h>
+#include <x86intrin.h>
+
+#define MSR_IA32_MPERF  0xe7
+#define MSR_IA32_APERF  0xe8
+
+// dependent imul chain per probe iteration, 3 cycle latency on every intel/amd core
+// since sandy bridge/zen. add reg,imm is not used, golden cove fold it at rename.
+// fma of one iteration (8 independent, 2 port) retire within it, so the chain is the
+// critical path
+#define PROBE_CHAIN     (8*3)
+#define PROBE_MUL_CHAIN(x, one)                 \
+    asm volatile(                               \
+        "imulq %1, %0\n imulq %1, %0\n"          \
+        "imulq %1, %0\n imulq %1, %0\n"          \
+        "imulq %1, %0\n imulq %1, %0\n"          \
+        "imulq %1, %0\n imulq %1, %0\n"          \
+        : "+r"(x) : "r"(one))
+
+const char * freq_source_str(freq_source_t src){
+    if(src == FREQ_SOURCE_FIXED)
+        return "fixed";
+    if(src == FREQ_SOURCE_PERF)
+        return "perf";
+    if(src == FREQ_SOURCE_MSR)
+        return "msr";
+    if(src == FREQ_SOURCE_PROBE)
+        return "probe";
+    return "n/a freq";
+}
+
+double tsc_freq_mhz(){
+    static double mhz = 0;
+    if(mhz > 0)
+        return mhz;
+    double t = current_sec();
+    unsigned long long tsc = __rdtsc();
+    while(current_sec() - t < 0.05);
+    unsigned long long tsc_end = __rdtsc();
+    mhz = (double)(tsc_end - tsc) / ((current_sec() - t) * 1e6);
+    return mhz;
+}
+
+static uint64_t freq_probe_sse(uint64_t iters){
+    __m128 acc[8];
+    __m128 m = _mm_set1_ps(0.999f);
+    for(int i=0;i<8;i++)
+        acc[i] = _mm_set1_ps((float)i);
+    uint64_t x = 1;
+    uint64_t one = 1;
+    for(uint64_t it=0; it<iters; it++){
+        for(int i=0;i<8;i++)
+            acc[i] = _mm_mul_ps(acc[i], m);
+        PROBE_MUL_CHAIN(x, one);
+    }
+    float sink[4];
+    _mm_storeu_ps(sink, acc[0]);
+    return x + (sink[0] > 1e30f);
+}
+
+__attribute__((target("avx")))
+static uint64_t freq_probe_avx(uint64_t iters){
+    __m256 acc[8];
+    __m256 m = _mm256_set1_ps(0.999f);
+    for(int i=0;i<8;i++)
+        acc[i] = _mm256_set1_ps((float)i);
+    uint64_t x = 1;
+    uint64_t one = 1;
+    for(uint64_t it=0; it<iters; it++){
+        for(int i=0;i<8;i++)
+            acc[i] = _mm256_mul_ps(acc[i], m);
+        PROBE_MUL_CHAIN(x, one);
+    }
+    float sink[8];
+    _mm256_storeu_ps(sink, acc[0]);
+    return x + (sink[0] > 1e30f);
+}
+
+__attribute__((target("avx2,fma")))
+static uint64_t freq_probe_avx2(uint64_t iters){
+    __m256 acc[8];
+    __m256 m = _mm256_set1_ps(0.999f);
+    __m256 c = _mm256_set1_ps(0.001f);
+    for(int i=0;i<8;i++)
+        acc[i] = _mm256_set1_ps((float)i);
+    uint64_t x = 1;
+    uint64_t one = 1;
+    for(uint64_t it=0; it<iters; it++){
+        for(int i=0;i<8;i++)
+            acc[i] = _mm256_fmadd_ps(acc[i], m, c);
+        PROBE_MUL_CHAIN(x, one);
+    }
+    float sink[8];
+    _mm256_storeu_ps(sink, acc[0]);
+    return x + (sink[0] > 1e30f);
+}
+
+__attribute__((target("avx512f")))
+static uint64_t freq_probe_avx512(uint64_t iters){
+    __m512 acc[8];
+    __m512 m = _mm512_set1_ps(0.999f);
+    __m512 c = _mm512_set1_ps(0.001f);
+    for(int i=0;i<8;i++)
+        acc[i] = _mm512_set1_ps((float)i);
+    uint64_t x = 1;
+    uint64_t one = 1;
+    for(uint64_t it=0; it<iters; it++){
+        for(int i=0;i<8;i++)
+            acc[i] = _mm512_fmadd_ps(acc[i], m, c);
+        PROBE_MUL_CHAIN(x, one);
+    }
+    float sink[16];
+    _mm512_storeu_ps(sink, acc[0]);
+    return x + (sink[0] > 1e30f);
+}
+
+double freq_probe_mhz(sgemm_isa_t isa, double duration_sec){
+    auto probe = [&](uint64_t iters) -> uint64_t {
+        if(isa == SGEMM_ISA_AVX512 && sgemm_isa_supported(SGEMM_ISA_AVX512))
+            return freq_probe_avx512(iters);
+        if(isa == SGEMM_ISA_AVX2 && sgemm_isa_supported(SGEMM_ISA_AVX2))
+            return freq_probe_avx2(iters);
+        if(isa == SGEMM_ISA_AVX && sgemm_isa_supported(SGEMM_ISA_AVX))
+            return freq_probe_avx(iters);
+        return freq_probe_sse(iters);
+    };
+    // first round also let the core settle into the licence of isa
+    uint64_t iters = 100000;
+    double cost = 0;
+    while(1){
+        double t = current_sec();
+        probe(iters);
+        cost = current_sec() - t;
+        if(cost >= duration_sec)
+            break;
+        iters = (uint64_t)(iters * (cost > 0 ? 1.2*duration_sec/cost : 10));
+    }
+    return (double)iters * PROBE_CHAIN / (cost * 1e6);
+}
+
+freq_meter_t::freq_meter_t(int cpu, sgemm_isa_t isa_):isa(isa_), cycles(PERF_EVENT_CYCLES){
+    if(cycles.valid()){
+        // some hypervisor allow the event but never count, check once
+        cycles.start();
+        freq_probe_sse(10000);
+        if(cycles.stop() > 0){
+            src = FREQ_SOURCE_PERF;
+            return;
+        }
+    }
+    char path[64];
+    snprintf(path, sizeof(path), "/dev/cpu/%d/msr", cpu);
+    msr_fd = open(path, O_RDONLY);
+    uint64_t a, m;
+    if(msr_fd >= 0 && msr_read(a, m) && m > 0){
+        src = FREQ_SOURCE_MSR;
+        return;
+    }
+    if(msr_fd >= 0){
+        close(msr_fd);
+        msr_fd = -1;
+    }
+    src = FREQ_SOURCE_PROBE;
+}
+
+freq_meter_t::~freq_meter_t(){
+    if(msr_fd >= 0)
+        close(msr_fd);
+}
+
+bool freq_meter_t::msr_read(uint64_t & aperf, uint64_t & mperf){
+    if(pread(msr_fd, &aperf, sizeof(aperf), MSR_IA32_APERF) != sizeof(aperf))
+        return false;
+    if(pread(msr_fd, &mperf, sizeof(mperf), MSR_IA32_MPERF) != sizeof(mperf))
+        return false;
+    return true;
+}
+
+void freq_meter_t::start(){
+    if(src == FREQ_SOURCE_PERF)
+        cycles.start();
+    else if(src == FREQ_SOURCE_MSR)
+        msr_read(aperf0, mperf0);
+    t0 = current_sec();
+}
+
+double freq_meter_t::stop(){
+    double cost = current_sec() - t0;
+    if(src == FREQ_SOURCE_PERF){
+        unsigned long long c = cycles.stop();
+        return cost > 0 ? c / (cost*1e6) : 0;
+    }
+    if(src == FREQ_SOURCE_MSR){
+        uint64_t aperf, mperf;
+        if(!msr_read(aperf, mperf) || mperf == mperf0)
+            return 0;
+        return tsc_freq_mhz() * (double)(aperf - aperf0) / (double)(mperf - mperf0);
+    }
+    return freq_probe_mhz(isa);
+}
+
+double stream_triad_gbs(size_t bytes_per_array, int trials){
+    size_t n = bytes_per_array / sizeof(float);
+    float * a = (float*)__aligned_malloc(n*sizeof(float), 64);
+    float * b = (float*)__aligned_malloc(n*sizeof(float), 64);
+    float * c = (float*)__aligned_malloc(n*sizeof(float), 64);
+    for(size_t i=0;i<n;i++){
+        a[i] = 0;
+        b[i] = 1.0f;
+        c[i] = 2.0f;
+    }
+    const float s = 3.0f;
+    double best = 0;
+    for(int t=0;t<trials;t++){
+        double start = current_sec();
+        for(size_t i=0;i<n;i++)
+            a[i] = b[i] + s*c[i];
+        double cost = current_sec() - start;
+        double gbs = 3.0*n*sizeof(float) / (cost*1e9);
+        if(gbs > best)
+            best = gbs;
+    }
+    // keep the loop from being dropped
+    if(a[n/2] != 7.0f)
+        fprintf(stderr, "stream triad check fail\n");
+    __aligned_free(a);
+    __aligned_free(b);
+    __aligned_free(c);
+    return best;
+}
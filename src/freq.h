@@ -0,0 +1,57 @@
+#ifndef __FREQ_H
+#define __FREQ_H
+
+#include "util.h"
+#include "kernel/sgemm_micro_kernel.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+* effective core frequency, so % of peak follow turbo and avx frequency licence
+* instead of a nominal -f. source in order of preference:
+*   perf    PERF_COUNT_HW_CPU_CYCLES of this thread over the timed loop
+*   msr     APERF/MPERF delta of the cpu, /dev/cpu/<N>/msr, need root + msr module.
+*           freq = tsc_freq * dAPERF/dMPERF
+*   probe   right after the timed loop, a dependent imul chain (3 cycle each)
+*           next to independent fma of the kernel isa, which hold the same licence.
+*           cycles = chain length, freq = cycles / time
+*/
+typedef enum {
+    FREQ_SOURCE_FIXED = 0,  // -f given by user, nothing measured
+    FREQ_SOURCE_PERF,
+    FREQ_SOURCE_MSR,
+    FREQ_SOURCE_PROBE
+}freq_source_t;
+
+const char * freq_source_str(freq_source_t src);
+
+// rdtsc against CLOCK_MONOTONIC, calibrated once
+double tsc_freq_mhz();
+
+// ~duration_sec of the probe loop on isa, return MHz
+double freq_probe_mhz(sgemm_isa_t isa, double duration_sec = 0.01);
+
+class freq_meter_t {
+public:
+    freq_meter_t(int cpu, sgemm_isa_t isa);
+    ~freq_meter_t();
+    void start();
+    double stop();          // MHz over start()~stop(), probe source run after the loop
+    freq_source_t source() const { return src; }
+private:
+    bool msr_read(uint64_t & aperf, uint64_t & mperf);
+
+    freq_source_t   src {FREQ_SOURCE_PROBE};
+    sgemm_isa_t     isa;
+    perf_counter_t  cycles;
+    int             msr_fd {-1};
+    uint64_t        aperf0 {0};
+    uint64_t        mperf0 {0};
+    double          t0 {0};
+};
+
+// STREAM triad a[i] = b[i] + s*c[i], single thread, best of trials. GB/s count 3 arrays
+double stream_triad_gbs(size_t bytes_per_array, int trials = 5);
+
+#endif
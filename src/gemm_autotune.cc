@@ -0,0 +1,143 @@
+#include "gemm_autotune.h"
+#include <fstream>
+#include <sstream>
+
+std::string sgemm_tune_key(const gemm_context_t * ctx){
+    std::ostringstream oss;
+    const_cast<gemm_context_t *>(ctx)->serialize(oss);
+    if(ctx->num_threads() > 1)
+        oss<<"-t"<<ctx->num_threads();
+    return oss.str();
+}
+
+void sgemm_autotune_candidates(int M, int N, int K, const gemm_context_t * ctx,
+                std::vector<sgemm_blocking_t> & cands)
+{
+    size_t mr = ctx->mr;
+    size_t nr = ctx->nr;
+    size_t fs = sizeof(float);
+    cands.clear();
+    auto add = [&](size_t mc, size_t nc, size_t kc){
+        kc = MAX(MIN(kc, (size_t)K), (size_t)1);
+        mc = MIN(CEIL_WRAP(MAX(mc, mr), mr), CEIL_WRAP((size_t)M, mr));
+        nc = MIN(CEIL_WRAP(MAX(nc, nr), nr), CEIL_WRAP((size_t)N, nr));
+        for(const sgemm_blocking_t & c : cands)
+            if(c.mc == mc && c.nc == nc && c.kc == kc)
+                return ;
+        cands.push_back({mc, nc, kc});
+    };
+    add(ctx->mc, ctx->nc, ctx->kc);
+
+    // mr x kc of A and kc x nr of B in half the L1, the other half for C and the next panel.
+    // then mc x kc of A in a part of the L2 of the thread, kc x nc of B in half the L3
+    size_t kc_l1 = ctx->l1_size / 2 / ((mr + nr)*fs);
+    const double steps[][2] = {{1.0, 0.5}, {0.75, 0.5}, {1.5, 0.5}, {1.0, 0.25},
+                               {1.0, 0.75}, {0.75, 0.75}, {1.5, 0.25}};
+    for(auto & s : steps){
+        size_t kc = MAX((size_t)(kc_l1*s[0]) / 8 * 8, (size_t)8);
+        size_t mc = (size_t)(ctx->l2_per_thread()*s[1]) / (kc*fs);
+        size_t nc = ctx->l3_size / 2 / (kc*fs);
+        add(mc, nc, kc);
+    }
+}
+
+static void autotune_apply(gemm_context_t * ctx, const sgemm_blocking_t & b){
+    ctx->mc = b.mc;
+    ctx->nc = b.nc;
+    ctx->kc = b.kc;
+}
+
+// round 1 every candidate, round 2 only the ones near the best. -1 when nothing left
+static int autotune_next(std::vector<double> & best_sec, double best, int & next){
+    int n = best_sec.size();
+    while(next < 2*n){
+        int c = next % n;
+        if(next < n || (best_sec[c] > 0 && best_sec[c] <= best * AUTOTUNE_KEEP_RATIO))
+            return c;
+        next++;
+    }
+    return -1;
+}
+
+int sgemm_autotuner_t::begin(const std::string & key, gemm_context_t * ctx){
+    if(ctx->m * ctx->n * ctx->k < cfg.min_mnk)
+        return -1;
+    std::lock_guard<std::mutex> guard(lock);
+    auto it = entries.find(key);
+    if(it == entries.end()){
+        entry_t e;
+        sgemm_autotune_candidates(ctx->m, ctx->n, ctx->k, ctx, e.cands);
+        e.best_sec.assign(e.cands.size(), 0);
+        e.runs.assign(e.cands.size(), 0);
+        e.mr = ctx->mr;
+        e.nr = ctx->nr;
+        e.st.candidates = e.cands.size();
+        it = entries.emplace(key, e).first;
+    }
+    entry_t & e = it->second;
+    if(!e.st.converged){
+        int c = autotune_next(e.best_sec, e.st.best_sec, e.next);
+        if(c >= 0){
+            e.next++;
+            autotune_apply(ctx, e.cands[c]);
+            return c;
+        }
+        // every trial handed out, one still running in another thread if nothing came back
+        if(e.st.best_sec <= 0)
+            return -1;
+        converge(key, e);
+    }
+    autotune_apply(ctx, e.st.best);
+    return -1;
+}
+
+void sgemm_autotuner_t::end(const std::string & key, int cand, double sec){
+    std::lock_guard<std::mutex> guard(lock);
+    auto it = entries.find(key);
+    if(it == entries.end() || it->second.st.converged)
+        return ;
+    entry_t & e = it->second;
+    sgemm_autotune_stats_t & st = e.st;
+    e.best_sec[cand] = e.runs[cand] ? MIN(e.best_sec[cand], sec) : sec;
+    e.runs[cand]++;
+    st.trials++;
+    st.trial_sec += sec;
+    if(st.best_sec <= 0 || sec < st.best_sec){
+        st.best_sec = sec;
+        st.best = e.cands[cand];
+    }
+    // overhead is the trials against as many calls at the best. the next trial is not
+    // started if it would cross the budget: a rerun at its known time, a first run as slow
+    // as the slowest candidate so far
+    st.excess_sec = st.trial_sec - st.trials*st.best_sec;
+    int c = autotune_next(e.best_sec, st.best_sec, e.next);
+    bool over = true;
+    if(c >= 0){
+        double next_sec = e.runs[c] ? e.best_sec[c] : *std::max_element(e.best_sec.begin(), e.best_sec.end());
+        over = st.excess_sec + next_sec - st.best_sec > cfg.budget * (st.trials+1)*st.best_sec;
+    }
+    if(st.trials >= cfg.max_calls || over)
+        converge(key, e);
+}
+
+void sgemm_autotuner_t::converge(const std::string & key, entry_t & e){
+    e.st.converged = true;
+    if(cfg.db_file.empty())
+        return ;
+    // "mc|nc|kc|mr|nr", what -tune write and gemm_blas read back
+    std::ofstream outfile(cfg.db_file, std::ios_base::app);
+    if(!outfile.good()){
+        std::cerr<<"gemm_opt: can't append tuned db "<<cfg.db_file<<std::endl;
+        return ;
+    }
+    outfile<<key<<":"<<e.st.best.mc<<"|"<<e.st.best.nc<<"|"<<e.st.best.kc<<"|"<<e.mr<<"|"<<e.nr<<std::endl;
+}
+
+bool sgemm_autotuner_t::stats(const std::string & key, sgemm_autotune_stats_t & s){
+    std::lock_guard<std::mutex> guard(lock);
+    auto it = entries.find(key);
+    if(it == entries.end())
+        return false;
+    s = it->second.st;
+    return true;
+}
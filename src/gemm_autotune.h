@@ -0,0 +1,87 @@
+#ifndef __GEMM_AUTOTUNE_H
+#define __GEMM_AUTOTUNE_H
+
+#include "gemm_driver.h"
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/*
+* online tuning, the first calls of a problem not in the tuned db are the search:
+*
+*   candidates  sgemm_autotune_candidates(), the ctx blocking first, then kc from the L1
+*               (mr+nr panels), mc from a fraction of the L2 per thread and nc from the L3,
+*               clipped to the problem. the same model as -tune, without the full sweep
+*   trials      begin() put the next candidate in ctx, the caller time its real call and
+*               end() the time. round 1 run every candidate once, round 2 only the ones
+*               within AUTOTUNE_KEEP_RATIO of the best, best of the runs is kept
+*   converge    all rounds done, or max_calls trials, or the next trial would take the
+*               overhead, time of the trials over as many calls at the best (excess /
+*               (trials * best)), past budget. a first run is guessed as slow as the slowest
+*               so far, so it can still cross a little. then the best is final: used by every
+*               later call and appended to db_file in the -tune format
+*
+* key is sgemm_tune_key(), layout/trans/shape and the thread count if more than one.
+* thread safe, one lock per begin()/end(). problem under min_mnk is not tuned, blocking
+* does not matter there and a timing is mostly noise.
+*/
+#define AUTOTUNE_KEEP_RATIO 1.1
+
+struct sgemm_blocking_t {
+    size_t  mc;
+    size_t  nc;
+    size_t  kc;
+};
+
+// db key of ctx problem, as ctx->serialize() with "-t<threads>" appended if multi thread
+std::string sgemm_tune_key(const gemm_context_t * ctx);
+
+void sgemm_autotune_candidates(int M, int N, int K, const gemm_context_t * ctx,
+                std::vector<sgemm_blocking_t> & cands);
+
+struct sgemm_autotune_config_t {
+    int         max_calls {16};         // tuning calls per key at most
+    double      budget {0.1};           // overhead allowed, excess / (trials * best)
+    size_t      min_mnk {128*128*128};
+    std::string db_file;                // converged entry appended here, empty not persisted
+};
+
+struct sgemm_autotune_stats_t {
+    int                 candidates {0};
+    int                 trials {0};
+    bool                converged {false};
+    sgemm_blocking_t    best {0, 0, 0};
+    double              best_sec {0};
+    double              trial_sec {0};  // sum of all trial time
+    double              excess_sec {0}; // trial_sec - trials * best_sec
+};
+
+class sgemm_autotuner_t {
+public:
+    sgemm_autotuner_t(const sgemm_autotune_config_t & cfg_) : cfg(cfg_) {}
+    /*
+    * blocking of this call into ctx (m/n/k, layout, mr/nr already set). return the candidate
+    * index if the call is a trial and must be timed and given to end(), -1 if ctx now hold
+    * the converged blocking or the problem is not tuned
+    */
+    int begin(const std::string & key, gemm_context_t * ctx);
+    void end(const std::string & key, int cand, double sec);
+    bool stats(const std::string & key, sgemm_autotune_stats_t & s);
+
+private:
+    struct entry_t {
+        std::vector<sgemm_blocking_t>   cands;
+        std::vector<double>             best_sec;   // per candidate, 0 not run yet
+        std::vector<int>                runs;
+        size_t                          mr, nr;
+        int                             next {0};   // trial counter, round = next / cands
+        sgemm_autotune_stats_t          st;
+    };
+    void converge(const std::string & key, entry_t & e);
+
+    sgemm_autotune_config_t cfg;
+    std::mutex              lock;
+    std::unordered_map<std::string, entry_t> entries;
+};
+
+#endif
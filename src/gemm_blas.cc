@@ -0,0 +1,638 @@
+#include "gemm_driver.h"
+#include "gemm_opt.h"
+#include "gemm_config.h"
+#include "gemm_cgemm.h"
+#include "gemm_level3.h"
+#include "gemm_autotune.h"
+
+#include <stdio.h>
+#include <unistd.h>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/*
+* drop-in blas, built into libgemm_opt.so (see build.sh). export standard
+*   cblas_sgemm()   cblas interface, row/col major
+*   sgemm_()        fortran interface, col major, all by pointer
+*   cblas_cgemm()   complex, cblas_cgemm_opt (gemm_cgemm.h), conj trans honored, single thread
+*   cgemm_()        fortran complex
+*   cblas_ssyrk() cblas_ssymm() cblas_strmm() cblas_strsm()   gemm_level3.h, single thread
+* everything else in the library is hidden, so it can be LD_PRELOADed in front of
+* openblas/netlib, only these are taken over.
+*
+* context is built once from env on first call:
+*   GEMM_KERNEL         registered micro kernel name, default auto (sgemm_kernel_best)
+*   GEMM_NUM_THREADS    threads, default 1. >1 use the numa path
+*   GEMM_NUMA           shared|replicate|steal, default replicate, used if threads > 1
+*   GEMM_PLACE          compact|core|smt, worker placement, default compact
+*   GEMM_TUNED_DB       tuned db from -tune (sgemm_tuned.db), per shape mc/nc/kc
+*   GEMM_AUTOTUNE       1 tune online a shape not in the db (gemm_autotune.h), result appended
+*                       to the db, sgemm_tuned.db (sgemm_hugepage_tuned.db) if none given
+*   GEMM_AUTOTUNE_CALLS tuning calls per shape at most, default 16
+*   GEMM_AUTOTUNE_BUDGET tuning overhead, trial time lost / that many calls at the best, default 0.1
+*   GEMM_MC/NC/KC       default blocking if shape not in db
+*   GEMM_HUGE_PAGE      1 back pack buffer with 2M page
+*   GEMM_NT_STORE       0 disable streaming store of C
+*   GEMM_VERBOSE        1 print the context on first call
+* cache size is read by sysconf, gemm_config.h value if not available.
+*
+* every call is turned into row major NN for sgemm_n_nn:
+*   col major           C^T = op(B)^T * op(A)^T, swap A/B and M/N, row major view of same buffer
+*   transposed operand  copied (tiled) into a per thread scratch reused across calls, O(MK) or O(KN)
+*   M%mr, N%nr          the full tile part run the fast path, bottom/right strip zero padded to a
+*                       tile on the same kernel (sgemm_n_nn_edge), single thread. N<nr is all strip
+*/
+
+#define GEMM_BLAS_API extern "C" __attribute__((visibility("default")))
+
+#define GEMM_BLAS_ALIGN 64
+
+struct gemm_blas_state_t {
+    gemm_context_t  ctx;
+    std::unordered_map<std::string, std::string> tuned_map;    // ctx key -> "mc|nc|kc|mr|nr..."
+    std::unique_ptr<sgemm_autotuner_t> autotuner;              // null if GEMM_AUTOTUNE not set
+    bool            valid {false};
+};
+
+static int env_int(const char * name, int def){
+    const char * v = getenv(name);
+    return (v && *v) ? atoi(v) : def;
+}
+
+static std::string env_str(const char * name, const char * def){
+    const char * v = getenv(name);
+    return (v && *v) ? std::string(v) : std::string(def);
+}
+
+static size_t sysconf_size(int name, size_t def){
+    long v = sysconf(name);
+    return v > 0 ? (size_t)v : def;
+}
+
+// same format as gemm_bench serialize_map(), "key:value" per line
+static void gemm_blas_load_db(const std::string & file_name,
+        std::unordered_map<std::string, std::string> & map)
+{
+    std::ifstream infile(file_name);
+    if(!infile.good()){
+        std::cerr<<"gemm_opt: can't open tuned db "<<file_name<<", use default blocking"<<std::endl;
+        return ;
+    }
+    std::string line;
+    while(std::getline(infile, line)){
+        size_t col_pos = line.find_first_of(':');
+        if(col_pos == std::string::npos)
+            continue;
+        size_t col_pos_next = line.find_first_of(':', col_pos+1);
+        map[line.substr(0, col_pos)] = (col_pos_next == std::string::npos) ?
+                line.substr(col_pos+1) : line.substr(col_pos+1, col_pos_next-col_pos-1);
+    }
+}
+
+static void gemm_blas_init(gemm_blas_state_t * st){
+    gemm_context_t & ctx = st->ctx;
+    ctx.layout  = LAYOUT_ROW_MAJOR;
+    ctx.trans_a = TRANS_NO_TRANS;
+    ctx.trans_b = TRANS_NO_TRANS;
+    ctx.m = ctx.n = ctx.k = 0;
+    ctx.lda = ctx.ldb = ctx.ldc = 0;
+    ctx.alpha = 1.0;
+    ctx.beta = 0;
+    ctx.alignment = GEMM_BLAS_ALIGN;
+
+    std::string kernel = env_str("GEMM_KERNEL", "auto");
+    const sgemm_kernel_desc_t * desc = (kernel == "auto") ?
+                    sgemm_kernel_best() : sgemm_kernel_find(kernel.c_str());
+    if(desc && !sgemm_isa_supported(desc->isa)){
+        std::cerr<<"gemm_opt: kernel "<<kernel<<" need "<<sgemm_isa_str(desc->isa)<<", use auto"<<std::endl;
+        desc = sgemm_kernel_best();
+    }else if(!desc && kernel != "auto"){
+        std::cerr<<"gemm_opt: no such kernel "<<kernel<<", use auto"<<std::endl;
+        desc = sgemm_kernel_best();
+    }
+    if(!desc){
+        std::cerr<<"gemm_opt: no micro kernel for this cpu, need at least sse4.2. fall back to plain loop"<<std::endl;
+        return ;
+    }
+    sgemm_set_kernel(&ctx, desc);
+    ctx.mc = CEIL_WRAP(env_int("GEMM_MC", BLOCK_M), ctx.mr);
+    ctx.nc = CEIL_WRAP(env_int("GEMM_NC", BLOCK_N), ctx.nr);
+    ctx.kc = env_int("GEMM_KC", BLOCK_K);
+
+    ctx.l1_size = sysconf_size(_SC_LEVEL1_DCACHE_SIZE, L1_SIZE);
+    ctx.l2_size = sysconf_size(_SC_LEVEL2_CACHE_SIZE, L2_SIZE);
+    ctx.l3_size = sysconf_size(_SC_LEVEL3_CACHE_SIZE, L3_SIZE);
+    ctx.cacheline_size = sysconf_size(_SC_LEVEL1_DCACHE_LINESIZE, CACHELINE_SIZE);
+    ctx.tlb_entry_l1d = L1D_TLB_ENTRY;
+    ctx.tlb_entry_l1d_huge = L1D_TLB_ENTRY_HUGE;
+    ctx.page_size = sysconf_size(_SC_PAGESIZE, PAGE_SIZE);
+    if(env_int("GEMM_HUGE_PAGE", 0) == 1){
+        ctx.huge_page = huge_page_probe();
+        if(ctx.huge_page != HUGE_PAGE_NONE)
+            ctx.page_size = HUGE_PAGE_SIZE;
+    }
+    ctx.frequency = 0;
+    ctx.nt_store = env_int("GEMM_NT_STORE", 1) == 1;
+
+    ctx.threads = MAX(env_int("GEMM_NUM_THREADS", 1), 1);
+    if(ctx.threads > 1){
+        std::string numa = env_str("GEMM_NUMA", "replicate");
+        ctx.numa_mode = (numa == "shared") ? NUMA_MODE_SHARED : NUMA_MODE_REPLICATE;
+        ctx.steal = numa == "steal";
+        std::string place = env_str("GEMM_PLACE", "compact");
+        ctx.place = (place == "core") ? PLACE_CORE : ((place == "smt") ? PLACE_SMT : PLACE_COMPACT);
+    }
+
+    std::string db = env_str("GEMM_TUNED_DB", "");
+    bool autotune = env_int("GEMM_AUTOTUNE", 0) == 1;
+    if(autotune){
+        if(db.empty())
+            db = ctx.huge_page ? "sgemm_hugepage_tuned.db" : "sgemm_tuned.db";
+        sgemm_autotune_config_t cfg;
+        cfg.max_calls = MAX(env_int("GEMM_AUTOTUNE_CALLS", cfg.max_calls), 1);
+        const char * budget = getenv("GEMM_AUTOTUNE_BUDGET");
+        if(budget && *budget)
+            cfg.budget = atof(budget);
+        cfg.min_mnk = MT_MIN_MNK;
+        cfg.db_file = db;
+        st->autotuner.reset(new sgemm_autotuner_t(cfg));
+    }
+    // autotune db is created by the first converged shape, not there yet is fine
+    if(!db.empty() && (!autotune || std::ifstream(db).good()))
+        gemm_blas_load_db(db, st->tuned_map);
+
+    if(env_int("GEMM_VERBOSE", 0) == 1){
+        fprintf(stderr, "gemm_opt: kernel:%s(%dx%d), mc:%lu, nc:%lu, kc:%lu, l1:%luK, l2:%luK, l3:%luK, "
+            "page:%lu, threads:%lu(%s), tuned db:%s(%lu)%s\n",
+            desc->name, desc->mr, desc->nr, ctx.mc, ctx.nc, ctx.kc,
+            ctx.l1_size/1024, ctx.l2_size/1024, ctx.l3_size/1024, ctx.page_size,
+            ctx.threads, ctx.steal ? "steal" : to_numa_mode_str(ctx.numa_mode),
+            db.empty() ? "none" : db.c_str(), st->tuned_map.size(), autotune ? ", autotune" : "");
+    }
+    st->valid = true;
+}
+
+static const gemm_blas_state_t * gemm_blas_state(){
+    static gemm_blas_state_t st;
+    static std::once_flag flag;
+    std::call_once(flag, gemm_blas_init, &st);
+    return &st;
+}
+
+/*
+* tuned entry of this shape, only if it is for the same micro kernel tile (or a jit kernel).
+* the entry of this thread count (autotune) first, then the one of -tune. false if none
+*/
+static bool gemm_blas_apply_tuned(const gemm_blas_state_t * st, gemm_context_t * ctx){
+    if(st->tuned_map.empty())
+        return false;
+    std::string key;
+    ctx->serialize(key);
+    auto it = st->tuned_map.find(sgemm_tune_key(ctx));
+    if(it == st->tuned_map.end())
+        it = st->tuned_map.find(key);
+    if(it == st->tuned_map.end())
+        return false;
+    std::istringstream iss(it->second);
+    unsigned char _d;
+    size_t mc, nc, kc;
+    std::string kernel_str;
+    iss>>mc>>_d>>nc>>_d>>kc>>_d>>kernel_str;
+    if(!mc || !nc || !kc)
+        return false;
+    sgemm_jit_config_t jit_cfg;
+    if(jit_cfg.deserialize(kernel_str)){
+        if(!sgemm_set_jit_kernel(ctx, &jit_cfg))
+            return false;
+    }else{
+        size_t mr = 0, nr = 0;
+        std::istringstream kiss(kernel_str);
+        kiss>>mr>>_d>>nr;
+        if(mr != ctx->mr || nr != ctx->nr)
+            return false;
+    }
+    ctx->mc = CEIL_WRAP(mc, ctx->mr);
+    ctx->nc = CEIL_WRAP(nc, ctx->nr);
+    ctx->kc = kc;
+    return true;
+}
+
+// C = alpha*A*B + beta*C, all row major NN. i-k-j order so the inner loop vectorize
+static void sgemm_n_nn_plain(int M, int N, int K,
+                float alpha,
+                const float *A, int lda,
+                const float *B, int ldb,
+                float beta,
+                float *C, int ldc)
+{
+    scale_C(M, N, beta, C, ldc);
+    if(alpha == 0.f)
+        return ;
+    for(int i=0;i<M;i++){
+        float * c_row = C + (size_t)i*ldc;
+        for(int p=0;p<K;p++){
+            float a = alpha * A[(size_t)i*lda + p];
+            const float * b_row = B + (size_t)p*ldb;
+            for(int j=0;j<N;j++)
+                c_row[j] += a * b_row[j];
+        }
+    }
+}
+
+// dst[cols*rows] row major = transpose of src[rows*cols] row major, in tiles so both side stay in cache
+static void gemm_blas_transpose(int rows, int cols, const float * src, int ld, float * dst){
+    const int tile = 16;
+    for(int r0=0;r0<rows;r0+=tile){
+        int r1 = r0 + tile < rows ? r0 + tile : rows;
+        for(int c0=0;c0<cols;c0+=tile){
+            int c1 = c0 + tile < cols ? c0 + tile : cols;
+            for(int c=c0;c<c1;c++)
+                for(int r=r0;r<r1;r++)
+                    dst[(size_t)c*rows + r] = src[(size_t)r*ld + c];
+        }
+    }
+}
+
+static void gemm_blas_sgemm_row(bool trans_a, bool trans_b,
+                int M, int N, int K,
+                float alpha,
+                const float *A, int lda,
+                const float *B, int ldb,
+                float beta,
+                float *C, int ldc)
+{
+    if(M == 0 || N == 0)
+        return ;
+    if(K == 0 || alpha == 0.f){
+        scale_C(M, N, beta, C, ldc);
+        return ;
+    }
+    // transposed copy in the per thread scratch, no malloc once it has grown
+    float * A_copy = nullptr;
+    float * B_copy = nullptr;
+    if(trans_a){
+        A_copy = sgemm_scratch_get(SCRATCH_A_TRANS, (size_t)M*K*sizeof(float));
+        gemm_blas_transpose(K, M, A, lda, A_copy);
+        A = A_copy;
+        lda = K;
+    }
+    if(trans_b){
+        B_copy = sgemm_scratch_get(SCRATCH_B_TRANS, (size_t)K*N*sizeof(float));
+        gemm_blas_transpose(N, K, B, ldb, B_copy);
+        B = B_copy;
+        ldb = N;
+    }
+
+    const gemm_blas_state_t * st = gemm_blas_state();
+    if(st->valid){
+        gemm_context_t ctx = st->ctx;
+        int M0 = M - M % ctx.mr;
+        int N0 = N - N % ctx.nr;
+        if(M0 && N0){
+            ctx.m = M0;
+            ctx.n = N0;
+            ctx.k = K;
+            ctx.lda = lda;
+            ctx.ldb = ldb;
+            ctx.ldc = ldc;
+            ctx.alpha = alpha;
+            ctx.beta = beta;
+            bool tuned = gemm_blas_apply_tuned(st, &ctx);
+            // tuned kernel may change the tile
+            M0 = M - M % ctx.mr;
+            N0 = N - N % ctx.nr;
+            // single thread, steal is checked first by cblas_sgemm_opt
+            if((size_t)M0*N0*K < MT_MIN_MNK){
+                ctx.numa_mode = NUMA_MODE_OFF;
+                ctx.steal = false;
+            }
+            std::string key;
+            int cand = -1;
+            if(!tuned && st->autotuner && M0 && N0){
+                key = sgemm_tune_key(&ctx);
+                cand = st->autotuner->begin(key, &ctx);
+            }
+            double t0 = cand >= 0 ? current_sec() : 0;
+            if(M0 && N0)
+                cblas_sgemm_opt(LAYOUT_ROW_MAJOR, TRANS_NO_TRANS, TRANS_NO_TRANS,
+                    M0, N0, K, alpha, A, lda, B, ldb, beta, C, ldc, &ctx);
+            if(cand >= 0)
+                st->autotuner->end(key, cand, current_sec() - t0);
+        }
+        // right strip, bottom rows and corner zero padded to a tile, same kernel and blocking
+        sgemm_n_nn_edge(M, N, K, M0, N0, alpha, A, lda, B, ldb, beta, C, ldc, &ctx);
+    }else{
+        sgemm_n_nn_plain(M, N, K, alpha, A, lda, B, ldb, beta, C, ldc);
+    }
+
+    if(A_copy)
+        sgemm_scratch_put(SCRATCH_A_TRANS, A_copy);
+    if(B_copy)
+        sgemm_scratch_put(SCRATCH_B_TRANS, B_copy);
+}
+
+/*
+* parameter check of reference blas, return the position of the bad one (as xerbla print), 0 if ok.
+* position is of cblas_sgemm, fortran sgemm_ has no Order in front so one less
+*/
+static int gemm_blas_check(bool col_major, bool trans_a, bool trans_b,
+                int M, int N, int K, int lda, int ldb, int ldc)
+{
+    int a_ld, b_ld, c_ld;
+    if(col_major){
+        a_ld = trans_a ? K : M;
+        b_ld = trans_b ? N : K;
+        c_ld = M;
+    }else{
+        a_ld = trans_a ? M : K;
+        b_ld = trans_b ? K : N;
+        c_ld = N;
+    }
+    if(M < 0) return 4;
+    if(N < 0) return 5;
+    if(K < 0) return 6;
+    if(lda < MAX(1, a_ld)) return 9;
+    if(ldb < MAX(1, b_ld)) return 11;
+    if(ldc < MAX(1, c_ld)) return 14;
+    return 0;
+}
+
+static void gemm_blas_sgemm(bool col_major, bool trans_a, bool trans_b,
+                int M, int N, int K,
+                float alpha,
+                const float *A, int lda,
+                const float *B, int ldb,
+                float beta,
+                float *C, int ldc,
+                bool fortran)
+{
+    int bad = gemm_blas_check(col_major, trans_a, trans_b, M, N, K, lda, ldb, ldc);
+    if(bad){
+        fprintf(stderr, " ** On entry to %s parameter number %d had an illegal value\n",
+            fortran ? "SGEMM " : "cblas_sgemm", fortran ? bad-1 : bad);
+        return ;
+    }
+    if(col_major)
+        gemm_blas_sgemm_row(trans_b, trans_a, N, M, K, alpha, B, ldb, A, lda, beta, C, ldc);
+    else
+        gemm_blas_sgemm_row(trans_a, trans_b, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+GEMM_BLAS_API
+void cblas_sgemm(const enum CBLAS_ORDER Order, const enum CBLAS_TRANSPOSE TransA,
+                const enum CBLAS_TRANSPOSE TransB,
+                const int M, const int N, const int K,
+                const float alpha,
+                const float *A, const int lda,
+                const float *B, const int ldb,
+                const float beta,
+                float *C, const int ldc)
+{
+    if(Order != CblasRowMajor && Order != CblasColMajor){
+        fprintf(stderr, " ** On entry to cblas_sgemm parameter number 1 had an illegal value\n");
+        return ;
+    }
+    // real matrix, conj is a no-op
+    bool trans_a = TransA == CblasTrans || TransA == CblasConjTrans;
+    bool trans_b = TransB == CblasTrans || TransB == CblasConjTrans;
+    gemm_blas_sgemm(Order == CblasColMajor, trans_a, trans_b,
+        M, N, K, alpha, A, lda, B, ldb, beta, C, ldc, false);
+}
+
+static int gemm_blas_trans_char(char t){
+    if(t == 'N' || t == 'n')
+        return 0;
+    if(t == 'T' || t == 't' || t == 'C' || t == 'c')
+        return 1;
+    return -1;
+}
+
+GEMM_BLAS_API
+void sgemm_(const char *transa, const char *transb,
+                const int *m, const int *n, const int *k,
+                const float *alpha,
+                const float *a, const int *lda,
+                const float *b, const int *ldb,
+                const float *beta,
+                float *c, const int *ldc)
+{
+    int ta = gemm_blas_trans_char(*transa);
+    int tb = gemm_blas_trans_char(*transb);
+    if(ta < 0 || tb < 0){
+        fprintf(stderr, " ** On entry to SGEMM  parameter number %d had an illegal value\n", ta < 0 ? 1 : 2);
+        return ;
+    }
+    gemm_blas_sgemm(true, ta == 1, tb == 1, *m, *n, *k, *alpha, a, *lda, b, *ldb, *beta, c, *ldc, true);
+}
+
+static trans_t gemm_blas_ctrans(int t){
+    return t == CblasTrans ? TRANS_TRANS : t == CblasConjTrans ? TRANS_CONJ_TRANS :
+        t == CblasConjNoTrans ? TRANS_CONJ_NO_TRANS : TRANS_NO_TRANS;
+}
+
+// no micro kernel, one dot product per element of C
+static void cgemm_plain(bool col_major, trans_t trans_a, trans_t trans_b,
+                int M, int N, int K,
+                const float *alpha,
+                const float *A, int lda,
+                const float *B, int ldb,
+                const float *beta,
+                float *C, int ldc)
+{
+    bool ta = trans_a == TRANS_TRANS || trans_a == TRANS_CONJ_TRANS;
+    bool tb = trans_b == TRANS_TRANS || trans_b == TRANS_CONJ_TRANS;
+    float sa = (trans_a == TRANS_CONJ_TRANS || trans_a == TRANS_CONJ_NO_TRANS) ? -1.f : 1.f;
+    float sb = (trans_b == TRANS_CONJ_TRANS || trans_b == TRANS_CONJ_NO_TRANS) ? -1.f : 1.f;
+    // float offset of element (r, c), row or col major
+    auto at = [col_major](int ld, int r, int c){
+        return col_major ? ((size_t)c*ld + r)*2 : ((size_t)r*ld + c)*2;
+    };
+    for(int i=0; i<M; i++){
+        for(int j=0; j<N; j++){
+            float sr = 0.f, si = 0.f;
+            for(int p=0; p<K; p++){
+                const float * a = A + (ta ? at(lda, p, i) : at(lda, i, p));
+                const float * b = B + (tb ? at(ldb, j, p) : at(ldb, p, j));
+                float ar = a[0], ai = sa*a[1];
+                float br = b[0], bi = sb*b[1];
+                sr += ar*br - ai*bi;
+                si += ar*bi + ai*br;
+            }
+            float * c = C + at(ldc, i, j);
+            float cr = 0.f, ci = 0.f;
+            if(beta[0] != 0.f || beta[1] != 0.f){
+                cr = beta[0]*c[0] - beta[1]*c[1];
+                ci = beta[0]*c[1] + beta[1]*c[0];
+            }
+            c[0] = alpha[0]*sr - alpha[1]*si + cr;
+            c[1] = alpha[0]*si + alpha[1]*sr + ci;
+        }
+    }
+}
+
+static void gemm_blas_cgemm(bool col_major, trans_t trans_a, trans_t trans_b,
+                int M, int N, int K,
+                const void *alpha,
+                const void *A, int lda,
+                const void *B, int ldb,
+                const void *beta,
+                void *C, int ldc,
+                bool fortran)
+{
+    bool ta = trans_a == TRANS_TRANS || trans_a == TRANS_CONJ_TRANS;
+    bool tb = trans_b == TRANS_TRANS || trans_b == TRANS_CONJ_TRANS;
+    int bad = gemm_blas_check(col_major, ta, tb, M, N, K, lda, ldb, ldc);
+    if(bad){
+        fprintf(stderr, " ** On entry to %s parameter number %d had an illegal value\n",
+            fortran ? "CGEMM " : "cblas_cgemm", fortran ? bad-1 : bad);
+        return ;
+    }
+    const gemm_blas_state_t * st = gemm_blas_state();
+    if(!st->valid){
+        cgemm_plain(col_major, trans_a, trans_b, M, N, K, (const float *)alpha,
+            (const float *)A, lda, (const float *)B, ldb, (const float *)beta, (float *)C, ldc);
+        return ;
+    }
+    cblas_cgemm_opt(col_major ? LAYOUT_COL_MAJOR : LAYOUT_ROW_MAJOR, trans_a, trans_b,
+        M, N, K, alpha, A, lda, B, ldb, beta, C, ldc, &st->ctx);
+}
+
+GEMM_BLAS_API
+void cblas_cgemm(const enum CBLAS_ORDER Order, const enum CBLAS_TRANSPOSE TransA,
+                const enum CBLAS_TRANSPOSE TransB,
+                const int M, const int N, const int K,
+                const void *alpha,
+                const void *A, const int lda,
+                const void *B, const int ldb,
+                const void *beta,
+                void *C, const int ldc)
+{
+    if(Order != CblasRowMajor && Order != CblasColMajor){
+        fprintf(stderr, " ** On entry to cblas_cgemm parameter number 1 had an illegal value\n");
+        return ;
+    }
+    gemm_blas_cgemm(Order == CblasColMajor, gemm_blas_ctrans(TransA), gemm_blas_ctrans(TransB),
+        M, N, K, alpha, A, lda, B, ldb, beta, C, ldc, false);
+}
+
+GEMM_BLAS_API
+void cgemm_(const char *transa, const char *transb,
+                const int *m, const int *n, const int *k,
+                const void *alpha,
+                const void *a, const int *lda,
+                const void *b, const int *ldb,
+                const void *beta,
+                void *c, const int *ldc)
+{
+    int ta = gemm_blas_trans_char(*transa);
+    int tb = gemm_blas_trans_char(*transb);
+    if(ta < 0 || tb < 0){
+        fprintf(stderr, " ** On entry to CGEMM  parameter number %d had an illegal value\n", ta < 0 ? 1 : 2);
+        return ;
+    }
+    bool ca = *transa == 'C' || *transa == 'c';
+    bool cb = *transb == 'C' || *transb == 'c';
+    gemm_blas_cgemm(true, ta ? (ca ? TRANS_CONJ_TRANS : TRANS_TRANS) : TRANS_NO_TRANS,
+        tb ? (cb ? TRANS_CONJ_TRANS : TRANS_TRANS) : TRANS_NO_TRANS,
+        *m, *n, *k, alpha, a, *lda, b, *ldb, beta, c, *ldc, true);
+}
+
+/*
+* level 3 cblas, no plain loop fallback: without a micro kernel the state is not valid and
+* the call is reported, as the caller would get from a blas without the routine
+*/
+static bool gemm_blas_l3_check(const char * name, int order, int bad){
+    if(order != CblasRowMajor && order != CblasColMajor)
+        bad = 1;
+    if(bad){
+        fprintf(stderr, " ** On entry to %s parameter number %d had an illegal value\n", name, bad);
+        return false;
+    }
+    if(!gemm_blas_state()->valid){
+        fprintf(stderr, " ** %s need a micro kernel, none on this cpu\n", name);
+        return false;
+    }
+    return true;
+}
+
+static inline layout_t gemm_blas_layout(int order){
+    return order == CblasColMajor ? LAYOUT_COL_MAJOR : LAYOUT_ROW_MAJOR;
+}
+static inline trans_t gemm_blas_trans(int t){
+    return (t == CblasTrans || t == CblasConjTrans) ? TRANS_TRANS : TRANS_NO_TRANS;
+}
+
+GEMM_BLAS_API
+void cblas_ssyrk(const enum CBLAS_ORDER Order, const enum CBLAS_UPLO Uplo,
+                const enum CBLAS_TRANSPOSE Trans, const int N, const int K,
+                const float alpha, const float *A, const int lda,
+                const float beta, float *C, const int ldc)
+{
+    bool row = Order == CblasRowMajor;
+    bool ta = Trans == CblasTrans || Trans == CblasConjTrans;
+    int a_ld = (row != ta) ? K : N;
+    int bad = N < 0 ? 4 : K < 0 ? 5 : lda < MAX(1, a_ld) ? 8 : ldc < MAX(1, N) ? 11 : 0;
+    if(!gemm_blas_l3_check("cblas_ssyrk", Order, bad))
+        return ;
+    cblas_ssyrk_opt(gemm_blas_layout(Order), Uplo == CblasLower ? UPLO_LOWER : UPLO_UPPER,
+        gemm_blas_trans(Trans), N, K, alpha, A, lda, beta, C, ldc, &gemm_blas_state()->ctx);
+}
+
+GEMM_BLAS_API
+void cblas_ssymm(const enum CBLAS_ORDER Order, const enum CBLAS_SIDE Side,
+                const enum CBLAS_UPLO Uplo, const int M, const int N,
+                const float alpha, const float *A, const int lda,
+                const float *B, const int ldb, const float beta,
+                float *C, const int ldc)
+{
+    bool row = Order == CblasRowMajor;
+    int na = Side == CblasLeft ? M : N;
+    int ld = row ? N : M;
+    int bad = M < 0 ? 4 : N < 0 ? 5 : lda < MAX(1, na) ? 8 : ldb < MAX(1, ld) ? 10 : ldc < MAX(1, ld) ? 13 : 0;
+    if(!gemm_blas_l3_check("cblas_ssymm", Order, bad))
+        return ;
+    cblas_ssymm_opt(gemm_blas_layout(Order), Side == CblasLeft ? SIDE_LEFT : SIDE_RIGHT,
+        Uplo == CblasLower ? UPLO_LOWER : UPLO_UPPER, M, N, alpha, A, lda, B, ldb, beta, C, ldc,
+        &gemm_blas_state()->ctx);
+}
+
+// strmm and strsm share the argument list
+static bool gemm_blas_tr_check(const char * name, int Order, int Side, int M, int N, int lda, int ldb){
+    int na = Side == CblasLeft ? M : N;
+    int ld = Order == CblasRowMajor ? N : M;
+    int bad = M < 0 ? 6 : N < 0 ? 7 : lda < MAX(1, na) ? 10 : ldb < MAX(1, ld) ? 12 : 0;
+    return gemm_blas_l3_check(name, Order, bad);
+}
+
+GEMM_BLAS_API
+void cblas_strmm(const enum CBLAS_ORDER Order, const enum CBLAS_SIDE Side,
+                const enum CBLAS_UPLO Uplo, const enum CBLAS_TRANSPOSE TransA,
+                const enum CBLAS_DIAG Diag, const int M, const int N,
+                const float alpha, const float *A, const int lda,
+                float *B, const int ldb)
+{
+    if(!gemm_blas_tr_check("cblas_strmm", Order, Side, M, N, lda, ldb))
+        return ;
+    cblas_strmm_opt(gemm_blas_layout(Order), Side == CblasLeft ? SIDE_LEFT : SIDE_RIGHT,
+        Uplo == CblasLower ? UPLO_LOWER : UPLO_UPPER, gemm_blas_trans(TransA),
+        Diag == CblasUnit ? DIAG_UNIT : DIAG_NON_UNIT, M, N, alpha, A, lda, B, ldb,
+        &gemm_blas_state()->ctx);
+}
+
+GEMM_BLAS_API
+void cblas_strsm(const enum CBLAS_ORDER Order, const enum CBLAS_SIDE Side,
+                const enum CBLAS_UPLO Uplo, const enum CBLAS_TRANSPOSE TransA,
+                const enum CBLAS_DIAG Diag, const int M, const int N,
+                const float alpha, const float *A, const int lda,
+                float *B, const int ldb)
+{
+    if(!gemm_blas_tr_check("cblas_strsm", Order, Side, M, N, lda, ldb))
+        return ;
+    cblas_strsm_opt(gemm_blas_layout(Order), Side == CblasLeft ? SIDE_LEFT : SIDE_RIGHT,
+        Uplo == CblasLower ? UPLO_LOWER : UPLO_UPPER, gemm_blas_trans(TransA),
+        Diag == CblasUnit ? DIAG_UNIT : DIAG_NON_UNIT, M, N, alpha, A, lda, B, ldb,
+        &gemm_blas_state()->ctx);
+}
@@ -0,0 +1,203 @@
+#include "gemm_cgemm.h"
+#include "gemm_opt.h"
+#include "kernel/sgemm_micro_kernel.h"
+
+#include <string.h>
+
+static inline bool cgemm_is_trans(trans_t t){
+    return t == TRANS_TRANS || t == TRANS_CONJ_TRANS;
+}
+
+static inline bool cgemm_is_conj(trans_t t){
+    return t == TRANS_CONJ_TRANS || t == TRANS_CONJ_NO_TRANS;
+}
+
+/*
+* A block of op(A), rows mm.., cols kk.. of size mc x kc. per mr panel:
+*   re panel  dest_re[k*mr + i] = vr,  dest_re[(kc+k)*mr + i] = -vi
+*   im panel  dest_im[k*mr + i] = vi,  dest_im[(kc+k)*mr + i] =  vr
+* v = alpha * (conj) a. panel stride 2*mr*kc
+*/
+static void cgemm_pack_a(int mc, int kc, const float * alpha, const float * A, int lda,
+    bool trans, bool conj, float * dest_re, float * dest_im, int mr)
+{
+    float ar = alpha[0];
+    float ai = alpha[1];
+    float sign = conj ? -1.f : 1.f;
+    for(int m=0; m<mc; m += mr){
+        int mr_size = MIN(mc-m, mr);
+        for(int k=0; k<kc; k++){
+            float * re0 = dest_re + k*mr;
+            float * re1 = dest_re + (kc+k)*mr;
+            float * im0 = dest_im + k*mr;
+            float * im1 = dest_im + (kc+k)*mr;
+            int i;
+            for(i=0; i<mr_size; i++){
+                const float * a = trans ? A + ((size_t)k*lda + m+i)*2 : A + ((size_t)(m+i)*lda + k)*2;
+                float xr = a[0];
+                float xi = sign*a[1];
+                float vr = ar*xr - ai*xi;
+                float vi = ar*xi + ai*xr;
+                re0[i] = vr;
+                re1[i] = -vi;
+                im0[i] = vi;
+                im1[i] = vr;
+            }
+            for(; i<mr; i++){
+                re0[i] = 0.f;   re1[i] = 0.f;
+                im0[i] = 0.f;   im1[i] = 0.f;
+            }
+        }
+        dest_re += 2*mr*kc;
+        dest_im += 2*mr*kc;
+    }
+}
+
+/*
+* B block of op(B), rows kk.., cols nn.. of size kc x nc. per nr panel:
+*   dest[k*nr + j] = br,  dest[(kc+k)*nr + j] = bi (negated if conj). panel stride 2*nr*kc
+*/
+static void cgemm_pack_b(int nc, int kc, const float * B, int ldb,
+    bool trans, bool conj, float * dest, int nr)
+{
+    float sign = conj ? -1.f : 1.f;
+    for(int n=0; n<nc; n += nr){
+        int nr_size = MIN(nc-n, nr);
+        for(int k=0; k<kc; k++){
+            float * re = dest + k*nr;
+            float * im = dest + (kc+k)*nr;
+            int j;
+            if(!trans){
+                const float * b = B + ((size_t)k*ldb + n)*2;
+                for(j=0; j<nr_size; j++){
+                    re[j] = b[2*j];
+                    im[j] = sign*b[2*j+1];
+                }
+            }else{
+                for(j=0; j<nr_size; j++){
+                    const float * b = B + ((size_t)(n+j)*ldb + k)*2;
+                    re[j] = b[0];
+                    im[j] = sign*b[1];
+                }
+            }
+            for(; j<nr; j++){
+                re[j] = 0.f;
+                im[j] = 0.f;
+            }
+        }
+        dest += 2*nr*kc;
+    }
+}
+
+// C = beta * C, interleaved
+static void cgemm_scale_c(int M, int N, const float * beta, float * C, int ldc){
+    float br = beta[0];
+    float bi = beta[1];
+    if(br == 1.f && bi == 0.f)
+        return;
+    for(int i=0; i<M; i++){
+        float * c = C + (size_t)i*ldc*2;
+        if(br == 0.f && bi == 0.f){
+            memset(c, 0, N*2*sizeof(float));
+            continue;
+        }
+        for(int j=0; j<N; j++){
+            float cr = c[2*j];
+            float ci = c[2*j+1];
+            c[2*j] = br*cr - bi*ci;
+            c[2*j+1] = br*ci + bi*cr;
+        }
+    }
+}
+
+static void cgemm_macro_kernel(int mc, int nc, int kc,
+    const float * pack_re, const float * pack_im, const float * packB,
+    float * C, int ldc, float * tile, const gemm_context_t * ctx)
+{
+    sgemm_micro_kernel_t micro_kernel = ctx->micro_kernel ? ctx->micro_kernel : sgemm_micro_kernel_n_tn;
+    int mr = ctx->mr;
+    int nr = ctx->nr;
+    int k2 = 2*kc;
+    float * tile_re = tile;
+    float * tile_im = tile + mr*nr;
+    for(int mm=0; mm<mc; mm += mr){
+        int mr_size = MIN(mc-mm, mr);
+        for(int nn=0; nn<nc; nn += nr){
+            int nr_size = MIN(nc-nn, nr);
+            memset(tile, 0, 2*mr*nr*sizeof(float));
+            micro_kernel(mr, nr, k2, 1.f, pack_re + mm*k2, packB + nn*k2, 1.f, tile_re, nr);
+            micro_kernel(mr, nr, k2, 1.f, pack_im + mm*k2, packB + nn*k2, 1.f, tile_im, nr);
+            for(int i=0; i<mr_size; i++){
+                float * c = C + ((size_t)(mm+i)*ldc + nn)*2;
+                const float * tr = tile_re + i*nr;
+                const float * ti = tile_im + i*nr;
+                for(int j=0; j<nr_size; j++){
+                    c[2*j] += tr[j];
+                    c[2*j+1] += ti[j];
+                }
+            }
+        }
+    }
+}
+
+void cblas_cgemm_opt(layout_t Layout, trans_t Trans_a, trans_t Trans_b,
+                int M, int N, int K,
+                const void *alpha,
+                const void *A, int lda,
+                const void *B, int ldb,
+                const void *beta,
+                void *C, int ldc,
+                const gemm_context_t * ctx)
+{
+    const float * al = (const float *)alpha;
+    float * Cf = (float *)C;
+    if(Layout == LAYOUT_COL_MAJOR){
+        // C^T = op(B)^T op(A)^T, conj stay with its operand
+        cblas_cgemm_opt(LAYOUT_ROW_MAJOR, Trans_b, Trans_a, N, M, K,
+            alpha, B, ldb, A, lda, beta, C, ldc, ctx);
+        return;
+    }
+    if(M <= 0 || N <= 0)
+        return;
+    cgemm_scale_c(M, N, (const float *)beta, Cf, ldc);
+    if(K <= 0 || (al[0] == 0.f && al[1] == 0.f))
+        return;
+
+    int mr = ctx->mr;
+    int nr = ctx->nr;
+    int mc = MAX((int)ctx->mc / 2 / mr * mr, mr);
+    int nc = CEIL_WRAP(ctx->nc, nr);
+    int kc = MAX((int)ctx->kc / 2, 1);
+    bool ta = cgemm_is_trans(Trans_a);
+    bool tb = cgemm_is_trans(Trans_b);
+    bool ca = cgemm_is_conj(Trans_a);
+    bool cb = cgemm_is_conj(Trans_b);
+    const float * Af = (const float *)A;
+    const float * Bf = (const float *)B;
+
+    size_t a_bytes = (size_t)mc*2*kc*sizeof(float);
+    size_t b_bytes = (size_t)nc*2*kc*sizeof(float);
+    float * pack_re = sgemm_alloc_pack(a_bytes, ctx);
+    float * pack_im = sgemm_alloc_pack(a_bytes, ctx);
+    float * packB = sgemm_alloc_pack(b_bytes, ctx);
+    std::vector<float> tile(2*mr*nr);
+
+    for(int mm=0; mm<M; mm += mc){
+        int mc_size = MIN(M-mm, mc);
+        for(int kk=0; kk<K; kk += kc){
+            int kc_size = MIN(K-kk, kc);
+            const float * a = ta ? Af + ((size_t)kk*lda + mm)*2 : Af + ((size_t)mm*lda + kk)*2;
+            cgemm_pack_a(mc_size, kc_size, al, a, lda, ta, ca, pack_re, pack_im, mr);
+            for(int nn=0; nn<N; nn += nc){
+                int nc_size = MIN(N-nn, nc);
+                const float * b = tb ? Bf + ((size_t)nn*ldb + kk)*2 : Bf + ((size_t)kk*ldb + nn)*2;
+                cgemm_pack_b(nc_size, kc_size, b, ldb, tb, cb, packB, nr);
+                cgemm_macro_kernel(mc_size, nc_size, kc_size, pack_re, pack_im, packB,
+                    Cf + ((size_t)mm*ldc + nn)*2, ldc, tile.data(), ctx);
+            }
+        }
+    }
+    sgemm_free_pack(pack_re, a_bytes, ctx);
+    sgemm_free_pack(pack_im, a_bytes, ctx);
+    sgemm_free_pack(packB, b_bytes, ctx);
+}
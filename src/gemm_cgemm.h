@@ -0,0 +1,31 @@
+#ifndef __GEMM_CGEMM_H
+#define __GEMM_CGEMM_H
+
+#include "gemm_driver.h"
+
+/*
+* complex single precision gemm, interleaved (re, im) like cblas_cgemm. 4m induced on the
+* real micro kernel: with op(A) pre-multiplied by alpha into v,
+*   Cr += vr*br - vi*bi = [vr, -vi] . [br; bi]
+*   Ci += vi*br + vr*bi = [vi,  vr] . [br; bi]
+* so A is packed into two mr panels of 2*kc (real row, imag row) and B into one nr panel
+* of 2*kc (br stacked over bi). every C tile is 2 micro kernel calls of k=2*kc into a
+* mr*nr re/im temp, then added into the interleaved C. no flop is wasted (8MNK).
+* transpose and conjugate of A/B (TRANS_TRANS, TRANS_CONJ_TRANS, TRANS_CONJ_NO_TRANS) are
+* done by the packers. panels are zero filled past the edge, so any M/N/K is allowed.
+*
+* blocking from ctx: complex kc is ctx->kc/2 and mc is ctx->mc/2, so a packed complex
+* block take the same bytes as the real one it was tuned for. single thread.
+*/
+
+// alpha/beta point to 2 float (re, im), A/B/C to interleaved complex, ld in complex element
+void cblas_cgemm_opt(layout_t Layout, trans_t Trans_a, trans_t Trans_b,
+                int M, int N, int K,
+                const void *alpha,
+                const void *A, int lda,
+                const void *B, int ldb,
+                const void *beta,
+                void *C, int ldc,
+                const gemm_context_t * ctx);
+
+#endif
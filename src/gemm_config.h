@@ -18,6 +18,14 @@
 #define PAGE_SIZE 4096  // 4k page, for most OS/arch
 #define CACHELINE_SIZE 64 // 64 byte cache line
 #define L1D_TLB_ENTRY 64
+#define L1D_TLB_ENTRY_HUGE 32   // 2M/4M page entries of l1d tlb (skylake)
+
+#define NT_STORE_C_L3_RATIO 4   // streaming store C only if C is bigger than this times L3
+#define C_ACC_L2_RATIO 2        // packed C accumulator of c_acc mode take at most 1/this of L2
+#define PACK_TLS_BYTES (256*1024)  // pack workspace up to this is a per thread buffer reused by every call
+#define SCRATCH_TLS_BYTES (16*1024*1024)    // call scratch (transposed operand, padded edge) up to this is kept per thread
+#define STEAL_TASKS_PER_THREAD 4    // work stealing shrink the C macro tile until this many per thread
+#define MT_MIN_MNK (128*128*128)    // below this M*N*K thread start cost more than the gemm, run single thread
 
 
 #endif
\ No newline at end of file
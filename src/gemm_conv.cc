@@ -0,0 +1,247 @@
+#include "gemm_conv.h"
+#include "gemm_opt.h"
+#include "kernel/sgemm_micro_kernel.h"
+
+#include <string.h>
+
+/*
+* k of the gemm view decoded once per call, so the gather loops only add offsets:
+*   NCHW  k = (c*kh + r)*kw + s,  tap offset in the input image c*H*W + r*dh*W + s*dw
+*   NHWC  k = (r*kw + s)*ic + c,  tap offset (r*dh*W + s*dw)*ic + c
+* and for every output pixel the top-left input coordinate iy0 = oy*sh - ph, ix0 = ox*sw - pw.
+* a tap is in the image if 0 <= iy0 + r*dh < H and 0 <= ix0 + s*dw < W.
+*/
+struct conv_tables_t {
+    std::vector<int>    k_dy;       // r*dh
+    std::vector<int>    k_dx;       // s*dw
+    std::vector<int>    k_c;        // input channel
+    std::vector<int>    pix_iy0;
+    std::vector<int>    pix_ix0;
+};
+
+static void conv_build_tables(const conv_param_t * p, conv_tables_t & t){
+    int K = p->gemm_k();
+    int oh = p->out_h();
+    int ow = p->out_w();
+    t.k_dy.resize(K);
+    t.k_dx.resize(K);
+    t.k_c.resize(K);
+    for(int k=0; k<K; k++){
+        int c, r, s;
+        if(p->layout == CONV_LAYOUT_NCHW){
+            c = k / (p->kernel_h*p->kernel_w);
+            r = (k / p->kernel_w) % p->kernel_h;
+            s = k % p->kernel_w;
+        }else{
+            r = k / (p->kernel_w*p->in_c);
+            s = (k / p->in_c) % p->kernel_w;
+            c = k % p->in_c;
+        }
+        t.k_dy[k] = r*p->dilation_h;
+        t.k_dx[k] = s*p->dilation_w;
+        t.k_c[k] = c;
+    }
+    t.pix_iy0.resize(oh*ow);
+    t.pix_ix0.resize(oh*ow);
+    for(int y=0; y<oh; y++){
+        for(int x=0; x<ow; x++){
+            t.pix_iy0[y*ow + x] = y*p->stride_h - p->pad_h;
+            t.pix_ix0[y*ow + x] = x*p->stride_w - p->pad_w;
+        }
+    }
+}
+
+// dense A rows (OIHW weight), panel always mr wide, zero past mc
+static void conv_pack_a_dense(int mc, int kc, const float * src, int ld, float * dest, int mr){
+    for(int m=0; m<mc; m += mr){
+        int mr_size = MIN(mc-m, mr);
+        for(int k=0; k<kc; k++){
+            int i;
+            for(i=0; i<mr_size; i++)
+                dest[k*mr + i] = src[(m+i)*ld + k];
+            for(; i<mr; i++)
+                dest[k*mr + i] = 0.f;
+        }
+        dest += mr*kc;
+    }
+}
+
+// dense B rows (HWIO weight), panel always nr wide, zero past nc
+static void conv_pack_b_dense(int nc, int kc, const float * src, int ld, float * dest, int nr){
+    for(int n=0; n<nc; n += nr){
+        int nr_size = MIN(nc-n, nr);
+        for(int k=0; k<kc; k++){
+            const float * s = src + k*ld + n;
+            float * d = dest + k*nr;
+            if(nr_size == nr){
+                memcpy(d, s, nr*sizeof(float));
+            }else{
+                memcpy(d, s, nr_size*sizeof(float));
+                memset(d + nr_size, 0, (nr-nr_size)*sizeof(float));
+            }
+        }
+        dest += nr*kc;
+    }
+}
+
+// NCHW patch, rows kk..kk+kc of k, cols nn..nn+nc of output pixel, as B panels
+static void conv_pack_b_nchw(const conv_param_t * p, const conv_tables_t & t, const float * img,
+    int kk, int kc, int nn, int nc, float * dest, int nr)
+{
+    int H = p->in_h;
+    int W = p->in_w;
+    int plane = H*W;
+    for(int n=nn; n<nn+nc; n += nr){
+        int nr_size = MIN(nn+nc-n, nr);
+        const int * iy0 = &t.pix_iy0[n];
+        const int * ix0 = &t.pix_ix0[n];
+        // whole panel on one output row with unit stride, a tap is one contiguous run
+        bool run = nr_size == nr && p->stride_w == 1 && iy0[0] == iy0[nr-1];
+        for(int k=kk; k<kk+kc; k++){
+            float * d = dest + (k-kk)*nr;
+            const float * src = img + t.k_c[k]*plane;
+            int dy = t.k_dy[k];
+            int dx = t.k_dx[k];
+            if(run){
+                int iy = iy0[0] + dy;
+                int ix = ix0[0] + dx;
+                if(iy >= 0 && iy < H && ix >= 0 && ix + nr <= W){
+                    memcpy(d, src + iy*W + ix, nr*sizeof(float));
+                    continue;
+                }
+            }
+            int j;
+            for(j=0; j<nr_size; j++){
+                int iy = iy0[j] + dy;
+                int ix = ix0[j] + dx;
+                d[j] = ((unsigned)iy < (unsigned)H && (unsigned)ix < (unsigned)W) ? src[iy*W + ix] : 0.f;
+            }
+            for(; j<nr; j++)
+                d[j] = 0.f;
+        }
+        dest += nr*kc;
+    }
+}
+
+// NHWC patch, rows mm..mm+mc of output pixel, cols kk..kk+kc of k, as A panels
+static void conv_pack_a_nhwc(const conv_param_t * p, const conv_tables_t & t, const float * img,
+    int mm, int mc, int kk, int kc, float * dest, int mr)
+{
+    int H = p->in_h;
+    int W = p->in_w;
+    int C = p->in_c;
+    for(int m=mm; m<mm+mc; m += mr){
+        int mr_size = MIN(mm+mc-m, mr);
+        for(int i=0; i<mr; i++){
+            if(i >= mr_size){
+                for(int k=0; k<kc; k++)
+                    dest[k*mr + i] = 0.f;
+                continue;
+            }
+            int iy0 = t.pix_iy0[m+i];
+            int ix0 = t.pix_ix0[m+i];
+            // one tap (r, s) is a run of channels, contiguous in the input
+            for(int k=kk; k<kk+kc; ){
+                int c = t.k_c[k];
+                int len = MIN(C - c, kk+kc - k);
+                int iy = iy0 + t.k_dy[k];
+                int ix = ix0 + t.k_dx[k];
+                float * d = dest + (k-kk)*mr + i;
+                if((unsigned)iy < (unsigned)H && (unsigned)ix < (unsigned)W){
+                    const float * src = img + (iy*W + ix)*C + c;
+                    for(int e=0; e<len; e++)
+                        d[e*mr] = src[e];
+                }else{
+                    for(int e=0; e<len; e++)
+                        d[e*mr] = 0.f;
+                }
+                k += len;
+            }
+        }
+        dest += mr*kc;
+    }
+}
+
+// full tile straight into C, edge tile through a temp
+static void conv_macro_kernel(int mc, int nc, int kc,
+    const float * packA, const float * packB, float * C, int ldc,
+    float * tile, const gemm_context_t * ctx)
+{
+    sgemm_micro_kernel_t micro_kernel = ctx->micro_kernel ? ctx->micro_kernel : sgemm_micro_kernel_n_tn;
+    int mr = ctx->mr;
+    int nr = ctx->nr;
+    for(int mm=0; mm<mc; mm += mr){
+        int mr_size = MIN(mc-mm, mr);
+        for(int nn=0; nn<nc; nn += nr){
+            int nr_size = MIN(nc-nn, nr);
+            float * c = C + mm*ldc + nn;
+            if(mr_size == mr && nr_size == nr){
+                micro_kernel(mr, nr, kc, 1.f, packA + mm*kc, packB + nn*kc, 1.f, c, ldc);
+                continue;
+            }
+            memset(tile, 0, mr*nr*sizeof(float));
+            micro_kernel(mr, nr, kc, 1.f, packA + mm*kc, packB + nn*kc, 1.f, tile, nr);
+            for(int i=0; i<mr_size; i++)
+                for(int j=0; j<nr_size; j++)
+                    c[i*ldc + j] += tile[i*nr + j];
+        }
+    }
+}
+
+void sconv_implicit_gemm(const conv_param_t * param,
+                const float * input,
+                const float * weight,
+                float * output,
+                const gemm_context_t * ctx)
+{
+    const conv_param_t * p = param;
+    int oh = p->out_h();
+    int ow = p->out_w();
+    if(oh <= 0 || ow <= 0 || p->out_c <= 0)
+        return;
+    bool nchw = p->layout == CONV_LAYOUT_NCHW;
+    int K = p->gemm_k();
+    int M = nchw ? p->out_c : oh*ow;
+    int N = nchw ? oh*ow : p->out_c;
+    int mr = ctx->mr;
+    int nr = ctx->nr;
+    int mc = CEIL_WRAP(ctx->mc, mr);
+    int nc = CEIL_WRAP(ctx->nc, nr);
+    int kc = ctx->kc;
+    size_t in_size = (size_t)p->in_c*p->in_h*p->in_w;
+    size_t out_size = (size_t)p->out_c*oh*ow;
+
+    conv_tables_t t;
+    conv_build_tables(p, t);
+    float * A_pack = sgemm_alloc_pack(mc*kc*sizeof(float), ctx);
+    float * B_pack = sgemm_alloc_pack(nc*kc*sizeof(float), ctx);
+    std::vector<float> tile(mr*nr);
+
+    for(int b=0; b<p->batch; b++){
+        const float * img = input + b*in_size;
+        float * C = output + b*out_size;
+        for(int mm=0; mm<M; mm += mc){
+            int mc_size = MIN(M-mm, mc);
+            for(int kk=0; kk<K; kk += kc){
+                int kc_size = MIN(K-kk, kc);
+                if(nchw)
+                    conv_pack_a_dense(mc_size, kc_size, weight + mm*K + kk, K, A_pack, mr);
+                else
+                    conv_pack_a_nhwc(p, t, img, mm, mc_size, kk, kc_size, A_pack, mr);
+                for(int nn=0; nn<N; nn += nc){
+                    int nc_size = MIN(N-nn, nc);
+                    if(nchw)
+                        conv_pack_b_nchw(p, t, img, kk, kc_size, nn, nc_size, B_pack, nr);
+                    else
+                        conv_pack_b_dense(nc_size, kc_size, weight + kk*N + nn, N, B_pack, nr);
+                    if(kk == 0)
+                        scale_C(mc_size, nc_size, 0.f, C + mm*N + nn, N);
+                    conv_macro_kernel(mc_size, nc_size, kc_size, A_pack, B_pack,
+                        C + mm*N + nn, N, tile.data(), ctx);
+                }
+            }
+        }
+    }
+    sgemm_free_pack(A_pack, mc*kc*sizeof(float), ctx);
+    sgemm_free_pack(B_pack, nc*kc*sizeof(float), ctx);
+}
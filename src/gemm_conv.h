@@ -0,0 +1,54 @@
+#ifndef __GEMM_CONV_H
+#define __GEMM_CONV_H
+
+#include "gemm_driver.h"
+
+/*
+* implicit gemm convolution, no im2col buffer. per image the conv is one gemm whose
+* patch operand is gathered from the input tensor straight into packed panels:
+*
+*   NCHW  out[oc][oh*ow]    = W[oc][ic*kh*kw] * patch[ic*kh*kw][oh*ow]
+*         weight OIHW, patch is B, gathered kc x nr by the B packer
+*   NHWC  out[oh*ow][oc]    = patch[oh*ow][kh*kw*ic] * W[kh*kw*ic][oc]
+*         weight HWIO, patch is A, gathered mr x kc by the A packer (ic run is contiguous)
+*
+* panels are always mr/nr wide (zero filled past the edge), so any oc/oh/ow use the
+* same micro kernel, edge tiles go through a mr*nr temp. out of image taps read as 0.
+* output is overwritten (no alpha/beta), single thread, blocking mc/nc/kc of ctx.
+*/
+typedef enum {
+    CONV_LAYOUT_NCHW = 0,
+    CONV_LAYOUT_NHWC
+}conv_layout_t;
+
+static inline const char * to_conv_layout_str(conv_layout_t layout){
+    if(layout == CONV_LAYOUT_NCHW)
+        return "nchw";
+    if(layout == CONV_LAYOUT_NHWC)
+        return "nhwc";
+    return "n/a layout";
+}
+
+struct conv_param_t {
+    conv_layout_t   layout {CONV_LAYOUT_NCHW};
+    int     batch {1};
+    int     in_c, in_h, in_w;
+    int     out_c;
+    int     kernel_h, kernel_w;
+    int     stride_h {1}, stride_w {1};
+    int     pad_h {0}, pad_w {0};
+    int     dilation_h {1}, dilation_w {1};
+
+    int out_h() const { return (in_h + 2*pad_h - dilation_h*(kernel_h-1) - 1) / stride_h + 1; }
+    int out_w() const { return (in_w + 2*pad_w - dilation_w*(kernel_w-1) - 1) / stride_w + 1; }
+    // gemm view of one image
+    int gemm_k() const { return in_c*kernel_h*kernel_w; }
+};
+
+void sconv_implicit_gemm(const conv_param_t * param,
+                const float * input,
+                const float * weight,
+                float * output,
+                const gemm_context_t * ctx);
+
+#endif
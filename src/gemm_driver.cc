@@ -1,7 +1,20 @@
 #include "gemm_driver.h"
 #include "gemm_config.h"
+#include "gemm_opt.h"
+#include "topology.h"
+#include "bench_suite.h"
+#include "freq.h"
+#include "gemm_plan.h"
+#include "gemm_strassen.h"
+#include "gemm_conv.h"
+#include "gemm_cgemm.h"
+#include "gemm_level3.h"
+#include "gemm_autotune.h"
+#include "gemm_ooc.h"
+#include "kernel/sgemm_pack.h"
 #include <stdio.h>
 #include <assert.h>
+#include <math.h>
 #include <iostream>
 #include <unistd.h>
 #include <string>
@@ -9,6 +22,12 @@
 #include <unordered_map>
 #include <functional>
 #include <fstream>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <sys/resource.h>
+#include <fcntl.h>
 
 template<typename T>
 bool valid_matrix(const matrix_t<T> * lhs, const matrix_t<T> * rhs, double delta){
@@ -29,16 +48,6 @@ bool valid_matrix(const matrix_t<T> * lhs, const matrix_t<T> * rhs, double delta
     return errs==0;
 }
 
-// the last parameter is added only for convenience
-extern void cblas_sgemm_opt(layout_t Layout, trans_t Trans_a, trans_t Trans_b,
-                int M, int N, int K,
-                float alpha,
-                const float *A, int lda,
-                const float *B, int ldb,
-                float beta,
-                float *C, int ldc,
-                const gemm_context_t * ctx);
-
 typedef decltype(&cblas_sgemm) cblas_sgemm_t;
 //typedef decltype(&cblas_sgemm_opt) cblas_sgemm_opt_t;
 typedef std::function<void(layout_t Layout, trans_t Trans_a, trans_t Trans_b,
@@ -52,24 +61,40 @@ typedef std::function<void(layout_t Layout, trans_t Trans_a, trans_t Trans_b,
             > cblas_sgemm_opt_t;
 // use std::function instead of func pointer type, can let lambda capture work
 
-#define INTEL_AVX2
-
 template<typename T>
 class peak_gflops_t{
 public:
     typedef T dtype;
-    double operator() (double freq_mhz){
+    double operator() (double freq_mhz, sgemm_isa_t isa){
         return 0;
     }
+    static const char * str(sgemm_isa_t isa){
+        return "n/a";
+    }
 };
 
+// peak of the tier the micro kernel is built for, not what the cpu can do.
+// all tiers assume 2 fp port, sse/avx issue mul and add on separate port
 template<>
 class peak_gflops_t<float>{
 public:
-    double operator() (double freq_mhz){
-#ifdef INTEL_AVX2
-    return 2/*2 port*/*8/*fp32 for 256 bit*/*2/*fma*/*freq_mhz/1024.0;
-#endif
+    double operator() (double freq_mhz, sgemm_isa_t isa){
+        return flop_per_cycle(isa)*freq_mhz/1000.0;
+    }
+    static int flop_per_cycle(sgemm_isa_t isa){
+        int lanes = sgemm_isa_vector_bytes(isa) / sizeof(float);
+        if(isa == SGEMM_ISA_SSE42 || isa == SGEMM_ISA_AVX)
+            return lanes/*1 mul + 1 add*/*2;
+        return 2/*2 port*/*lanes*2/*fma*/;
+    }
+    static const char * str(sgemm_isa_t isa){
+        if(isa == SGEMM_ISA_SSE42)
+            return "sse128,mul+add";
+        if(isa == SGEMM_ISA_AVX)
+            return "avx256,mul+add";
+        if(isa == SGEMM_ISA_AVX512)
+            return "avx512,fmadd";
+        return "avx256,fmadd";
     }
 };
 
@@ -202,6 +227,10 @@ struct bench_result{
     double          gflops;
     double          time_ms;    // cost for 1 loop
     double          perf;       // percentage
+    double          freq_mhz {0};   // core clock during the timed loops
+    double          roof_perf {0};  // percentage of roofline
+    sgemm_ws_stats_t ws;            // pack workspace of the last call, 0 if not through sgemm_ws_alloc()
+    double          minflt {0};     // minor page fault per call
     matrix_t<T>   * c {nullptr};
     bench_result(){}
     bench_result(int loops_, double gflops_, double time_ms_, double perf_, matrix_t<T> * c_):
@@ -211,6 +240,10 @@ struct bench_result{
         gflops = rhs.gflops;
         time_ms = rhs.time_ms;
         perf = rhs.perf;
+        freq_mhz = rhs.freq_mhz;
+        roof_perf = rhs.roof_perf;
+        ws = rhs.ws;
+        minflt = rhs.minflt;
         c = rhs.c;
         rhs.c = nullptr;
     }
@@ -225,13 +258,43 @@ struct bench_result{
         gflops = rhs.gflops;
         time_ms = rhs.time_ms;
         perf = rhs.perf;
+        freq_mhz = rhs.freq_mhz;
+        roof_perf = rhs.roof_perf;
+        ws = rhs.ws;
+        minflt = rhs.minflt;
         return *this;
     }
 };
 
+// peak of all threads at freq_mhz
+template<typename T>
+static double bench_peak_gflops(const gemm_context_t * ctx, double freq_mhz){
+    return peak_gflops_t<T>()(freq_mhz, ctx->kernel_isa()) * ctx->num_threads();
+}
+
+/*
+* roofline of the shape, min(compute peak, flop/byte * dram bandwidth). byte is the
+* compulsory traffic, A, B, C write, and C read if beta != 0. peak if mem_bw not probed
+*/
+template<typename T>
+static double bench_roofline_gflops(const gemm_context_t * ctx, double peak){
+    if(ctx->mem_bw <= 0)
+        return peak;
+    double flop = (double)sgemm_flop(ctx->m,ctx->n,ctx->k,ctx->alpha,ctx->beta);
+    double bytes = (double)sizeof(T)*(ctx->m*ctx->k + ctx->k*ctx->n + (ctx->beta != 0 ? 2:1)*ctx->m*ctx->n);
+    return MIN(peak, flop/bytes*ctx->mem_bw);
+}
+
+static inline int bench_cpu(const gemm_context_t * ctx){
+    return ctx->cpu_list.empty() ? get_current_cpu() : ctx->cpu_list[0];
+}
+
 #define LOOPS 6
 #define LOOP_WARMUP 3
 
+// max operand sets of rotating cache mode, bound memory for small problem
+#define ROTATING_MAX_SETS 64
+
 template <typename T>
 class gemm_problem_t{
 public:
@@ -241,15 +304,76 @@ public:
 
         A = new matrix_t<T>(ctx->m, ctx->k, ctx->lda, ctx->layout, ctx->trans_a, ctx->alignment);
         B = new matrix_t<T>(ctx->k, ctx->n, ctx->ldb, ctx->layout, ctx->trans_b, ctx->alignment);
-        C = new matrix_t<T>(ctx->m, ctx->n, ctx->ldc, ctx->layout, TRANS_NO_TRANS, ctx->alignment);
+        C = new matrix_t<T>(ctx->m, ctx->n, ctx->ldc, ctx->layout, TRANS_NO_TRANS, ctx->alignment, ctx->c_offset);
 
         loops = LOOPS;
         loop_warmup = LOOP_WARMUP;
+
+        if(ctx->bench_cache == BENCH_CACHE_ROTATING){
+            // set 0 is A/B and the C copy of each run, others are extra. 2x L3 so the
+            // set of last loop is evicted by the time it come around again
+            size_t sets = CEIL(2*ctx->l3_size, operand_bytes());
+            sets = MIN(MAX(sets, (size_t)2), (size_t)ROTATING_MAX_SETS);
+            for(size_t i=1;i<sets;i++){
+                rot_A.push_back(new matrix_t<T>(*A));
+                rot_B.push_back(new matrix_t<T>(*B));
+                rot_C.push_back(new matrix_t<T>(*C));
+            }
+        }
     }
     ~gemm_problem_t(){
         delete A;
         delete B;
         delete C;
+        for(size_t i=0;i<rot_A.size();i++){
+            delete rot_A[i];
+            delete rot_B[i];
+            delete rot_C[i];
+        }
+    }
+
+    size_t operand_bytes() const {
+        return matrix_bytes(A) + matrix_bytes(B) + matrix_bytes(C);
+    }
+    size_t operand_sets() const {
+        return rot_A.size() + 1;
+    }
+
+    /*
+    * run gemm_func for loops under ctx->bench_cache, return seconds spent in gemm_func.
+    * warm/rotating time the loops as a whole. cold flush A/B/C then time each call
+    * alone, so the flush is not counted
+    */
+    double run_loops(cblas_sgemm_opt_t gemm_func, int loops_, T * c_data){
+        auto call = [&](size_t set){
+            const T * a = set ? rot_A[set-1]->data : A->data;
+            const T * b = set ? rot_B[set-1]->data : B->data;
+            T * c = set ? rot_C[set-1]->data : c_data;
+            gemm_func(ctx->layout,ctx->trans_a,ctx->trans_b,
+                ctx->m,ctx->n,ctx->k,
+                ctx->alpha,
+                a,ctx->lda,
+                b,ctx->ldb,
+                ctx->beta,
+                c, ctx->ldc, ctx);
+        };
+        if(ctx->bench_cache == BENCH_CACHE_COLD){
+            double cost = 0;
+            for(int i=0;i<loops_;i++){
+                cache_flush(A->data, matrix_bytes(A), ctx->cacheline_size);
+                cache_flush(B->data, matrix_bytes(B), ctx->cacheline_size);
+                cache_flush(c_data, matrix_bytes(C), ctx->cacheline_size);
+                double start_time = current_sec();
+                call(0);
+                cost += current_sec() - start_time;
+            }
+            return cost;
+        }
+        size_t sets = operand_sets();
+        double start_time = current_sec();
+        for(int i=0;i<loops_;i++)
+            call(i % sets);
+        return current_sec() - start_time;
     }
 
     bench_result<T> run_single_case(cblas_sgemm_opt_t gemm_func, bool validate_only){
@@ -271,7 +395,6 @@ public:
             return bench_result<T>(0,0,0,0,c_out);
         }
 
-        int i;
         int l_warmup = this->loop_warmup;
         int l_loop = this->loops;
         // some speed up and stability modify
@@ -290,36 +413,39 @@ public:
             l_warmup = 2;
             l_loop = 4;
         }
-        for(i=0;i<l_warmup;i++){
-            gemm_func(ctx->layout,ctx->trans_a,ctx->trans_b,
-                ctx->m,ctx->n,ctx->k,
-                ctx->alpha,
-                A->data,ctx->lda,
-                B->data,ctx->ldb,
-                ctx->beta,
-                c_out->data, ctx->ldc, ctx);
-        }
-        double start_time = current_sec();
-        for(i=0;i<l_loop;i++){
-            gemm_func(ctx->layout,ctx->trans_a,ctx->trans_b,
-                ctx->m,ctx->n,ctx->k,
-                ctx->alpha,
-                A->data,ctx->lda,
-                B->data,ctx->ldb,
-                ctx->beta,
-                c_out->data, ctx->ldc, ctx);
-        }
-        double cost_per_loop = (current_sec()-start_time) / l_loop;
+        // every set is touched once per round, warm up the page/tlb of all of them
+        if(ctx->bench_cache == BENCH_CACHE_ROTATING)
+            l_warmup = MAX(l_warmup, (int)operand_sets());
+        run_loops(gemm_func, l_warmup, c_out->data);
+        freq_meter_t freq_meter(bench_cpu(ctx), ctx->kernel_isa());
+        sgemm_ws_reset();
+        struct rusage ru0, ru1;
+        getrusage(RUSAGE_SELF, &ru0);
+        freq_meter.start();
+        double cost_per_loop = run_loops(gemm_func, l_loop, c_out->data) / l_loop;
+        double freq_mhz = ctx->freq_measure ? freq_meter.stop() : ctx->frequency;
+        getrusage(RUSAGE_SELF, &ru1);
+        if(freq_mhz <= 0)
+            freq_mhz = ctx->frequency;
         unsigned long long flop = sgemm_flop(ctx->m,ctx->n,ctx->k,ctx->alpha,ctx->beta);
         double gflops = (double)flop/(cost_per_loop *1e9);
-        double gflops_theory = peak_gflops_t<T>()(ctx->frequency);
+        double gflops_theory = bench_peak_gflops<T>(ctx, freq_mhz);
+        double gflops_roof = bench_roofline_gflops<T>(ctx, gflops_theory);
         delete c_out;
         //return std::move(bench_result(LOOPS, gflops, cost_per_loop*1e3, gflops/gflops_theory*100, nullptr));
-        return bench_result<T>(l_loop, gflops, cost_per_loop*1e3, gflops/gflops_theory*100, nullptr);
+        bench_result<T> r(l_loop, gflops, cost_per_loop*1e3, gflops/gflops_theory*100, nullptr);
+        r.freq_mhz = freq_mhz;
+        r.roof_perf = gflops/gflops_roof*100;
+        r.ws = sgemm_ws_last();
+        r.minflt = (double)(ru1.ru_minflt - ru0.ru_minflt) / l_loop;
+        return r;
     }
     // used for cblas api call
     bench_result<T> run_single_case(cblas_sgemm_t cblas_gemm_func, bool validate_only){
-        auto gemm_func_wrapper = [&](layout_t _layout, trans_t _trans_a, trans_t _trans_b,
+        return run_single_case(cblas_wrapper(cblas_gemm_func), validate_only);
+    }
+    static cblas_sgemm_opt_t cblas_wrapper(cblas_sgemm_t cblas_gemm_func){
+        return [=](layout_t _layout, trans_t _trans_a, trans_t _trans_b,
             int _m, int _n, int _k,
             const float _alpha,
             const float * _A, int _lda,
@@ -332,18 +458,49 @@ public:
             cblas_gemm_func(to_blas_layout(_layout),to_blas_transpose(_trans_a),to_blas_transpose(_trans_b),
                 _m,_n,_k,_alpha,_A,_lda,_B,_ldb,_beta,_C,_ldc);
         };
-        return run_single_case(gemm_func_wrapper, validate_only);
+    }
+    // sgemm_strassen with a cutoff, else cblas_sgemm_opt, or with ctx->plan a plan created here once for the ctx problem,
+    // then every call only execute it. fall back to cblas_sgemm_opt if it can't be planned
+    static cblas_sgemm_opt_t opt_wrapper(const gemm_context_t * ctx){
+        if(ctx->strassen_cutoff)
+            return sgemm_strassen;
+        if(!ctx->plan)
+            return cblas_sgemm_opt;
+        std::shared_ptr<sgemm_plan_t> plan(sgemm_plan_create(ctx->layout, ctx->trans_a, ctx->trans_b,
+                    ctx->m, ctx->n, ctx->k, ctx->lda, ctx->ldb, ctx->ldc, ctx), sgemm_plan_destroy);
+        if(!plan)
+            return cblas_sgemm_opt;
+        return [plan](layout_t _layout, trans_t _trans_a, trans_t _trans_b,
+            int _m, int _n, int _k,
+            const float _alpha,
+            const float * _A, int _lda,
+            const float * _B, int _ldb,
+            const float _beta,
+            float * _C, int _ldc,
+            const gemm_context_t * ctx) -> void
+        {
+            sgemm_plan_execute(plan.get(), _alpha, _A, _B, _beta, _C);
+        };
     }
 
 //private:
     matrix_t<T> *A;   // M*N
     matrix_t<T> *B;   // N*K
     matrix_t<T> *C;   // M*N
+    // extra operand sets of BENCH_CACHE_ROTATING
+    std::vector<matrix_t<T> *> rot_A;
+    std::vector<matrix_t<T> *> rot_B;
+    std::vector<matrix_t<T> *> rot_C;
 
     gemm_context_t * ctx;   // not own this
 
     int loop_warmup;
     int loops;
+
+private:
+    static size_t matrix_bytes(const matrix_t<T> * mat){
+        return sizeof(T)*matrix_elem_t()(mat->row, mat->col, mat->ldim, mat->layout, mat->trans);
+    }
 };
 
 
@@ -387,10 +544,20 @@ public:
         size_t mc;
         size_t nc;
         size_t kc;
-        size_t mr;  // TODO
+        size_t mr;
         size_t nr;
+        bool   jit {false};     // jit kernel, mr/nr are also in jit_cfg
+        sgemm_jit_config_t jit_cfg;
+        const sgemm_kernel_desc_t * kernel_desc {nullptr};  // registered kernel, not in db
 
+        // "mc|nc|kc|mr|nr", or "mc|nc|kc|mr|nr|unroll|prefetch|isa" if jit
         void serialize(std::ostream & os){
+            if(jit){
+                std::string kernel_str;
+                jit_cfg.serialize(kernel_str);
+                os<<mc<<"|"<<nc<<"|"<<kc<<"|"<<kernel_str;
+                return ;
+            }
             os<<mc<<"|"<<nc<<"|"<<kc<<"|"<<mr<<"|"<<nr;
         }
         void serialize(std::string & str){
@@ -400,7 +567,16 @@ public:
         }
         void deserialize(std::istream & is){
             unsigned char _d;
-            is>>mc>>_d>>nc>>_d>>kc>>_d>>mr>>_d>>nr;
+            std::string kernel_str;
+            is>>mc>>_d>>nc>>_d>>kc>>_d>>kernel_str;
+            jit = jit_cfg.deserialize(kernel_str);
+            if(jit){
+                mr = jit_cfg.mr;
+                nr = jit_cfg.nr;
+            }else{
+                std::istringstream iss(kernel_str);
+                iss>>mr>>_d>>nr;
+            }
         }
         void deserialize(std::string & str){
             std::istringstream iss;
@@ -457,20 +633,52 @@ public:
             blocking_param bp;
             bp.deserialize(value);
 
-            ctx->mc = bp.mc;
-            ctx->nc = bp.nc;
-            ctx->kc = bp.kc;
-            //std::cout<<"    update param for "<<key<<std::endl;
-            ctx->cur_use_tuned = true;
-        }else{
-            //std::cout<<"    no param update for "<<key<<std::endl;
-            ctx->mc = default_bp.mc;
-            ctx->nc = default_bp.nc;
-            ctx->kc = default_bp.kc;
+            // as gemm_blas_apply_tuned(), a row tuned for an other tile than the kernel in use
+            // (or a jit kernel this host can't run) is not taken
+            bool match;
+            if(bp.jit){
+                match = sgemm_set_jit_kernel(ctx, &bp.jit_cfg);
+            }else{
+                apply_kernel(ctx, default_bp);
+                match = bp.mr == ctx->mr && bp.nr == ctx->nr;
+            }
+            if(match && bp.mc && bp.nc && bp.kc){
+                ctx->mc = CEIL_WRAP(bp.mc, ctx->mr);
+                ctx->nc = CEIL_WRAP(bp.nc, ctx->nr);
+                ctx->kc = bp.kc;
+                //std::cout<<"    update param for "<<key<<std::endl;
+                ctx->cur_use_tuned = true;
+                return ;
+            }
         }
+        //std::cout<<"    no param update for "<<key<<std::endl;
+        ctx->mc = default_bp.mc;
+        ctx->nc = default_bp.nc;
+        ctx->kc = default_bp.kc;
+        apply_kernel(ctx, default_bp);
+    }
+    void apply_kernel(gemm_context_t *ctx, const blocking_param & bp){
+        if(bp.jit)
+            sgemm_set_jit_kernel(ctx, &bp.jit_cfg);
+        else if(bp.kernel_desc)
+            sgemm_set_kernel(ctx, bp.kernel_desc);
+        else
+            sgemm_set_jit_kernel(ctx, nullptr);
+    }
+    blocking_param current_blocking_param(const gemm_context_t *ctx){
+        blocking_param bp;
+        bp.mc = ctx->mc;
+        bp.nc = ctx->nc;
+        bp.kc = ctx->kc;
+        bp.mr = ctx->mr;
+        bp.nr = ctx->nr;
+        bp.jit = ctx->jit;
+        bp.jit_cfg = ctx->jit_cfg;
+        bp.kernel_desc = ctx->kernel_desc;
+        return bp;
     }
 
-    std::string get_tuned_db_filename(){
+    std::string get_tuned_db_filename(const gemm_context_t *ctx){
         // TODO: better file name
         std::string fn;
         std::string gemm_name;
@@ -478,6 +686,9 @@ public:
             gemm_name = "sgemm";
         else if(sizeof(T) == 8)
             gemm_name = "dgemm";
+        // best blocking differ with huge page backed pack buffer, keep separate db
+        if(ctx->huge_page != HUGE_PAGE_NONE)
+            gemm_name += "_hugepage";
         fn = gemm_name + "_tuned.db";
         return fn;
     }
@@ -602,6 +813,18 @@ public:
         size_t tc = mr;
         return ta+2*tb+tc;
     }
+    // huge page backed pack buffer: A/B pages are held by the 2M tlb array, while C
+    // is user buffer in 4K page and held by the 4K array. larger kc/nc become legal
+    inline bool fit_l1d_tlb(size_t mc, size_t nc, size_t kc, size_t mr, size_t nr, size_t dsize,
+        const gemm_context_t *ctx)
+    {
+        if(ctx->huge_page == HUGE_PAGE_NONE)
+            return req_l1d_tlb(mc, nc, kc, mr, nr, dsize, ctx->page_size) < ctx->tlb_entry_l1d;
+        size_t ta = CEIL(mr*kc*dsize, ctx->page_size)+1;
+        size_t tb = CEIL(nr*kc*dsize, ctx->page_size)+1;
+        size_t tc = mr;
+        return (ta+2*tb) < ctx->tlb_entry_l1d_huge && tc < ctx->tlb_entry_l1d;
+    }
 
     struct stepping_t{
         size_t start = 0;
@@ -690,9 +913,11 @@ public:
         static size_t cur_mr = 6;
         static size_t cur_nr = 16;
 
-        if(mm != ctx->m || nn != ctx->n || kk != ctx->k){
+        // kernel is tuned in the outer loop, mr/nr come from ctx
+        if(mm != ctx->m || nn != ctx->n || kk != ctx->k || cur_mr != ctx->mr || cur_nr != ctx->nr){
             get_current_stepping_t(ctx, ms, ns, ks);
             mm = ctx->m; nn = ctx->n; kk = ctx->k;
+            cur_mr = ctx->mr; cur_nr = ctx->nr;
 
             cur_mc = ms.start;
             cur_nc = ns.start;
@@ -705,23 +930,25 @@ public:
             return false;
         }
 
-        bp->mc = cur_mc;
-        bp->nc = cur_nc;
+        // stepping is in multiple of 6x16, wrap to the kernel in use
+        bp->mc = CEIL_WRAP(cur_mc, cur_mr);
+        bp->nc = CEIL_WRAP(cur_nc, cur_nr);
         bp->kc = cur_kc;
-        bp->mr = cur_mr;     // TODO: only this kernel
+        bp->mr = cur_mr;
         bp->nr = cur_nr;
+        bp->jit = ctx->jit;
+        bp->jit_cfg = ctx->jit_cfg;
+        bp->kernel_desc = ctx->kernel_desc;
 
         size_t l1_size = ctx->l1_size;
-        size_t l2_size = ctx->l2_size;
+        size_t l2_size = ctx->l2_per_thread();
         size_t l3_size = ctx->l3_size;
-        size_t tlb_entry_l1d = ctx->tlb_entry_l1d;
-        size_t page_size = ctx->page_size;
 
         auto valid_req_func = [&](){
             bool valid_l1 = req_l1(cur_mc, cur_nc, cur_kc, cur_mr, cur_nr, sizeof(T)) < l1_size;
             bool valid_l2 = req_l2(cur_mc, cur_nc, cur_kc, cur_mr, cur_nr, sizeof(T)) < l2_size;
             bool valid_l3 = req_l3(cur_mc, cur_nc, cur_kc, cur_mr, cur_nr, sizeof(T)) < l3_size;
-            bool valid_l1d_tlb = req_l1d_tlb(cur_mc, cur_nc, cur_kc, cur_mr, cur_nr, sizeof(T), page_size) < tlb_entry_l1d;
+            bool valid_l1d_tlb = fit_l1d_tlb(cur_mc, cur_nc, cur_kc, cur_mr, cur_nr, sizeof(T), ctx);
             return valid_l1 && valid_l2 && valid_l3 && valid_l1d_tlb;
         };
 
@@ -741,6 +968,73 @@ public:
 
         return true;
     }
+    // jit kernel candidates for tuning, every isa the host support. nullptr cfg is the built-in asm 6x16
+    bool next_kernel_param(sgemm_jit_config_t * cfg, bool * use_asm){
+        static const int shapes[][3] = {
+            {SGEMM_ISA_AVX2, 6, 16}, {SGEMM_ISA_AVX2, 4, 24}, {SGEMM_ISA_AVX2, 12, 8}, {SGEMM_ISA_AVX2, 8, 8},
+            {SGEMM_ISA_AVX512, 6, 32}, {SGEMM_ISA_AVX512, 12, 32}, {SGEMM_ISA_AVX512, 6, 48}, {SGEMM_ISA_AVX512, 8, 48}};
+        static const int unrolls[] = {4, 8};
+        static const int prefetchs[] = {0, 4};
+#define ARRAY_LEN(arr) (sizeof(arr)/sizeof(arr[0]))
+        static size_t idx = 0;
+        static const size_t total = ARRAY_LEN(shapes)*ARRAY_LEN(unrolls)*ARRAY_LEN(prefetchs);
+        while(1){
+            if(idx > total){
+                idx = 0;
+                return false;
+            }
+            if(idx == 0){
+                idx++;
+                *use_asm = true;
+                return true;
+            }
+            size_t i = idx - 1;
+            idx++;
+            *use_asm = false;
+            cfg->prefetch = prefetchs[i % ARRAY_LEN(prefetchs)];
+            i /= ARRAY_LEN(prefetchs);
+            cfg->unroll = unrolls[i % ARRAY_LEN(unrolls)];
+            i /= ARRAY_LEN(unrolls);
+            cfg->isa = (sgemm_isa_t)shapes[i][0];
+            cfg->mr = shapes[i][1];
+            cfg->nr = shapes[i][2];
+            cfg->epilogue = SGEMM_EPILOGUE_ADD;
+            if(sgemm_jit_valid_config(*cfg))
+                return true;
+        }
+#undef ARRAY_LEN
+    }
+    // stream triad once, each array 2x L3 so all three come from dram
+    void probe_mem_bw(gemm_context_t *ctx){
+        if(ctx->mem_bw > 0)
+            return;
+        ctx->mem_bw = stream_triad_gbs(2*ctx->l3_size);
+    }
+    std::string kernel_str(const gemm_context_t *ctx){
+        if(ctx->jit)
+            return std::string("jit ") + ctx->jit_cfg.to_str();
+        if(ctx->kernel_desc)
+            return ctx->kernel_desc->name;
+        return std::string("asm ") + std::to_string(MR) + "x" + std::to_string(NR);
+    }
+    // worker cpu of a multi thread run with its core, smt index and L2/L3 domain
+    void dump_placement(const gemm_context_t * ctx){
+        std::vector<numa_node_t> nodes;
+        std::vector<numa_worker_t> workers;
+        numa_discover_nodes(nodes);
+        numa_assign_workers(nodes, ctx->threads, workers, ctx->place,
+            ctx->cpu_list.size() > 1 ? ctx->cpu_list : std::vector<int>());
+        printf("place:%s, %lu worker per core, L2 split by %lu\n", to_place_str(ctx->place),
+            workers_per_core(workers), ctx->smt_share);
+        for(size_t w=0;w<workers.size();w++){
+            cpu_topo_t topo;
+            cpu_discover_topology(workers[w].cpu, topo);
+            printf(" worker%lu: cpu %d, node%d, package %d, core %d, smt %d/%d, l2 %d, l3 %d\n",
+                w, topo.cpu, nodes[workers[w].node_idx].id, topo.package, topo.core & 0xffff,
+                topo.smt_idx, topo.smt_count, topo.l2_id, topo.l3_id);
+        }
+    }
+
     std::string cpu_list_to_str (const std::vector<int> & cpu_list_){
         std::string str;
         for(int i=0;i<cpu_list_.size();i++){
@@ -790,24 +1084,56 @@ public:
         mr = ctx->mr;
         nr = ctx->nr;
         l1_size = ctx->l1_size;
-        l2_size = ctx->l2_size;
+        l2_size = ctx->l2_per_thread();
         l3_size = ctx->l3_size;
         tlb_entry_l1d = ctx->tlb_entry_l1d;
         page_size = ctx->page_size;
 
         std::string cpu_list_str = cpu_list_to_str(ctx->cpu_list);
-        printf("cpu:%s, freq: %.1fMHz, theoritical: %.3f gflops (avx256,fmadd)\n",
-                        cpu_list_str.c_str(), ctx->frequency, peak_gflops_t<T>()(ctx->frequency));
+        std::string freq_src = "fixed";
+        if(ctx->freq_measure)
+            freq_src = std::string("measured by ") +
+                    freq_source_str(freq_meter_t(bench_cpu(ctx), ctx->kernel_isa()).source());
+        printf("cpu:%s, freq: %.1fMHz (%s), theoritical: %.3f gflops (%s)\n",
+                        cpu_list_str.c_str(), ctx->frequency, freq_src.c_str(),
+                        peak_gflops_t<T>()(ctx->frequency, ctx->kernel_isa()),
+                        peak_gflops_t<T>::str(ctx->kernel_isa()));
+        if(ctx->mem_bw > 0)
+            printf("stream triad: %.2f GB/s, roofline = min(peak, flop/byte * bw)\n", ctx->mem_bw);
+        if(ctx->steal && ctx->threads > 1)
+            printf("threads:%lu, work stealing over C macro tiles\n", ctx->threads);
+        else if(ctx->numa_mode != NUMA_MODE_OFF)
+            printf("threads:%lu, numa:%s\n", ctx->threads, to_numa_mode_str(ctx->numa_mode));
+        if(ctx->num_threads() > 1)
+            dump_placement(ctx);
+        if(ctx->bench_cache != BENCH_CACHE_WARM)
+            printf("cache:%s\n", to_bench_cache_str(ctx->bench_cache));
+        if(ctx->c_offset)
+            printf("C offset:%lu float from %lu byte aligned address\n", ctx->c_offset, ctx->alignment);
+        if(ctx->plan)
+            printf("plan: created once per problem, only sgemm_plan_execute is timed\n");
+        if(ctx->strassen_cutoff)
+            printf("strassen: cutoff %lu, %d level for this shape, gflops is effective (2MNK/time)\n",
+                ctx->strassen_cutoff, sgemm_strassen_levels(ctx->m, ctx->n, ctx->k, ctx));
+        if(ctx->pipe)
+            printf("pipe: A/B packed on helper cpu %d (smt sibling of %d, -1 inherit mask), double buffered\n",
+                smt_sibling_cpu(get_current_cpu()), get_current_cpu());
+        if(ctx->c_acc)
+            printf("c_acc: K>kc accumulate C in %lu x %lu packed buffer\n", ctx->mc, sgemm_c_acc_nc(ctx));
 
         std::string l1_size_str = byte_2_str(l1_size);
         std::string l2_size_str = byte_2_str(l2_size);
         std::string l3_size_str = byte_2_str(l3_size);
-        printf("l1_size:%s, l2_size:%s, l3_size:%s, page_size:%lu, tlb_entry_l1d:%lu\n",
-                        l1_size_str.c_str(), l2_size_str.c_str(), l3_size_str.c_str(), page_size, tlb_entry_l1d);
+        printf("l1_size:%s, l2_size:%s%s, l3_size:%s, page_size:%lu(%s), tlb_entry_l1d:%lu",
+                        l1_size_str.c_str(), l2_size_str.c_str(), ctx->smt_share > 1 ? " per thread" : "",
+                        l3_size_str.c_str(), page_size, huge_page_str(ctx->huge_page), tlb_entry_l1d);
+        if(ctx->huge_page != HUGE_PAGE_NONE)
+            printf(", tlb_entry_l1d_huge:%lu", ctx->tlb_entry_l1d_huge);
+        printf("\n");
         if(dump_level < 1)
             return ;
-        printf("MC:%lu, NC:%lu, KC:%lu, MR:%lu, NR:%lu\n",
-                        mc, nc, kc, mr, nr);
+        printf("MC:%lu, NC:%lu, KC:%lu, MR:%lu, NR:%lu, kernel:%s\n",
+                        mc, nc, kc, mr, nr, kernel_str(ctx).c_str());
         //printf("layout:%s, trans_a:%s, trans_b:%s\n",
         //                to_layout_str(ctx->layout), to_trans_str(ctx->trans_a), to_trans_str(ctx->trans_b));
         printf("Considerations:\n");
@@ -839,16 +1165,27 @@ public:
             printf("  TB:CEIL(NR*KC*d_size/PAGE_SIZE)+1, %lu\n", tb);
             printf("  TC:up to MR, %lu\n", tc);
 
-            lhs = ta+2*tb+tc;
-            rhs = tlb_entry_l1d;
-            printf("  TA+2*(TB)+TC < T_entry_total, lhs:%lu, rhs:%lu, match?%s\n",
-                        lhs, rhs, ((lhs<rhs)?"yes":"no"));
+            if(ctx->huge_page == HUGE_PAGE_NONE){
+                lhs = ta+2*tb+tc;
+                rhs = tlb_entry_l1d;
+                printf("  TA+2*(TB)+TC < T_entry_total, lhs:%lu, rhs:%lu, match?%s\n",
+                            lhs, rhs, ((lhs<rhs)?"yes":"no"));
+            }else{
+                lhs = ta+2*tb;
+                rhs = ctx->tlb_entry_l1d_huge;
+                printf("  TA+2*(TB) < T_entry_2M, lhs:%lu, rhs:%lu, match?%s\n",
+                            lhs, rhs, ((lhs<rhs)?"yes":"no"));
+                lhs = tc;
+                rhs = tlb_entry_l1d;
+                printf("  TC < T_entry_4K, lhs:%lu, rhs:%lu, match?%s\n",
+                            lhs, rhs, ((lhs<rhs)?"yes":"no"));
+            }
         }else{
 
         }
     }
 
-    void tune(gemm_context_t *ctx){
+    void tune(gemm_context_t *ctx, bool tune_kernel){
         // TODO: here tune only for square matrix
         auto summary_func = [&](gemm_context_t *ctx, bench_result<T> * ref, blocking_param * bp){
             size_t mc = bp->mc;
@@ -869,14 +1206,17 @@ public:
                 bp->mc, bp->nc, bp->kc, bp->mr, bp->nr,
                 ref->time_ms, ref->gflops ,ref->perf,
                 l1.c_str(), l2.c_str(), l3.c_str(), l1tlb.c_str());
+            if(bp->jit)
+                printf(" %s", bp->jit_cfg.to_str().c_str());
             printf("\n");
         };
         dump_ctx(ctx, 0);
         printf("    M    N    K alpha beta   mc   nc   kc  mr  nr  best(ms)  gflops(%%)    req(l1/l2/l3/l1dtlb)\n");
         config cfg;
         blocking_param bp;
+        blocking_param user_bp = current_blocking_param(ctx);
 
-        std::string db_fn = get_tuned_db_filename();
+        std::string db_fn = get_tuned_db_filename(ctx);
         while( next_config(&cfg) ){
             ctx->m = cfg.m;
             ctx->n = cfg.n;
@@ -894,28 +1234,45 @@ public:
             blocking_param  best_bp;
             bench_result<T> best_result;
             //printf("---- start run\n");
-            while( next_blocking_param(ctx, &bp) ){
-
-                ctx->mc      = bp.mc;
-                ctx->nc      = bp.nc;
-                ctx->kc      = bp.kc;
-                ctx->mr      = bp.mr;
-                ctx->nr      = bp.nr;
-                if( !bp.mc || !bp.nc || !bp.kc || (bp.mc%bp.mr) || (bp.nc%bp.nr) ){
-                    printf("  m:%lu, n:%lu, k:%lu, mc:%lu, nc:%lu, kc:%lu, mr:%lu, nr:%lu\n",
-                       ctx->m, ctx->n, ctx->k, bp.mc, bp.nc, bp.kc, bp.mr, bp.nr);
-                    assert(0);
+            auto tune_blocking_func = [&](){
+                while( next_blocking_param(ctx, &bp) ){
+
+                    ctx->mc      = bp.mc;
+                    ctx->nc      = bp.nc;
+                    ctx->kc      = bp.kc;
+                    ctx->mr      = bp.mr;
+                    ctx->nr      = bp.nr;
+                    if( !bp.mc || !bp.nc || !bp.kc || (bp.mc%bp.mr) || (bp.nc%bp.nr) ){
+                        printf("  m:%lu, n:%lu, k:%lu, mc:%lu, nc:%lu, kc:%lu, mr:%lu, nr:%lu\n",
+                           ctx->m, ctx->n, ctx->k, bp.mc, bp.nc, bp.kc, bp.mr, bp.nr);
+                        assert(0);
+                    }
+                    //printf("  m:%lu, n:%lu, k:%lu, mc:%lu, nc:%lu, kc:%lu, mr:%lu, nr:%lu\n",
+                    //    ctx->m, ctx->n, ctx->k, bp.mc, bp.nc, bp.kc, bp.mr, bp.nr);
+
+                    gemm_problem_t<T> gemm_prob(ctx);
+                    bench_result<T> rtn_opt = gemm_prob.run_single_case(cblas_sgemm_opt, false);
+                    if(rtn_opt.time_ms < time_ms){
+                        time_ms = rtn_opt.time_ms;
+                        best_bp = bp;
+                        best_result = rtn_opt;
+                    }
                 }
-                //printf("  m:%lu, n:%lu, k:%lu, mc:%lu, nc:%lu, kc:%lu, mr:%lu, nr:%lu\n",
-                //    ctx->m, ctx->n, ctx->k, bp.mc, bp.nc, bp.kc, bp.mr, bp.nr);
-
-                gemm_problem_t<T> gemm_prob(ctx);
-                bench_result<T> rtn_opt = gemm_prob.run_single_case(cblas_sgemm_opt, false);
-                if(rtn_opt.time_ms < time_ms){
-                    time_ms = rtn_opt.time_ms;
-                    best_bp = bp;
-                    best_result = rtn_opt;
+            };
+            if(tune_kernel){
+                // kernel is the outer loop, micro kernel only handle full mr*nr tile
+                sgemm_jit_config_t kernel_cfg;
+                bool use_asm;
+                while( next_kernel_param(&kernel_cfg, &use_asm) ){
+                    if(!sgemm_set_jit_kernel(ctx, use_asm ? nullptr : &kernel_cfg))
+                        continue;
+                    if((ctx->m % ctx->mr) || (ctx->n % ctx->nr))
+                        continue;
+                    tune_blocking_func();
                 }
+            }else{
+                apply_kernel(ctx, user_bp);
+                tune_blocking_func();
             }
             summary_func(ctx, &best_result, &best_bp);
             std::string map_key, map_value;
@@ -926,22 +1283,32 @@ public:
             serialize_pair(map_key,map_value,db_fn);
             tuned_blocking_map[map_key] = map_value;
         }
+        apply_kernel(ctx, user_bp);
     }
     //void run(std::vector<int> cpu_list, double freq, bool validate_only, bool no_ref, gemm_problem_t * single_problem = nullptr){
     void run(gemm_context_t *ctx, bool validate_only, bool no_ref, bool one_shot, bool use_tuned){
 
         auto summary_func = [&](gemm_problem_t<T> * prob, bench_result<T> * r_ref, bench_result<T> * r_opt){
             printf(" %4lu %4lu %4lu  %.1f  %.1f "
-                    "  %4lu %4lu %4lu %3lu %3lu %6.2f(%2.2f) %6.2f(%2.2f)",
+                    "  %4lu %4lu %4lu %3lu %3lu %6.2f(%2.2f) %6.2f(%2.2f) %6.0f %7.2f",
                 prob->ctx->m,prob->ctx->n,prob->ctx->k,prob->ctx->alpha,prob->ctx->beta,
                 prob->ctx->mc, prob->ctx->nc, prob->ctx->kc, prob->ctx->mr, prob->ctx->nr,
-                r_opt->gflops,r_opt->perf,r_ref?(r_ref->gflops):0,r_ref?(r_ref->perf):0);
+                r_opt->gflops,r_opt->perf,r_ref?(r_ref->gflops):0,r_ref?(r_ref->perf):0,
+                r_opt->freq_mhz, r_opt->roof_perf);
+            if(r_opt->ws.bytes)
+                printf(" %7.1f%s %6.1f", r_opt->ws.bytes/1024.0, r_opt->ws.tls ? "t" : "h", r_opt->minflt);
+            else
+                printf(" %8s %6.1f", "-", r_opt->minflt);
             if(prob->ctx->cur_use_tuned)
                 printf("  [t]");
             else
                 printf("  [*]");
             if(validate_only && r_ref){
-                bool result = valid_matrix(r_ref->c, r_opt->c, 0.001f);
+                // each strassen level roughly double the rounding error, allow 4x per level
+                double delta = 0.001f;
+                if(prob->ctx->strassen_cutoff)
+                    delta *= 1 << (2*sgemm_strassen_levels(prob->ctx->m, prob->ctx->n, prob->ctx->k, prob->ctx));
+                bool result = valid_matrix(r_ref->c, r_opt->c, delta);
                 if(result)
                     printf("  <valid>");
                 else
@@ -951,32 +1318,30 @@ public:
         };
 
         auto bench_single_func = [&](gemm_problem_t<T> * prob){
+            cblas_sgemm_opt_t opt_func = gemm_problem_t<T>::opt_wrapper(prob->ctx);
             if(no_ref){
-                bench_result<T> rtn_opt = prob->run_single_case(cblas_sgemm_opt, validate_only);
+                bench_result<T> rtn_opt = prob->run_single_case(opt_func, validate_only);
                 summary_func(prob, nullptr, &rtn_opt);
             }
             else{
                 bench_result<T> rtn_ref = prob->run_single_case(cblas_sgemm, validate_only);
-                bench_result<T> rtn_opt = prob->run_single_case(cblas_sgemm_opt, validate_only);
+                bench_result<T> rtn_opt = prob->run_single_case(opt_func, validate_only);
                 summary_func(prob, &rtn_ref, &rtn_opt);
             }
         };
         if(use_tuned)
-            deserialize_map(tuned_blocking_map, get_tuned_db_filename());
+            deserialize_map(tuned_blocking_map, get_tuned_db_filename(ctx));
+        if(!validate_only)
+            probe_mem_bw(ctx);
 
         dump_ctx(ctx);
         assert( ((ctx->mc % ctx->mr) == 0) && ((ctx->nc % ctx->nr) == 0) &&
                     "MC%%MR, NC%%NR must be zero\n");
         
-        blocking_param default_bp;
-        default_bp.mc = ctx->mc;
-        default_bp.nc = ctx->nc;
-        default_bp.kc = ctx->kc;
-        default_bp.mr = ctx->mr;
-        default_bp.nr = ctx->nr;
+        blocking_param default_bp = current_blocking_param(ctx);
 
         //printf("require: L1:%.1fKB(KC*NR*4), L2:%.1fKB(KC*MC*4), L3:%.1fKB(KC*NC*4)\n", req_l1()/1024.0, req_l2()/1024.0, req_l3()/1024.0);
-        printf("    M    N    K alpha beta   mc    nc   kc  mr  nr   gflops(%%)   gflops_ref(%%)\n");
+        printf("    M    N    K alpha beta   mc    nc   kc  mr  nr   gflops(%%)   gflops_ref(%%)    MHz roof(%%) pack(KB) flt/call\n");
 
         while(1){
             if(one_shot){
@@ -1023,6 +1388,1368 @@ public:
             }
         }
     }
+
+    // best time of loops calls, after one warm up call
+    static double time_best(const std::function<void()> & func, int loops = 3){
+        func();
+        double best = 1e30;
+        for(int l=0; l<loops; l++){
+            double t = current_sec();
+            func();
+            best = MIN(best, current_sec() - t);
+        }
+        return best;
+    }
+
+    // dense row major M x N x K problem of the benches, lda K, ldb/ldc N
+    static void set_shape(gemm_context_t * ctx, size_t m, size_t n, size_t k){
+        ctx->m = m;  ctx->n = n;  ctx->k = k;
+        ctx->lda = k;  ctx->ldb = n;  ctx->ldc = n;
+    }
+
+    // the mode called directly (plan, steal, pipe...) need full tiles, print a skip line if not
+    static bool skip_partial_tile(const gemm_context_t * ctx){
+        if(!(ctx->m % ctx->mr) && !(ctx->n % ctx->nr))
+            return false;
+        printf(" %4lu %4lu %4lu  skip, M%%%lu or N%%%lu not zero\n", ctx->m, ctx->n, ctx->k, ctx->mr, ctx->nr);
+        return true;
+    }
+
+    // every registered micro kernel (asm, intrinsic) through the same blocking, validated against blas
+    void kernel_bench(gemm_context_t *ctx){
+        blocking_param user_bp = current_blocking_param(ctx);
+        dump_ctx(ctx, 0);
+        printf("    M    N    K   mc   nc   kc  mr  nr  isa     kernel                 gflops(%%)  valid  odd_k\n");
+
+        gemm_problem_t<T> gemm_prob(ctx);
+        bench_result<T> ref = gemm_prob.run_single_case(cblas_sgemm, true);
+        // k remainder of the kernel: odd K, last kc block not a multiple of the unroll
+        auto valid_odd_k = [&](){
+            size_t m = ctx->m, n = ctx->n, k = ctx->k, lda = ctx->lda, ldb = ctx->ldb, ldc = ctx->ldc;
+            set_shape(ctx, ctx->mr*3, ctx->nr*2, ctx->kc*2 + 7);
+            gemm_problem_t<T> odd_prob(ctx);
+            bench_result<T> odd_ref = odd_prob.run_single_case(cblas_sgemm, true);
+            bench_result<T> odd_opt = odd_prob.run_single_case(cblas_sgemm_opt, true);
+            bool valid = valid_matrix(odd_ref.c, odd_opt.c, 0.001f);
+            ctx->m = m;  ctx->n = n;  ctx->k = k;  ctx->lda = lda;  ctx->ldb = ldb;  ctx->ldc = ldc;
+            return valid;
+        };
+        for(int i=0;i<sgemm_kernel_count();i++){
+            const sgemm_kernel_desc_t * desc = sgemm_kernel_get(i);
+            if(!sgemm_set_kernel(ctx, desc)){
+                printf("  %s: %s not supported on this cpu\n", desc->name, sgemm_isa_str(desc->isa));
+                continue;
+            }
+            ctx->mc = CEIL_WRAP(user_bp.mc, ctx->mr);
+            ctx->nc = CEIL_WRAP(user_bp.nc, ctx->nr);
+            bench_result<T> opt = gemm_prob.run_single_case(cblas_sgemm_opt, true);
+            bool valid = valid_matrix(ref.c, opt.c, 0.001f);
+            bench_result<T> r = gemm_prob.run_single_case(cblas_sgemm_opt, false);
+            bool valid_odd = valid_odd_k();
+            printf(" %4lu %4lu %4lu %4lu %4lu %4lu %3lu %3lu  %-7s %-20s %6.2f(%2.2f)  %-5s  %s\n",
+                ctx->m, ctx->n, ctx->k, ctx->mc, ctx->nc, ctx->kc, ctx->mr, ctx->nr,
+                sgemm_isa_str(desc->isa), desc->name, r.gflops, r.perf, valid ? "yes":"no",
+                valid_odd ? "yes":"no");
+        }
+        ctx->mc = user_bp.mc;
+        ctx->nc = user_bp.nc;
+        apply_kernel(ctx, user_bp);
+    }
+
+    /*
+    * micro kernel alone, no pack and no blocking. packed A/B panel and the C tile are
+    * reused every call, so they sit in L1 if (mr+nr)*kc*4 + mr*nr*4 fit (the "fit" column).
+    * efficiency is flop/cycle against the tier peak of the kernel, fma/cycle count a
+    * mul+add pair of sse/avx tier as one. cycles from perf counter, else time * -f
+    */
+    void ukernel_bench(gemm_context_t *ctx){
+        struct ukernel_t {
+            std::string             name;
+            size_t                  mr;
+            size_t                  nr;
+            sgemm_isa_t             isa;
+            sgemm_micro_kernel_t    kernel;
+        };
+        std::vector<ukernel_t> kernels;
+        for(int i=0;i<sgemm_kernel_count();i++){
+            const sgemm_kernel_desc_t * desc = sgemm_kernel_get(i);
+            if(!sgemm_isa_supported(desc->isa)){
+                printf("  %s: %s not supported on this cpu\n", desc->name, sgemm_isa_str(desc->isa));
+                continue;
+            }
+            kernels.push_back({desc->name, (size_t)desc->mr, (size_t)desc->nr, desc->isa, desc->kernel});
+        }
+        if(ctx->jit)
+            kernels.push_back({kernel_str(ctx), ctx->mr, ctx->nr, ctx->jit_cfg.isa, ctx->micro_kernel});
+
+        const size_t kcs[] = {16, 32, 64, 128, 192, 256, 384, 512};
+        printf("l1_size:%s, cycles: %s\n", byte_2_str(ctx->l1_size).c_str(), ctx->freq_measure ?
+            (std::string("time * freq measured by ") +
+                freq_source_str(freq_meter_t(bench_cpu(ctx), ctx->kernel_isa()).source())).c_str() :
+            "time * fixed -f");
+        printf(" %-24s %-7s  mr  nr   kc  fit  fma/cycle   eff(%%)   gflops\n", "kernel", "isa");
+        for(const auto & uk : kernels){
+            for(size_t kc : kcs){
+                size_t a_bytes = uk.mr*kc*sizeof(float);
+                size_t b_bytes = uk.nr*kc*sizeof(float);
+                size_t c_bytes = uk.mr*uk.nr*sizeof(float);
+                float * A = (float*)__aligned_malloc(a_bytes, 64);
+                float * B = (float*)__aligned_malloc(b_bytes, 64);
+                float * C = (float*)__aligned_malloc(c_bytes, 64);
+                rand_vector(A, uk.mr*kc);
+                rand_vector(B, uk.nr*kc);
+                memset(C, 0, c_bytes);
+                size_t footprint = a_bytes + b_bytes + c_bytes;
+                const char * fit = footprint <= ctx->l1_size ? "L1" : (footprint <= ctx->l2_size ? "L2" : "L3");
+
+                auto loop_func = [&](size_t calls){
+                    for(size_t i=0;i<calls;i++)
+                        uk.kernel(uk.mr, uk.nr, kc, 1.0f, A, B, 1.0f, C, uk.nr);
+                };
+                // ~20ms per point
+                loop_func(1000);
+                double t = current_sec();
+                loop_func(1000);
+                double t_call = (current_sec() - t) / 1000;
+                size_t calls = MAX((size_t)(20e-3 / (t_call + 1e-12)), (size_t)1000);
+
+                freq_meter_t freq_meter(bench_cpu(ctx), uk.isa);
+                freq_meter.start();
+                t = current_sec();
+                loop_func(calls);
+                double cost = current_sec() - t;
+                double freq_mhz = ctx->freq_measure ? freq_meter.stop() : ctx->frequency;
+                double cycles = cost*(freq_mhz > 0 ? freq_mhz : ctx->frequency)*1e6;
+
+                double flop = 2.0*uk.mr*uk.nr*kc*calls;
+                double lanes = sgemm_isa_vector_bytes(uk.isa) / sizeof(float);
+                double flop_per_cycle = flop / cycles;
+                printf(" %-24s %-7s %3lu %3lu %4lu  %-3s  %9.3f  %7.2f  %7.2f\n",
+                    uk.name.c_str(), sgemm_isa_str(uk.isa), uk.mr, uk.nr, kc, fit,
+                    flop_per_cycle/(2*lanes),
+                    flop_per_cycle/peak_gflops_t<float>::flop_per_cycle(uk.isa)*100,
+                    flop/(cost*1e9));
+
+                __aligned_free(A);
+                __aligned_free(B);
+                __aligned_free(C);
+            }
+        }
+    }
+
+    /*
+    * each packer of sgemm_pack_get() alone, on a range of shape and ld. GB/s count
+    * src read + dest write. full panels and edge (last panel mr_size<mr / nr_size<nr)
+    * are separate tables. output is checked against a plain reference pack
+    */
+    void pack_bench(gemm_context_t *ctx){
+        const float alpha = 1.5f;
+        // A: rows(mc) x kc, B: kc x cols(nc). rows/cols are whole panels of the tile
+        // kc 100 is not a multiple of the 8/16 k unroll of the packers
+        const size_t a_shapes[][2] = {{8,64}, {40,128}, {86,168}, {16,512}, {20,100}};    // panels x kc
+        const size_t b_shapes[][2] = {{128,4}, {168,16}, {256,64}, {512,6}, {100,8}};     // kc x panels
+        const int num_shapes = sizeof(a_shapes)/sizeof(a_shapes[0]);
+
+        auto ld_list = [&](size_t w){
+            std::vector<size_t> lds;
+            // 2K byte multiple ld next to the same ld padded by 16, to show the alias cost
+            for(size_t ld : {w, w+16, (size_t)1024, (size_t)1040, (size_t)2048, (size_t)4096, (size_t)4112})
+                if(ld >= w && std::find(lds.begin(), lds.end(), ld) == lds.end())
+                    lds.push_back(ld);
+            return lds;
+        };
+        // reference layout, see sgemm_pack.h
+        auto pack_valid = [&](const sgemm_pack_desc_t * desc, size_t tile, size_t rows, size_t cols,
+                const float * src, size_t ld, const float * dest){
+            bool is_a = desc->ident == IDENT_A_MATRIX;
+            size_t outer = is_a ? rows : cols;      // dimension split into panels
+            size_t inner = is_a ? cols : rows;      // kc
+            for(size_t p=0; p<outer; p+=tile){
+                size_t p_size = MIN(outer-p, tile);
+                const float * d = dest + (p/tile)*tile*inner;
+                for(size_t kk=0; kk<inner; kk++){
+                    for(size_t i=0; i<p_size; i++){
+                        float ref = is_a ? alpha*src[(p+i)*ld + kk] : src[kk*ld + p+i];
+                        if(ABS(d[kk*p_size + i] - ref) > 1e-5f*ABS(ref))
+                            return false;
+                    }
+                }
+            }
+            return true;
+        };
+
+        for(int edge=0; edge<2; edge++){
+            printf("%s\n", edge ? "edge panels, last panel mr_size<mr (A) or nr_size<nr (B)" : "full panels");
+            printf(" %-24s tile  rows  cols    ld  alias     GB/s  valid\n", "packer");
+            for(int i=0;i<sgemm_pack_count();i++){
+                const sgemm_pack_desc_t * desc = sgemm_pack_get(i);
+                if(!sgemm_isa_supported(desc->isa)){
+                    printf("  %s: %s not supported on this cpu\n", desc->name, sgemm_isa_str(desc->isa));
+                    continue;
+                }
+                bool is_a = desc->ident == IDENT_A_MATRIX;
+                gemm_context_t pctx = *ctx;
+                size_t tile = desc->tile ? desc->tile : (is_a ? ctx->mr : ctx->nr);
+                pctx.mr = is_a ? tile : ctx->mr;
+                pctx.nr = is_a ? ctx->nr : tile;
+                for(int s=0; s<num_shapes; s++){
+                    size_t rows, cols;
+                    if(is_a){
+                        rows = a_shapes[s][0]*tile;
+                        cols = a_shapes[s][1];
+                        if(edge) rows -= tile/2;
+                    }else{
+                        rows = b_shapes[s][0];
+                        cols = b_shapes[s][1]*tile;
+                        if(edge) cols -= tile/2;
+                    }
+                    for(size_t ld : ld_list(cols)){
+                        size_t src_elem = rows*ld;
+                        size_t dest_elem = CEIL(is_a ? rows : cols, tile)*tile*(is_a ? cols : rows);
+                        float * src = (float*)__aligned_malloc(src_elem*sizeof(float), 64);
+                        float * dest = (float*)__aligned_malloc(dest_elem*sizeof(float), 64);
+                        rand_vector(src, src_elem);
+                        auto pack_func = [&](){
+                            if(is_a)
+                                desc->func(rows, 0, cols, alpha, src, ld, dest, &pctx);
+                            else
+                                desc->func(0, cols, rows, alpha, src, ld, dest, &pctx);
+                        };
+                        pack_func();
+                        bool valid = pack_valid(desc, tile, rows, cols, src, ld, dest);
+                        double t = current_sec();
+                        pack_func();
+                        double t_one = current_sec() - t;
+                        int loops = MAX((int)(5e-3 / (t_one + 1e-12)), 1);
+                        t = current_sec();
+                        for(int l=0;l<loops;l++)
+                            pack_func();
+                        double cost = (current_sec() - t) / loops;
+                        double bytes = 2.0*rows*cols*sizeof(float);
+                        printf(" %-24s %4lu %5lu %5lu %5lu  %5s %8.2f  %s\n", desc->name, tile,
+                            rows, cols, ld, (ld*sizeof(float))%2048 ? "" : "yes", bytes/cost/1e9, valid ? "yes" : "no");
+                        __aligned_free(src);
+                        __aligned_free(dest);
+                    }
+                }
+            }
+        }
+    }
+
+    /*
+    * per call cost of cblas_sgemm_opt vs executing a plan of the same problem, on the
+    * small shapes where it matter. overhead is the difference per call, create is one
+    * sgemm_plan_create+destroy, lookup is one update_tuned_param (key string + hash)
+    */
+    void plan_bench(gemm_context_t *ctx, bool use_tuned){
+        std::vector<bench_shape_t> shapes;
+        bench_shape_sets("batch_small", shapes);
+        if(use_tuned)
+            deserialize_map(tuned_blocking_map, get_tuned_db_filename(ctx));
+        blocking_param default_bp = current_blocking_param(ctx);
+        dump_ctx(ctx, 0);
+        printf("    M    N    K   opt(us)  plan(us)  overhead(us)  create(us)  lookup(us)  valid\n");
+
+        auto time_us = [](const std::function<void()> & func){
+            func();
+            double t = current_sec();
+            func();
+            double t_one = current_sec() - t;
+            int loops = MAX((int)(20e-3 / (t_one + 1e-9)), 1);
+            t = current_sec();
+            for(int l=0;l<loops;l++)
+                func();
+            return (current_sec() - t) / loops * 1e6;
+        };
+        for(const auto & shape : shapes){
+            set_shape(ctx, shape.m, shape.n, shape.k);
+            ctx->alpha = shape.alpha;
+            ctx->beta = shape.beta;
+            double lookup_us = time_us([&](){ update_tuned_param(tuned_blocking_map, ctx, default_bp); });
+            if(skip_partial_tile(ctx))
+                continue;
+            gemm_problem_t<T> prob(ctx);
+            matrix_t<T> c_plan(*prob.C);
+            matrix_t<T> c_opt(*prob.C);
+            sgemm_plan_t * plan = sgemm_plan_create(ctx->layout, ctx->trans_a, ctx->trans_b,
+                    ctx->m, ctx->n, ctx->k, ctx->lda, ctx->ldb, ctx->ldc, ctx);
+            if(!plan)
+                continue;
+            // beta is kept 1 in the set, C keep growing across calls, compare after one call each
+            sgemm_plan_execute(plan, ctx->alpha, prob.A->data, prob.B->data, ctx->beta, c_plan.data);
+            cblas_sgemm_opt(ctx->layout, ctx->trans_a, ctx->trans_b, ctx->m, ctx->n, ctx->k,
+                ctx->alpha, prob.A->data, ctx->lda, prob.B->data, ctx->ldb, ctx->beta, c_opt.data, ctx->ldc, ctx);
+            bool valid = valid_matrix(&c_opt, &c_plan, 0.f);
+
+            double opt_us = time_us([&](){
+                cblas_sgemm_opt(ctx->layout, ctx->trans_a, ctx->trans_b, ctx->m, ctx->n, ctx->k,
+                    ctx->alpha, prob.A->data, ctx->lda, prob.B->data, ctx->ldb, ctx->beta, c_opt.data, ctx->ldc, ctx);
+            });
+            double plan_us = time_us([&](){
+                sgemm_plan_execute(plan, ctx->alpha, prob.A->data, prob.B->data, ctx->beta, c_plan.data);
+            });
+            double create_us = time_us([&](){
+                sgemm_plan_destroy(sgemm_plan_create(ctx->layout, ctx->trans_a, ctx->trans_b,
+                    ctx->m, ctx->n, ctx->k, ctx->lda, ctx->ldb, ctx->ldc, ctx));
+            });
+            sgemm_plan_destroy(plan);
+            printf(" %4lu %4lu %4lu %9.3f %9.3f %13.3f %11.3f %11.3f  %s\n", ctx->m, ctx->n, ctx->k,
+                opt_us, plan_us, opt_us - plan_us, create_us, lookup_us, valid ? "yes" : "no");
+        }
+    }
+
+    /*
+    * named shape sets (bench_suite.h) with gflops stats over samples, report to csv/json,
+    * and optional compare against a baseline csv. return number of regressions
+    */
+    int suite_bench(gemm_context_t *ctx, const std::string & suite, int repeat, bool no_ref,
+        bool use_tuned, const std::string & out, const std::string & baseline, double threshold)
+    {
+        std::vector<bench_shape_t> shapes;
+        if(!bench_shape_sets(suite, shapes))
+            return -1;
+        std::vector<bench_record_t> base_records;
+        if(!baseline.empty() && !bench_read_baseline(baseline, base_records))
+            return -1;
+        if(use_tuned)
+            deserialize_map(tuned_blocking_map, get_tuned_db_filename(ctx));
+        blocking_param default_bp = current_blocking_param(ctx);
+        probe_mem_bw(ctx);
+        dump_ctx(ctx, 0);
+        printf("suite:%s, shapes:%lu, samples:%d\n", suite.c_str(), shapes.size(), repeat);
+        printf(" %-12s     M    N    K   mc   nc   kc  mr  nr  %-18s %8s %8s %8s %6s %6s %6s %8s\n",
+            "set", "kernel", "median", "min", "max", "%peak", "%roof", "MHz", "ref");
+
+        // each sample last at least ~1ms, small shape repeat the call inside a sample.
+        // operand reuse between calls follow -cache, see gemm_problem_t::run_loops()
+        // return core clock over all samples
+        auto sample_func = [&](gemm_problem_t<T> & prob, cblas_sgemm_opt_t gemm_func,
+                std::vector<double> & gflops) -> double {
+            unsigned long long flop = sgemm_flop(ctx->m,ctx->n,ctx->k,ctx->alpha,ctx->beta);
+            T * c = prob.C->data;
+            prob.run_loops(gemm_func, (int)prob.operand_sets(), c);    // warm up
+            double t_one = prob.run_loops(gemm_func, 1, c);
+            int inner = t_one > 1e-3 ? 1 : (int)(1e-3 / (t_one + 1e-9)) + 1;
+            freq_meter_t freq_meter(bench_cpu(ctx), ctx->kernel_isa());
+            freq_meter.start();
+            for(int s=0; s<repeat; s++){
+                double cost = prob.run_loops(gemm_func, inner, c) / inner;
+                gflops.push_back((double)flop/(cost*1e9));
+            }
+            double freq_mhz = ctx->freq_measure ? freq_meter.stop() : ctx->frequency;
+            return freq_mhz > 0 ? freq_mhz : ctx->frequency;
+        };
+
+        std::vector<bench_record_t> records;
+        for(const auto & shape : shapes){
+            set_shape(ctx, shape.m, shape.n, shape.k);
+            ctx->alpha = shape.alpha;
+            ctx->beta = shape.beta;
+            if(use_tuned)
+                update_tuned_param(tuned_blocking_map, ctx, default_bp);
+
+            bench_record_t rec;
+            rec.set = shape.set;
+            rec.m = shape.m; rec.n = shape.n; rec.k = shape.k;
+            rec.alpha = shape.alpha; rec.beta = shape.beta;
+            rec.mc = ctx->mc; rec.nc = ctx->nc; rec.kc = ctx->kc;
+            rec.mr = ctx->mr; rec.nr = ctx->nr;
+            rec.kernel = kernel_str(ctx);
+            rec.tuned = ctx->cur_use_tuned;
+            rec.threshold = threshold;
+            rec.skipped = (ctx->m % ctx->mr) || (ctx->n % ctx->nr);
+            if(rec.skipped){
+                printf(" %-12s %5lu %4lu %4lu  skip, M%%%lu or N%%%lu not zero\n",
+                    rec.set.c_str(), rec.m, rec.n, rec.k, rec.mr, rec.nr);
+                records.push_back(rec);
+                continue;
+            }
+
+            gemm_problem_t<T> gemm_prob(ctx);
+            std::vector<double> gflops;
+            rec.freq_mhz = sample_func(gemm_prob, gemm_problem_t<T>::opt_wrapper(ctx), gflops);
+            bench_record_stats(rec, gflops);
+            double peak = bench_peak_gflops<T>(ctx, rec.freq_mhz);
+            rec.peak_pct = rec.gflops_median / peak * 100;
+            rec.roof_pct = rec.gflops_median / bench_roofline_gflops<T>(ctx, peak) * 100;
+            if(!no_ref){
+                bench_record_t ref;
+                std::vector<double> ref_gflops;
+                sample_func(gemm_prob, gemm_problem_t<T>::cblas_wrapper(cblas_sgemm), ref_gflops);
+                bench_record_stats(ref, ref_gflops);
+                rec.ref_gflops = ref.gflops_median;
+            }
+            printf(" %-12s %5lu %4lu %4lu %4lu %4lu %4lu %3lu %3lu  %-18s %8.2f %8.2f %8.2f %6.2f %6.2f %6.0f %8.2f\n",
+                rec.set.c_str(), rec.m, rec.n, rec.k, rec.mc, rec.nc, rec.kc, rec.mr, rec.nr,
+                rec.kernel.c_str(), rec.gflops_median, rec.gflops_min, rec.gflops_max,
+                rec.peak_pct, rec.roof_pct, rec.freq_mhz, rec.ref_gflops);
+            records.push_back(rec);
+        }
+        apply_kernel(ctx, default_bp);
+
+        if(!out.empty() && bench_write_report(out, records) && out != "-")
+            printf("report written to %s\n", out.c_str());
+        if(base_records.empty())
+            return 0;
+        return bench_compare_baseline(base_records, records, threshold);
+    }
+
+    // multi socket scaling, naive shared B panel vs per node replicated B panel
+    void numa_bench(gemm_context_t *ctx, bool use_tuned){
+        std::vector<numa_node_t> nodes;
+        numa_discover_nodes(nodes);
+        printf("numa nodes:%lu\n", nodes.size());
+        for(auto & node : nodes)
+            printf(" node%d, cpu:%s\n", node.id, cpu_list_str(node.cpu_list).c_str());
+
+        if(use_tuned){
+            blocking_param default_bp = current_blocking_param(ctx);
+            deserialize_map(tuned_blocking_map, get_tuned_db_filename(ctx));
+            update_tuned_param(tuned_blocking_map, ctx, default_bp);
+        }
+        dump_ctx(ctx, 0);
+
+        size_t max_threads = ctx->threads;
+        numa_mode_t numa_mode = ctx->numa_mode;
+
+        printf("    M    N    K   mc   nc   kc threads       numa   gflops(%%)  speedup\n");
+        double base_gflops = 0;
+        auto bench_func = [&](size_t threads, numa_mode_t mode){
+            ctx->threads = threads;
+            ctx->numa_mode = mode;
+            gemm_problem_t<T> gemm_prob(ctx);
+            bench_result<T> r = gemm_prob.run_single_case(cblas_sgemm_opt, false);
+            if(mode == NUMA_MODE_OFF)
+                base_gflops = r.gflops;
+            printf(" %4lu %4lu %4lu %4lu %4lu %4lu %7lu %10s %6.2f(%2.2f)  %6.2fx\n",
+                ctx->m, ctx->n, ctx->k, ctx->mc, ctx->nc, ctx->kc,
+                threads, to_numa_mode_str(mode), r.gflops, r.perf,
+                base_gflops > 0 ? r.gflops/base_gflops : 0);
+        };
+
+        bench_func(1, NUMA_MODE_OFF);
+        // 1 socket, then doubling until all threads. shared and replicate are the
+        // same if all threads land on one node
+        for(size_t t=2; ; t*=2){
+            if(t > max_threads)
+                t = max_threads;
+            bench_func(t, NUMA_MODE_SHARED);
+            bench_func(t, NUMA_MODE_REPLICATE);
+            if(t == max_threads)
+                break;
+        }
+
+        ctx->threads = max_threads;
+        ctx->numa_mode = numa_mode;
+    }
+
+    /*
+    * work stealing vs static split of the same C macro tiles, on shapes that do not divide
+    * evenly by threads*tile. interference is a thread spinning on a mul/add chain, pinned on the cpu of
+    * the last worker for the whole timed loop, so that worker run at about half speed.
+    * tasks min/max is tiles run per worker, steals count successful steal
+    */
+    void steal_bench(gemm_context_t *ctx){
+        const size_t shapes[][3] = {{966,1008,512}, {2004,1040,256}, {1506,2032,1024}, {3000,3008,768}};
+        size_t threads = ctx->threads;
+        bool steal = ctx->steal;
+        ctx->steal = true;  // peak of all threads
+        if(threads < 2){
+            printf("-threads %lu, use 2 for the steal bench\n", threads);
+            ctx->threads = 2;
+        }
+        dump_ctx(ctx, 0);
+        std::vector<numa_node_t> nodes;
+        std::vector<numa_worker_t> workers;
+        numa_discover_nodes(nodes);
+        numa_assign_workers(nodes, ctx->threads, workers, ctx->place,
+            ctx->cpu_list.size() > 1 ? ctx->cpu_list : std::vector<int>());
+        int hog_cpu = workers.back().cpu;
+        printf("threads:%lu, interference on cpu %d, tasks per thread >= %d\n",
+            ctx->threads, hog_cpu, STEAL_TASKS_PER_THREAD);
+        printf("    M    N    K tile_m tile_n tiles interfere  static(%%)       steal(%%)  speedup steals tasks(min/max)  valid\n");
+
+        auto hog_func = [](std::atomic<bool> * stop, int cpu){
+            std::vector<int> affinity;
+            affinity.push_back(cpu);
+            set_current_affinity(affinity);
+            double v = 1.0;
+            while(!stop->load(std::memory_order_relaxed)){
+                for(int i=0;i<1024;i++)
+                    v = v*0.999999 + 1e-9;
+            }
+            volatile double sink = v;
+            (void)sink;
+        };
+
+        for(const auto & shape : shapes){
+            set_shape(ctx, shape[0], shape[1], shape[2]);
+            if(skip_partial_tile(ctx))
+                continue;
+            gemm_problem_t<T> gemm_prob(ctx);
+            matrix_t<T> c_static(*gemm_prob.C);
+            matrix_t<T> c_steal(*gemm_prob.C);
+            for(int interfere=0; interfere<2; interfere++){
+                std::atomic<bool> stop {false};
+                std::thread hog;
+                if(interfere)
+                    hog = std::thread(hog_func, &stop, hog_cpu);
+
+                sgemm_steal_stats_t st_static, st_steal;
+                auto time_func = [&](bool allow_steal, T * c, sgemm_steal_stats_t * st){
+                    double best = time_best([&](){
+                        sgemm_n_nn_steal(ctx->m, ctx->n, ctx->k, ctx->alpha,
+                            gemm_prob.A->data, ctx->lda, gemm_prob.B->data, ctx->ldb,
+                            ctx->beta, c, ctx->ldc, ctx, allow_steal, st);
+                    });
+                    return (double)sgemm_flop(ctx->m,ctx->n,ctx->k,ctx->alpha,ctx->beta)/(best*1e9);
+                };
+                double g_static = time_func(false, c_static.data, &st_static);
+                double g_steal = time_func(true, c_steal.data, &st_steal);
+                if(interfere){
+                    stop.store(true);
+                    hog.join();
+                }
+                bool valid = valid_matrix(&c_static, &c_steal, 0.f);
+                int t_min = *std::min_element(st_steal.worker_tasks.begin(), st_steal.worker_tasks.end());
+                int t_max = *std::max_element(st_steal.worker_tasks.begin(), st_steal.worker_tasks.end());
+                double peak = bench_peak_gflops<T>(ctx, ctx->frequency);
+                printf(" %4lu %4lu %4lu %6d %6d %5d %9s %6.2f(%5.2f) %6.2f(%5.2f) %8.3f %6d %8d/%-8d  %s\n",
+                    ctx->m, ctx->n, ctx->k, st_steal.tile_m, st_steal.tile_n, st_steal.tiles,
+                    interfere ? "yes" : "no", g_static, g_static/peak*100, g_steal, g_steal/peak*100,
+                    g_steal/g_static, st_steal.steals, t_min, t_max, valid ? "yes" : "no");
+            }
+        }
+        ctx->threads = threads;
+        ctx->steal = steal;
+    }
+
+    /*
+    * strassen layer vs classical path on large square shapes. gflops of both is effective,
+    * 2*M*N*K/time, so strassen can go over the fma peak. error is ||C - C_ref||_F / ||C_ref||_F
+    * and max |C - C_ref| / max |C_ref|, against cblas_dgemm of the same float input
+    */
+    void strassen_bench(gemm_context_t *ctx){
+        size_t cutoff = ctx->strassen_cutoff;
+        const size_t sizes[] = {1536, 3072, 4608, 6144};
+        if(!ctx->strassen_cutoff)
+            ctx->strassen_cutoff = 1024;
+        ctx->alpha = 1;
+        ctx->beta = 0;
+        dump_ctx(ctx, 0);
+        printf("cutoff:%lu, gflops is effective (2MNK/time)\n", ctx->strassen_cutoff);
+        printf("    M    N    K levels  classical(%%)   strassen(%%)  speedup   err_classical  err_strassen  max_classical  max_strassen\n");
+
+        auto error = [](const T * c, const double * ref, size_t elem, double & max_rel){
+            double diff = 0, norm = 0, max_diff = 0, max_ref = 0;
+            for(size_t i=0;i<elem;i++){
+                double d = (double)c[i] - ref[i];
+                diff += d*d;
+                norm += ref[i]*ref[i];
+                max_diff = MAX(max_diff, ABS(d));
+                max_ref = MAX(max_ref, ABS(ref[i]));
+            }
+            max_rel = max_ref > 0 ? max_diff / max_ref : 0;
+            return norm > 0 ? sqrt(diff / norm) : 0;
+        };
+        for(size_t sz : sizes){
+            set_shape(ctx, sz, sz, sz);
+            if(skip_partial_tile(ctx))
+                continue;
+            gemm_problem_t<T> prob(ctx);
+            matrix_t<T> c_classical(*prob.C);
+            matrix_t<T> c_strassen(*prob.C);
+            size_t elem = sz*sz;
+            std::vector<double> a64(prob.A->data, prob.A->data + elem);
+            std::vector<double> b64(prob.B->data, prob.B->data + elem);
+            std::vector<double> c64(elem);
+            cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, sz, sz, sz, 1.0,
+                a64.data(), sz, b64.data(), sz, 0.0, c64.data(), sz);
+
+            int loops = sz > 3072 ? 1 : 3;
+            double t_classical = time_best([&](){
+                cblas_sgemm_opt(ctx->layout, ctx->trans_a, ctx->trans_b, sz, sz, sz, ctx->alpha,
+                    prob.A->data, sz, prob.B->data, sz, ctx->beta, c_classical.data, sz, ctx);
+            }, loops);
+            double t_strassen = time_best([&](){
+                sgemm_strassen(ctx->layout, ctx->trans_a, ctx->trans_b, sz, sz, sz, ctx->alpha,
+                    prob.A->data, sz, prob.B->data, sz, ctx->beta, c_strassen.data, sz, ctx);
+            }, loops);
+            double max_classical, max_strassen;
+            double err_classical = error(c_classical.data, c64.data(), elem, max_classical);
+            double err_strassen = error(c_strassen.data, c64.data(), elem, max_strassen);
+            double flop = 2.0*sz*sz*sz;
+            double peak = bench_peak_gflops<T>(ctx, ctx->frequency);
+            double g_classical = flop/(t_classical*1e9);
+            double g_strassen = flop/(t_strassen*1e9);
+            printf(" %4lu %4lu %4lu %6d %7.2f(%5.2f) %7.2f(%5.2f) %8.3f %15.3e %13.3e %14.3e %13.3e\n",
+                sz, sz, sz, sgemm_strassen_levels(sz, sz, sz, ctx),
+                g_classical, g_classical/peak*100, g_strassen, g_strassen/peak*100,
+                t_classical/t_strassen, err_classical, err_strassen, max_classical, max_strassen);
+        }
+        ctx->strassen_cutoff = cutoff;
+    }
+
+    /*
+    * implicit gemm conv vs im2col + cblas_sgemm (openblas, what the models do today) on
+    * resnet like layers, both layout. im2col is the patch matrix in gemm order, its size
+    * and fill time are reported apart. both are checked against a direct 7 loop conv
+    */
+    void conv_bench(gemm_context_t *ctx){
+        struct layer_t { const char * name; int ic, hw, oc, k, stride, pad, dilation; };
+        const layer_t layers[] = {
+            {"conv1_7x7s2", 3, 224, 64, 7, 2, 3, 1},
+            {"res2_1x1", 64, 56, 256, 1, 1, 0, 1},
+            {"res2_3x3", 64, 56, 64, 3, 1, 1, 1},
+            {"res3_3x3", 128, 28, 128, 3, 1, 1, 1},
+            {"res3_3x3s2", 128, 56, 128, 3, 2, 1, 1},
+            {"res4_3x3", 256, 14, 256, 3, 1, 1, 1},
+            {"res4_3x3d2", 256, 14, 256, 3, 1, 2, 2},
+            {"res5_3x3", 512, 7, 512, 3, 1, 1, 1},
+        };
+        dump_ctx(ctx, 0);
+        printf("gflops is 2*oc*oh*ow*ic*kh*kw / time, 1 image\n");
+        printf(" layer        layout    M     N     K  im2col(MB) im2col(ms)  im2col+gemm(%%)  implicit(%%)  speedup  max_err\n");
+        double peak = bench_peak_gflops<T>(ctx, ctx->frequency);
+
+        for(const layer_t & l : layers){
+            for(int lay=0; lay<2; lay++){
+                conv_param_t p;
+                p.layout = lay ? CONV_LAYOUT_NHWC : CONV_LAYOUT_NCHW;
+                p.in_c = l.ic;  p.in_h = p.in_w = l.hw;
+                p.out_c = l.oc; p.kernel_h = p.kernel_w = l.k;
+                p.stride_h = p.stride_w = l.stride;
+                p.pad_h = p.pad_w = l.pad;
+                p.dilation_h = p.dilation_w = l.dilation;
+                int oh = p.out_h(), ow = p.out_w(), K = p.gemm_k();
+                int P = oh*ow;
+                bool nchw = p.layout == CONV_LAYOUT_NCHW;
+                std::vector<T> in((size_t)l.ic*l.hw*l.hw), w((size_t)l.oc*K);
+                std::vector<T> out_ref((size_t)l.oc*P), out_col((size_t)l.oc*P), out_imp((size_t)l.oc*P);
+                std::vector<T> col((size_t)K*P);
+                rand_vector(in.data(), in.size());
+                rand_vector(w.data(), w.size());
+
+                auto in_at = [&](int c, int y, int x) -> T {
+                    if(y < 0 || y >= p.in_h || x < 0 || x >= p.in_w)
+                        return 0;
+                    return nchw ? in[((size_t)c*p.in_h + y)*p.in_w + x] : in[((size_t)y*p.in_w + x)*p.in_c + c];
+                };
+                // weight index of (oc, c, r, s) in OIHW or HWIO
+                auto w_at = [&](int o, int c, int r, int s) -> T {
+                    return nchw ? w[(((size_t)o*p.in_c + c)*p.kernel_h + r)*p.kernel_w + s] :
+                                  w[(((size_t)r*p.kernel_w + s)*p.in_c + c)*p.out_c + o];
+                };
+                for(int o=0; o<l.oc; o++){
+                    for(int y=0; y<oh; y++){
+                        for(int x=0; x<ow; x++){
+                            double acc = 0;
+                            for(int c=0; c<l.ic; c++)
+                                for(int r=0; r<l.k; r++)
+                                    for(int s=0; s<l.k; s++)
+                                        acc += in_at(c, y*l.stride - l.pad + r*l.dilation, x*l.stride - l.pad + s*l.dilation) * w_at(o, c, r, s);
+                            out_ref[nchw ? (size_t)o*P + y*ow + x : ((size_t)y*ow + x)*l.oc + o] = acc;
+                        }
+                    }
+                }
+
+                // patch in the same k order as the implicit path: nchw col[k][pixel], nhwc col[pixel][k]
+                auto im2col_func = [&](){
+                    for(int c=0; c<l.ic; c++)
+                        for(int r=0; r<l.k; r++)
+                            for(int s=0; s<l.k; s++)
+                                for(int y=0; y<oh; y++)
+                                    for(int x=0; x<ow; x++){
+                                        T v = in_at(c, y*l.stride - l.pad + r*l.dilation, x*l.stride - l.pad + s*l.dilation);
+                                        if(nchw)
+                                            col[((size_t)(c*l.k + r)*l.k + s)*P + y*ow + x] = v;
+                                        else
+                                            col[((size_t)y*ow + x)*K + (r*l.k + s)*l.ic + c] = v;
+                                    }
+                };
+                auto col_gemm_func = [&](){
+                    im2col_func();
+                    if(nchw)
+                        cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, l.oc, P, K, 1.f,
+                            w.data(), K, col.data(), P, 0.f, out_col.data(), P);
+                    else
+                        cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, P, l.oc, K, 1.f,
+                            col.data(), K, w.data(), l.oc, 0.f, out_col.data(), l.oc);
+                };
+                auto implicit_func = [&](){
+                    sconv_implicit_gemm(&p, in.data(), w.data(), out_imp.data(), ctx);
+                };
+                double t_im2col = time_best(im2col_func, 5);
+                double t_col = time_best(col_gemm_func, 5);
+                double t_imp = time_best(implicit_func, 5);
+
+                double max_err = 0;
+                for(size_t i=0; i<out_ref.size(); i++){
+                    max_err = MAX(max_err, (double)ABS(out_imp[i] - out_ref[i]));
+                    max_err = MAX(max_err, (double)ABS(out_col[i] - out_ref[i]));
+                }
+                double flop = 2.0*l.oc*P*K;
+                double g_col = flop/(t_col*1e9);
+                double g_imp = flop/(t_imp*1e9);
+                printf(" %-12s %-6s %5d %5d %5d %10.2f %10.3f  %6.2f(%5.2f)  %6.2f(%5.2f) %8.3f %8.1e\n",
+                    l.name, to_conv_layout_str(p.layout), nchw ? l.oc : P, nchw ? P : l.oc, K,
+                    col.size()*sizeof(T)/1048576.0, t_im2col*1e3, g_col, g_col/peak*100,
+                    g_imp, g_imp/peak*100, t_col/t_imp, max_err);
+            }
+        }
+    }
+
+    /*
+    * cgemm (4m on the real micro kernel) vs openblas cblas_cgemm, complex alpha/beta, every
+    * trans/conj of A and B. gflops is 8*M*N*K / time. both are checked against a double loop
+    * on a sample of C, err is max abs diff over max abs C. then a mc x kc sweep of the complex
+    * blocking on one shape, best is what to pass to -mc/-kc (they are halved for complex)
+    */
+    void cgemm_bench(gemm_context_t *ctx){
+        struct shape_t { int m, n, k; };
+        const shape_t shapes[] = {{256, 256, 256}, {510, 500, 333}, {960, 960, 960}, {1536, 96, 1536}};
+        const std::pair<trans_t, trans_t> trans[] = {
+            {TRANS_NO_TRANS, TRANS_NO_TRANS},
+            {TRANS_CONJ_TRANS, TRANS_NO_TRANS},
+            {TRANS_NO_TRANS, TRANS_CONJ_TRANS},
+            {TRANS_TRANS, TRANS_TRANS},
+            {TRANS_CONJ_NO_TRANS, TRANS_CONJ_NO_TRANS},
+        };
+        const float alpha[2] = {0.75f, -0.5f};
+        const float beta[2] = {0.25f, 0.5f};
+        auto tr_str = [](trans_t t){
+            return t == TRANS_NO_TRANS ? "n" : t == TRANS_TRANS ? "t" : t == TRANS_CONJ_TRANS ? "c" : "r";
+        };
+
+        dump_ctx(ctx, 0);
+        printf("trans n no, t trans, c conj trans, r conj no trans. row major\n");
+        printf("    M     N     K  ta tb  openblas(%%)        opt(%%)    speedup    err_ref    err_opt\n");
+        double peak = bench_peak_gflops<T>(ctx, ctx->frequency);
+        for(const shape_t & s : shapes){
+            for(const auto & tr : trans){
+                bool ta = tr.first == TRANS_TRANS || tr.first == TRANS_CONJ_TRANS;
+                bool tb = tr.second == TRANS_TRANS || tr.second == TRANS_CONJ_TRANS;
+                bool ca = tr.first == TRANS_CONJ_TRANS || tr.first == TRANS_CONJ_NO_TRANS;
+                bool cb = tr.second == TRANS_CONJ_TRANS || tr.second == TRANS_CONJ_NO_TRANS;
+                int lda = ta ? s.m : s.k;
+                int ldb = tb ? s.k : s.n;
+                int ldc = s.n;
+                std::vector<float> a((size_t)s.m*s.k*2), b((size_t)s.k*s.n*2), c0((size_t)s.m*s.n*2);
+                std::vector<float> c_ref, c_opt;
+                rand_vector(a.data(), a.size());
+                rand_vector(b.data(), b.size());
+                rand_vector(c0.data(), c0.size());
+
+                auto ref_func = [&](){
+                    c_ref = c0;
+                    cblas_cgemm(CblasRowMajor, to_blas_transpose(tr.first), to_blas_transpose(tr.second),
+                        s.m, s.n, s.k, alpha, a.data(), lda, b.data(), ldb, beta, c_ref.data(), ldc);
+                };
+                auto opt_func = [&](){
+                    c_opt = c0;
+                    cblas_cgemm_opt(LAYOUT_ROW_MAJOR, tr.first, tr.second,
+                        s.m, s.n, s.k, alpha, a.data(), lda, b.data(), ldb, beta, c_opt.data(), ldc, ctx);
+                };
+                double t_ref = time_best(ref_func);
+                double t_opt = time_best(opt_func);
+
+                // every 7th row and 5th col in double
+                double err_ref = 0, err_opt = 0, c_max = 0;
+                for(int i=0; i<s.m; i += 7){
+                    for(int j=0; j<s.n; j += 5){
+                        double sr = 0, si = 0;
+                        for(int p=0; p<s.k; p++){
+                            const float * x = ta ? &a[((size_t)p*lda + i)*2] : &a[((size_t)i*lda + p)*2];
+                            const float * y = tb ? &b[((size_t)j*ldb + p)*2] : &b[((size_t)p*ldb + j)*2];
+                            double xr = x[0], xi = ca ? -x[1] : x[1];
+                            double yr = y[0], yi = cb ? -y[1] : y[1];
+                            sr += xr*yr - xi*yi;
+                            si += xr*yi + xi*yr;
+                        }
+                        size_t o = ((size_t)i*ldc + j)*2;
+                        double cr = c0[o], ci = c0[o+1];
+                        double er = alpha[0]*sr - alpha[1]*si + beta[0]*cr - beta[1]*ci;
+                        double ei = alpha[0]*si + alpha[1]*sr + beta[0]*ci + beta[1]*cr;
+                        c_max = MAX(c_max, MAX(fabs(er), fabs(ei)));
+                        err_ref = MAX(err_ref, MAX(fabs(c_ref[o] - er), fabs(c_ref[o+1] - ei)));
+                        err_opt = MAX(err_opt, MAX(fabs(c_opt[o] - er), fabs(c_opt[o+1] - ei)));
+                    }
+                }
+                double flop = 8.0*s.m*s.n*s.k;
+                double g_ref = flop/(t_ref*1e9);
+                double g_opt = flop/(t_opt*1e9);
+                printf(" %4d  %4d  %4d   %s  %s %7.2f(%5.2f) %7.2f(%5.2f) %8.3f %10.3e %10.3e%s\n",
+                    s.m, s.n, s.k, tr_str(tr.first), tr_str(tr.second),
+                    g_ref, g_ref/peak*100, g_opt, g_opt/peak*100, t_ref/t_opt,
+                    err_ref/c_max, err_opt/c_max, err_opt/c_max < 1e-5 ? "" : "  <- invalid");
+            }
+        }
+
+        // tune: ctx->mc/kc are the real blocking, cgemm use half of each
+        int sz = 960;
+        std::vector<float> a((size_t)sz*sz*2), b((size_t)sz*sz*2), c((size_t)sz*sz*2);
+        rand_vector(a.data(), a.size());
+        rand_vector(b.data(), b.size());
+        size_t mc = ctx->mc, kc = ctx->kc;
+        size_t best_mc = mc, best_kc = kc;
+        double best = 0;
+        printf("mc x kc sweep, %dx%dx%d ca\n", sz, sz, sz);
+        printf("    mc    kc  gflops(%%)\n");
+        for(size_t m : {ctx->mr*8, ctx->mr*16, ctx->mr*32, ctx->mr*64}){
+            for(size_t k : {128, 256, 384, 512, 768}){
+                ctx->mc = m;
+                ctx->kc = k;
+                double t = time_best([&](){
+                    cblas_cgemm_opt(LAYOUT_ROW_MAJOR, TRANS_CONJ_TRANS, TRANS_NO_TRANS,
+                        sz, sz, sz, alpha, a.data(), sz, b.data(), sz, beta, c.data(), sz, ctx);
+                });
+                double g = 8.0*sz*sz*sz/(t*1e9);
+                printf("  %4lu  %4lu %7.2f(%5.2f)\n", m, k, g, g/peak*100);
+                if(g > best){
+                    best = g;
+                    best_mc = m;
+                    best_kc = k;
+                }
+            }
+        }
+        printf("best -mc %lu -kc %lu, %.2f gflops\n", best_mc, best_kc, best);
+        ctx->mc = mc;
+        ctx->kc = kc;
+    }
+
+    /*
+    * ssyrk/ssymm/strmm/strsm against openblas. first every layout/side/uplo/trans/diag on
+    * 2 shapes (the second one several triangle blocks), err is max abs diff over max abs of
+    * the openblas result, then timing on square problems. flop: syrk N*N*K, symm 2*M*M*N
+    * (left), trmm/trsm M*M*N (left) or M*N*N (right). trsm A is made diagonal dominant
+    */
+    void level3_bench(gemm_context_t *ctx){
+        const layout_t layouts[] = {LAYOUT_ROW_MAJOR, LAYOUT_COL_MAJOR};
+        const side_t sides[] = {SIDE_LEFT, SIDE_RIGHT};
+        const uplo_t uplos[] = {UPLO_UPPER, UPLO_LOWER};
+        const trans_t transs[] = {TRANS_NO_TRANS, TRANS_TRANS};
+        const diag_t diags[] = {DIAG_NON_UNIT, DIAG_UNIT};
+        const float alpha = 0.75f, beta = 0.5f;
+        auto rel_err = [](const std::vector<float> & a, const std::vector<float> & ref){
+            double d = 0, m = 0;
+            for(size_t i=0; i<a.size(); i++){
+                d = MAX(d, (double)ABS(a[i] - ref[i]));
+                m = MAX(m, (double)ABS(ref[i]));
+            }
+            return m > 0 ? d/m : d;
+        };
+        auto rand_tri = [](std::vector<float> & a, int n, int ld){
+            rand_vector(a.data(), a.size());
+            for(int i=0; i<n; i++)
+                a[(size_t)i*ld + i] += n;
+        };
+
+        // one call of routine r (0 syrk, 1 symm, 2 trmm, 3 trsm) into out, opt or openblas
+        auto run = [&](int r, bool opt, layout_t lay, side_t side, uplo_t uplo, trans_t tr, diag_t diag,
+                int M, int N, const std::vector<float> & a, int lda, const std::vector<float> & b, int ldb,
+                std::vector<float> & out, int ldc){
+            CBLAS_ORDER o = to_blas_layout(lay);
+            if(r == 0){
+                if(opt) cblas_ssyrk_opt(lay, uplo, tr, M, N, alpha, a.data(), lda, beta, out.data(), ldc, ctx);
+                else cblas_ssyrk(o, to_blas_uplo(uplo), to_blas_transpose(tr), M, N, alpha, a.data(), lda, beta, out.data(), ldc);
+            }else if(r == 1){
+                if(opt) cblas_ssymm_opt(lay, side, uplo, M, N, alpha, a.data(), lda, b.data(), ldb, beta, out.data(), ldc, ctx);
+                else cblas_ssymm(o, to_blas_side(side), to_blas_uplo(uplo), M, N, alpha, a.data(), lda, b.data(), ldb, beta, out.data(), ldc);
+            }else if(r == 2){
+                if(opt) cblas_strmm_opt(lay, side, uplo, tr, diag, M, N, alpha, a.data(), lda, out.data(), ldc, ctx);
+                else cblas_strmm(o, to_blas_side(side), to_blas_uplo(uplo), to_blas_transpose(tr), to_blas_diag(diag), M, N, alpha, a.data(), lda, out.data(), ldc);
+            }else{
+                if(opt) cblas_strsm_opt(lay, side, uplo, tr, diag, M, N, alpha, a.data(), lda, out.data(), ldc, ctx);
+                else cblas_strsm(o, to_blas_side(side), to_blas_uplo(uplo), to_blas_transpose(tr), to_blas_diag(diag), M, N, alpha, a.data(), lda, out.data(), ldc);
+            }
+        };
+        const char * names[] = {"ssyrk", "ssymm", "strmm", "strsm"};
+
+        dump_ctx(ctx, 0);
+        // validation. syrk: M is N, N is K. symm/trmm/trsm: A is M x M (left) or N x N (right)
+        const int shapes[][2] = {{77, 93}, {403, 341}};
+        for(int r=0; r<4; r++){
+            int total = 0, bad = 0;
+            double worst = 0;
+            for(auto & sh : shapes)
+            for(layout_t lay : layouts)
+            for(side_t side : sides)
+            for(uplo_t uplo : uplos)
+            for(trans_t tr : transs)
+            for(diag_t diag : diags){
+                if(r < 2 && diag == DIAG_UNIT)
+                    continue;
+                if(r == 0 && side == SIDE_RIGHT)
+                    continue;
+                if(r == 1 && tr == TRANS_TRANS)
+                    continue;
+                int M = sh[0], N = sh[1];
+                int na = (r == 0) ? M : (side == SIDE_LEFT ? M : N);
+                // stored shape of A (syrk: op(A) is M x N), B/C M x N, or N x N for syrk
+                int a_rows = na, a_cols = na;
+                if(r == 0){
+                    bool ta = tr == TRANS_TRANS;
+                    a_rows = ta ? N : M;
+                    a_cols = ta ? M : N;
+                }
+                int c_rows = M, c_cols = r == 0 ? M : N;
+                bool row = lay == LAYOUT_ROW_MAJOR;
+                int lda = (row ? a_cols : a_rows) + 3;
+                int ldc = (row ? c_cols : c_rows) + 5;
+                int ldb = (row ? N : M) + 1;
+                std::vector<float> a((size_t)lda*(row ? a_rows : a_cols));
+                std::vector<float> b((size_t)ldb*(row ? M : N));
+                std::vector<float> c((size_t)ldc*(row ? c_rows : c_cols));
+                if(r == 3)
+                    rand_tri(a, na, lda);
+                else
+                    rand_vector(a.data(), a.size());
+                rand_vector(b.data(), b.size());
+                rand_vector(c.data(), c.size());
+                std::vector<float> c_ref = c, c_opt = c;
+                run(r, false, lay, side, uplo, tr, diag, M, N, a, lda, b, ldb, c_ref, ldc);
+                run(r, true, lay, side, uplo, tr, diag, M, N, a, lda, b, ldb, c_opt, ldc);
+                double err = rel_err(c_opt, c_ref);
+                worst = MAX(worst, err);
+                total++;
+                if(err > 1e-4){
+                    bad++;
+                    printf("  %s %dx%d %s side:%s uplo:%s trans:%s diag:%s err %.3e  <- invalid\n",
+                        names[r], M, N, row ? "row" : "col", to_side_str(side), to_uplo_str(uplo),
+                        tr == TRANS_NO_TRANS ? "n" : "t", to_diag_str(diag), err);
+                }
+            }
+            printf("%s valid %d/%d, max err %.3e\n", names[r], total-bad, total, worst);
+        }
+
+        printf("row major, side/uplo/trans/diag\n");
+        printf(" routine  s u t d     M     N   openblas(%%)         opt(%%)    speedup      err\n");
+        struct case_t { int r; side_t side; uplo_t uplo; trans_t tr; };
+        const case_t cases[] = {
+            {0, SIDE_LEFT, UPLO_LOWER, TRANS_NO_TRANS},
+            {0, SIDE_LEFT, UPLO_UPPER, TRANS_TRANS},
+            {1, SIDE_LEFT, UPLO_LOWER, TRANS_NO_TRANS},
+            {1, SIDE_RIGHT, UPLO_UPPER, TRANS_NO_TRANS},
+            {2, SIDE_LEFT, UPLO_LOWER, TRANS_NO_TRANS},
+            {2, SIDE_RIGHT, UPLO_UPPER, TRANS_TRANS},
+            {3, SIDE_LEFT, UPLO_LOWER, TRANS_NO_TRANS},
+            {3, SIDE_LEFT, UPLO_UPPER, TRANS_TRANS},
+            {3, SIDE_RIGHT, UPLO_LOWER, TRANS_TRANS},
+        };
+        double peak = bench_peak_gflops<T>(ctx, ctx->frequency);
+        for(int sz : {512, 1024, 2048}){
+            for(const case_t & cs : cases){
+                int M = sz, N = sz;
+                std::vector<float> a((size_t)sz*sz), b((size_t)sz*sz), c((size_t)sz*sz);
+                if(cs.r == 3)
+                    rand_tri(a, sz, sz);
+                else
+                    rand_vector(a.data(), a.size());
+                rand_vector(b.data(), b.size());
+                rand_vector(c.data(), c.size());
+                std::vector<float> c_ref, c_opt;
+                double t_ref = time_best([&](){
+                    c_ref = c;
+                    run(cs.r, false, LAYOUT_ROW_MAJOR, cs.side, cs.uplo, cs.tr, DIAG_NON_UNIT, M, N, a, sz, b, sz, c_ref, sz);
+                });
+                double t_opt = time_best([&](){
+                    c_opt = c;
+                    run(cs.r, true, LAYOUT_ROW_MAJOR, cs.side, cs.uplo, cs.tr, DIAG_NON_UNIT, M, N, a, sz, b, sz, c_opt, sz);
+                });
+                double flop = (cs.r == 1 ? 2.0 : 1.0)*sz*sz*sz;
+                double g_ref = flop/(t_ref*1e9);
+                double g_opt = flop/(t_opt*1e9);
+                printf(" %s  %s %s %s n %5d %5d %7.2f(%5.2f) %7.2f(%5.2f) %8.3f %10.3e\n",
+                    names[cs.r], to_side_str(cs.side), to_uplo_str(cs.uplo), cs.tr == TRANS_NO_TRANS ? "n" : "t",
+                    M, N, g_ref, g_ref/peak*100, g_opt, g_opt/peak*100, t_ref/t_opt, rel_err(c_opt, c_ref));
+            }
+        }
+    }
+
+    /*
+    * online tuning as gemm_blas run it (GEMM_AUTOTUNE=1), on shapes no db has: the same
+    * problem called over and over, the first calls are the trials. default is the ctx
+    * blocking, tuned the converged one. overhead is the time the trials lost against the
+    * final best, % of that many calls at the best, the number the tuner hold under budget.
+    * nothing is written to a db here
+    */
+    void autotune_bench(gemm_context_t *ctx){
+        const size_t shapes[][3] = {{384,384,384}, {96,4096,1024}, {1032,256,2048},
+                {960,960,960}, {2064,2048,512}, {516,3072,1536}};
+        const int calls = 32;
+        size_t mc = ctx->mc, nc = ctx->nc, kc = ctx->kc;
+        sgemm_autotune_config_t cfg;
+        sgemm_autotuner_t tuner(cfg);
+        dump_ctx(ctx, 0);
+        printf("max calls:%d, budget:%.1f%% overhead, calls per shape:%d\n", cfg.max_calls, cfg.budget*100, calls);
+        printf("    M    N    K cands trials conv   mc   nc   kc  default(%%)      tuned(%%)  speedup  overhead(%%)  valid\n");
+        for(const auto & shape : shapes){
+            set_shape(ctx, shape[0], shape[1], shape[2]);
+            if(skip_partial_tile(ctx))
+                continue;
+            ctx->mc = mc;  ctx->nc = nc;  ctx->kc = kc;
+            gemm_problem_t<T> gemm_prob(ctx);
+            bench_result<T> v_def = gemm_prob.run_single_case(cblas_sgemm_opt, true);
+            bench_result<T> r_def = gemm_prob.run_single_case(cblas_sgemm_opt, false);
+
+            std::string key = sgemm_tune_key(ctx);
+            for(int i=0; i<calls; i++){
+                gemm_context_t call_ctx = *ctx;
+                int cand = tuner.begin(key, &call_ctx);
+                double t = current_sec();
+                cblas_sgemm_opt(ctx->layout, ctx->trans_a, ctx->trans_b, ctx->m, ctx->n, ctx->k, ctx->alpha,
+                    gemm_prob.A->data, ctx->lda, gemm_prob.B->data, ctx->ldb,
+                    ctx->beta, gemm_prob.C->data, ctx->ldc, &call_ctx);
+                if(cand >= 0)
+                    tuner.end(key, cand, current_sec() - t);
+            }
+            sgemm_autotune_stats_t st;
+            tuner.stats(key, st);
+            ctx->mc = st.best.mc;  ctx->nc = st.best.nc;  ctx->kc = st.best.kc;
+            bench_result<T> v_tuned = gemm_prob.run_single_case(cblas_sgemm_opt, true);
+            bench_result<T> r_tuned = gemm_prob.run_single_case(cblas_sgemm_opt, false);
+            bool valid = valid_matrix(v_def.c, v_tuned.c, 0.001f);
+            // same overhead the tuner hold under cfg.budget
+            double overhead = st.trials ? st.excess_sec/(st.trials*st.best_sec)*100 : 0;
+            printf(" %4lu %4lu %4lu %5d %6d %4s %4lu %4lu %4lu %6.2f(%5.2f) %6.2f(%5.2f) %8.3f %12.2f  %s\n",
+                ctx->m, ctx->n, ctx->k, st.candidates, st.trials, st.converged ? "yes" : "no",
+                st.best.mc, st.best.nc, st.best.kc, r_def.gflops, r_def.perf, r_tuned.gflops, r_tuned.perf,
+                r_tuned.gflops/r_def.gflops, overhead, valid ? "yes" : "no");
+        }
+        ctx->mc = mc;  ctx->nc = nc;  ctx->kc = kc;
+    }
+
+    /*
+    * pack workspace per call, small to large shapes: bytes sized to the problem vs the full
+    * mc*kc + nc*kc of before, t if from the per thread buffer (h heap), minor page fault and
+    * time per call over many back to back calls, as a server doing small gemm would see
+    */
+    void mem_bench(gemm_context_t *ctx){
+        const size_t shapes[][3] = {{12,16,16}, {48,48,48}, {96,64,128}, {120,128,168},
+                {240,256,256}, {516,512,512}, {960,960,960}};
+        dump_ctx(ctx, 0);
+        printf("    M    N    K  pack(KB)  full(KB)  ratio  flt/call   us/call    gflops\n");
+        for(const auto & shape : shapes){
+            set_shape(ctx, shape[0], shape[1], shape[2]);
+            if(skip_partial_tile(ctx))
+                continue;
+            gemm_problem_t<T> gemm_prob(ctx);
+            int calls = MAX((int)(2e8 / (2.0*ctx->m*ctx->n*ctx->k)), 8);
+            auto call = [&](){
+                cblas_sgemm_opt(ctx->layout, ctx->trans_a, ctx->trans_b, ctx->m, ctx->n, ctx->k, ctx->alpha,
+                    gemm_prob.A->data, ctx->lda, gemm_prob.B->data, ctx->ldb,
+                    ctx->beta, gemm_prob.C->data, ctx->ldc, ctx);
+            };
+            call();
+            sgemm_ws_reset();
+            struct rusage ru0, ru1;
+            getrusage(RUSAGE_SELF, &ru0);
+            double t = current_sec();
+            for(int i=0; i<calls; i++)
+                call();
+            t = (current_sec() - t) / calls;
+            getrusage(RUSAGE_SELF, &ru1);
+            sgemm_ws_stats_t ws = sgemm_ws_last();
+            printf(" %4lu %4lu %4lu %8.1f%s %9.1f %6.3f %9.2f %9.2f %9.2f\n",
+                ctx->m, ctx->n, ctx->k, ws.bytes/1024.0, ws.tls ? "t" : "h", ws.full_bytes/1024.0,
+                ws.full_bytes ? (double)ws.bytes/ws.full_bytes : 0,
+                (double)(ru1.ru_minflt - ru0.ru_minflt)/calls, t*1e6,
+                (double)sgemm_flop(ctx->m,ctx->n,ctx->k,ctx->alpha,ctx->beta)/(t*1e9));
+        }
+    }
+
+    /*
+    * out of core gemm on files under dir, beta 0. disk bandwidth first: A is written with
+    * write()+fsync (write GB/s), dropped from page cache and read back (read GB/s). then every
+    * file is dropped and sgemm_ooc run with mem_mb of budget. io(GB/s) is file bytes moved / time,
+    * io bound(%) the time the disk alone need for those bytes at the measured bandwidth, % of the
+    * run. error on 16 sampled rows of C against a double loop
+    */
+    void ooc_bench(gemm_context_t *ctx, const std::string & dir, size_t mem_mb){
+        const size_t shapes[][3] = {{32768,1024,1024}, {65536,512,256}, {12288,4096,4096}, {20001,1000,999}};
+        size_t budget = mem_mb*1024*1024;
+        std::string fa = dir + "/gemm_ooc_a.bin";
+        std::string fb = dir + "/gemm_ooc_b.bin";
+        std::string fc = dir + "/gemm_ooc_c.bin";
+        dump_ctx(ctx, 0);
+        printf("files in %s, budget %lu MB\n", dir.c_str(), mem_mb);
+        printf("     M    N    K  A/B/C(MB)         mb panels B_res    sec  gflops  io(GB/s) disk r/w(GB/s) io_bound(%%) rss(MB) wait(ms)     err  valid\n");
+
+        // fill a file with random float, return the time of write + fsync
+        auto write_file = [](const std::string & path, size_t count){
+            int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if(fd < 0)
+                return -1.0;
+            std::vector<float> buf(1<<20);
+            double t = current_sec();
+            for(size_t i=0; i<count; i += buf.size()){
+                size_t n = MIN(buf.size(), count - i);
+                rand_vector(buf.data(), n);
+                if(write(fd, buf.data(), n*sizeof(float)) != (ssize_t)(n*sizeof(float))){
+                    close(fd);
+                    return -1.0;
+                }
+            }
+            fsync(fd);
+            t = current_sec() - t;
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            close(fd);
+            return t;
+        };
+        auto drop_file = [](const std::string & path){
+            int fd = open(path.c_str(), O_RDONLY);
+            if(fd >= 0){
+                fdatasync(fd);
+                posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+                close(fd);
+            }
+        };
+        auto read_file = [](const std::string & path){
+            int fd = open(path.c_str(), O_RDONLY);
+            if(fd < 0)
+                return -1.0;
+            std::vector<char> buf(8<<20);
+            double t = current_sec();
+            while(read(fd, buf.data(), buf.size()) > 0)
+                ;
+            t = current_sec() - t;
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            close(fd);
+            return t;
+        };
+
+        for(const auto & shape : shapes){
+            size_t M = shape[0], N = shape[1], K = shape[2];
+            size_t a_bytes = M*K*sizeof(float), b_bytes = K*N*sizeof(float), c_bytes = M*N*sizeof(float);
+            double w_sec = write_file(fa, M*K);
+            if(w_sec < 0 || write_file(fb, K*N) < 0){
+                printf(" %5lu %4lu %4lu  can't write the files in %s\n", M, N, K, dir.c_str());
+                continue;
+            }
+            double r_sec = read_file(fa);
+            double w_bw = a_bytes/w_sec/1e9, r_bw = a_bytes/r_sec/1e9;
+
+            sgemm_ooc_file_t A, B, C;
+            unlink(fc.c_str());
+            if(!sgemm_ooc_open(fa.c_str(), M, K, false, A) || !sgemm_ooc_open(fb.c_str(), K, N, false, B) ||
+                    !sgemm_ooc_open(fc.c_str(), M, N, true, C)){
+                sgemm_ooc_close(A);  sgemm_ooc_close(B);  sgemm_ooc_close(C);
+                continue;
+            }
+            drop_file(fa);  drop_file(fb);
+            sgemm_ooc_stats_t st;
+            sgemm_ooc(M, N, K, 1.f, A, B, 0.f, C, budget, ctx, &st);
+
+            double err = 0;
+            for(size_t s=0; s<16; s++){
+                size_t i = (s*(M-1))/15;
+                for(size_t j=0; j<N; j++){
+                    double ref = 0;
+                    for(size_t p=0; p<K; p++)
+                        ref += (double)A.data[i*K+p] * B.data[p*N+j];
+                    err = MAX(err, fabs(C.data[i*N+j] - ref) / MAX(fabs(ref), 1.0));
+                }
+            }
+            double io_bytes = st.read_bytes + st.write_bytes;
+            double io_sec = st.read_bytes/(r_bw*1e9) + st.write_bytes/(w_bw*1e9);
+            printf(" %5lu %4lu %4lu %4lu/%3lu/%4lu %9lu %6lu %5s %6.2f %7.2f %9.3f %6.2f/%-6.2f %12.1f %7.1f %8.1f %7.1e  %s\n",
+                M, N, K, a_bytes>>20, b_bytes>>20, c_bytes>>20, st.panel_rows, st.panels,
+                st.b_resident ? "yes" : "no", st.sec, 2.0*M*N*K/(st.sec*1e9), io_bytes/st.sec/1e9,
+                r_bw, w_bw, io_sec/st.sec*100, st.rss_peak/1048576.0, st.wait_sec*1e3, err,
+                err < 1e-3 ? "yes" : "no");
+            sgemm_ooc_close(A);  sgemm_ooc_close(B);  sgemm_ooc_close(C);
+            unlink(fa.c_str());  unlink(fb.c_str());  unlink(fc.c_str());
+        }
+    }
+
+    /*
+    * pipelined pack vs normal. pack is the helper time in sgemm_pack, wait the time the
+    * compute thread spin for a packed stage, hidden = 1 - wait/pack, clamped to 0~1, is the
+    * part of pack latency taken off the compute thread. pipe is checked bit exact against normal
+    */
+    void pipe_bench(gemm_context_t *ctx){
+        bool pipe = ctx->pipe;
+        const size_t shapes[][3] = {{384,384,384}, {96,4096,1024}, {516,1024,336},
+                {960,960,960}, {2064,2048,1024}, {3096,3072,3072}};
+        dump_ctx(ctx, 0);
+        printf("    M    N    K stages helper   normal(%%)       pipe(%%)  speedup  pack(ms)  wait(ms)  hidden(%%)  valid\n");
+        for(const auto & shape : shapes){
+            set_shape(ctx, shape[0], shape[1], shape[2]);
+            if(skip_partial_tile(ctx))
+                continue;
+            gemm_problem_t<T> gemm_prob(ctx);
+            ctx->pipe = false;
+            bench_result<T> v_normal = gemm_prob.run_single_case(cblas_sgemm_opt, true);
+            bench_result<T> r_normal = gemm_prob.run_single_case(cblas_sgemm_opt, false);
+            ctx->pipe = true;
+            bench_result<T> v_pipe = gemm_prob.run_single_case(cblas_sgemm_opt, true);
+            bench_result<T> r_pipe = gemm_prob.run_single_case(cblas_sgemm_opt, false);
+            bool valid = valid_matrix(v_normal.c, v_pipe.c, 0.f);
+
+            // one more timed call for the breakdown, C is scratch here
+            sgemm_pipe_stats_t stats;
+            sgemm_n_nn_pipe(ctx->m, ctx->n, ctx->k, ctx->alpha,
+                gemm_prob.A->data, ctx->lda, gemm_prob.B->data, ctx->ldb,
+                ctx->beta, gemm_prob.C->data, ctx->ldc, ctx, &stats);
+            // wait also count the helper startup and hand off, can be more than the pack itself
+            double hidden = stats.pack_sec > 0 ? MAX(0.0, MIN(1.0, 1 - stats.wait_sec/stats.pack_sec))*100 : 0;
+            std::string helper = stats.helper_cpu >= 0 ? std::to_string(stats.helper_cpu) : "-";
+            printf(" %4lu %4lu %4lu %6d %6s %6.2f(%5.2f) %6.2f(%5.2f) %8.3f %9.3f %9.3f %10.1f  %s\n",
+                ctx->m, ctx->n, ctx->k, stats.stages, helper.c_str(),
+                r_normal.gflops, r_normal.perf, r_pipe.gflops, r_pipe.perf, r_pipe.gflops/r_normal.gflops,
+                stats.pack_sec*1e3, stats.wait_sec*1e3, hidden, valid ? "yes" : "no");
+        }
+        ctx->pipe = pipe;
+    }
+
+    /*
+    * c_acc mode (packed C accumulator across kc blocks) vs normal on large K shapes.
+    * beta 1 so the normal path really read C back every kc block. c_acc is validated
+    * against the normal path
+    */
+    void cacc_bench(gemm_context_t *ctx){
+        bool c_acc = ctx->c_acc;
+        const size_t shapes[][3] = {{96,1536,8192}, {384,768,3072}, {516,1024,4096},
+                {1032,1536,6144}, {1536,1536,1536}, {3096,3072,3072}};
+        ctx->beta = 1;
+        dump_ctx(ctx, 0);
+        printf("    M    N    K   mc   nc   kc nc_acc  acc_kb   normal(%%)      c_acc(%%)  speedup  valid\n");
+        for(const auto & shape : shapes){
+            set_shape(ctx, shape[0], shape[1], shape[2]);
+            if(skip_partial_tile(ctx))
+                continue;
+            gemm_problem_t<T> gemm_prob(ctx);
+            ctx->c_acc = false;
+            bench_result<T> v_normal = gemm_prob.run_single_case(cblas_sgemm_opt, true);
+            bench_result<T> r_normal = gemm_prob.run_single_case(cblas_sgemm_opt, false);
+            ctx->c_acc = true;
+            bench_result<T> v_acc = gemm_prob.run_single_case(cblas_sgemm_opt, true);
+            bench_result<T> r_acc = gemm_prob.run_single_case(cblas_sgemm_opt, false);
+            bool valid = valid_matrix(v_normal.c, v_acc.c, 0.001f);
+            size_t nc_acc = sgemm_c_acc_nc(ctx);
+            printf(" %4lu %4lu %4lu %4lu %4lu %4lu %6lu %7lu %6.2f(%5.2f) %6.2f(%5.2f) %8.3f  %s\n",
+                ctx->m, ctx->n, ctx->k, ctx->mc, ctx->nc, ctx->kc, nc_acc,
+                ctx->mc*nc_acc*sizeof(T)/1024, r_normal.gflops, r_normal.perf, r_acc.gflops, r_acc.perf,
+                r_acc.gflops/r_normal.gflops, valid ? "yes" : "no");
+        }
+        ctx->c_acc = c_acc;
+    }
+
+    /*
+    * ragged and skinny shapes as libgemm_opt.so run them: the M0 x N0 full tile part by
+    * cblas_sgemm_opt, the M%mr rows / N%nr columns zero padded by sgemm_n_nn_edge, against the
+    * plain i-k-j loop the edges used before and openblas. N<nr or M<mr is edge only. err is max
+    * abs diff over max abs of the openblas result
+    */
+    void edge_bench(gemm_context_t *ctx){
+        const int shapes[][3] = {{2000,1,512}, {2000,7,512}, {512,15,512}, {1,2048,1024},
+                {4,2048,512}, {2,2048,1024}, {13,35,64}, {96,100,2048}, {1001,1003,500}};
+        const float alpha = 1.f, beta = 0.5f;
+        gemm_context_t ectx = *ctx;
+        ectx.numa_mode = NUMA_MODE_OFF;
+        ectx.steal = false;
+        dump_ctx(ctx, 0);
+        printf("    M    N    K   M0   N0   plain(gflops)   opt(gflops) openblas(gflops)  speedup(plain)   err_opt\n");
+        for(const auto & shape : shapes){
+            int M = shape[0], N = shape[1], K = shape[2];
+            int M0 = M - M % ctx->mr;
+            int N0 = N - N % ctx->nr;
+            std::vector<float> a((size_t)M*K), b((size_t)K*N), c((size_t)M*N), c_ref, c_opt, c_plain;
+            rand_vector(a.data(), a.size());
+            rand_vector(b.data(), b.size());
+            rand_vector(c.data(), c.size());
+            c_ref = c_opt = c_plain = c;
+            auto plain = [&](){
+                for(int i=0; i<M; i++){
+                    float * c_row = c_plain.data() + (size_t)i*N;
+                    for(int j=0; j<N; j++)
+                        c_row[j] *= beta;
+                    for(int p=0; p<K; p++){
+                        float ap = alpha * a[(size_t)i*K + p];
+                        const float * b_row = b.data() + (size_t)p*N;
+                        for(int j=0; j<N; j++)
+                            c_row[j] += ap * b_row[j];
+                    }
+                }
+            };
+            auto opt = [&](){
+                if(M0 && N0){
+                    ectx.m = M0;  ectx.n = N0;  ectx.k = K;
+                    ectx.lda = K;  ectx.ldb = N;  ectx.ldc = N;
+                    cblas_sgemm_opt(LAYOUT_ROW_MAJOR, TRANS_NO_TRANS, TRANS_NO_TRANS, M0, N0, K,
+                        alpha, a.data(), K, b.data(), N, beta, c_opt.data(), N, &ectx);
+                }
+                sgemm_n_nn_edge(M, N, K, M0, N0, alpha, a.data(), K, b.data(), N, beta, c_opt.data(), N, &ectx);
+            };
+            auto ref = [&](){
+                cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, M, N, K,
+                    alpha, a.data(), K, b.data(), N, beta, c_ref.data(), N);
+            };
+            // one call from the same C for the error, then timing on scratch C
+            opt();
+            ref();
+            double d = 0, m = 0;
+            for(size_t i=0; i<c.size(); i++){
+                d = MAX(d, (double)ABS(c_opt[i] - c_ref[i]));
+                m = MAX(m, (double)ABS(c_ref[i]));
+            }
+            double err = m > 0 ? d/m : d;
+            double flop = 2.0*M*N*K;
+            double t_plain = time_best(plain);
+            double t_opt = time_best(opt);
+            double t_ref = time_best(ref);
+            printf(" %4d %4d %4d %4d %4d %15.2f %13.2f %16.2f %15.2f %9.1e\n",
+                M, N, K, M0, N0, flop/t_plain/1e9, flop/t_opt/1e9, flop/t_ref/1e9, t_plain/t_opt, err);
+        }
+    }
+
+    // normal vs streaming store of C, beta is forced to 0. dram traffic of C is
+    // estimated (normal: RFO read + writeback, nt: writeback only), and measured as
+    // llc miss * cacheline if perf counter is available
+    void ntstore_bench(gemm_context_t *ctx){
+        bool nt_store = ctx->nt_store;
+        ctx->beta = 0;
+        dump_ctx(ctx, 0);
+        size_t c_bytes = ctx->m*ctx->n*sizeof(T);
+        printf("C:%s, L3:%s, K:%lu, kc:%lu\n", byte_2_str(c_bytes).c_str(),
+            byte_2_str(ctx->l3_size).c_str(), ctx->k, ctx->kc);
+        printf("    M    N    K   mc   nc   kc nt_store   gflops(%%)  time(ms)  c_traffic(est)  llc_miss(bytes)\n");
+
+        int loops = 4;
+        for(int nt=0; nt<2; nt++){
+            ctx->nt_store = nt ? true : false;
+            gemm_problem_t<T> gemm_prob(ctx);
+            bool selected = sgemm_use_nt_store(ctx->m, ctx->n, ctx->k, ctx->beta,
+                                gemm_prob.C->data, ctx->ldc, ctx);
+            if(nt && !selected)
+                printf("  streaming store not selected (need beta==0, K<=kc, C aligned to vector width, C > %dx L3)\n",
+                    NT_STORE_C_L3_RATIO);
+            auto gemm_func = [&](){
+                cblas_sgemm_opt(ctx->layout, ctx->trans_a, ctx->trans_b,
+                    ctx->m, ctx->n, ctx->k, ctx->alpha,
+                    gemm_prob.A->data, ctx->lda, gemm_prob.B->data, ctx->ldb,
+                    ctx->beta, gemm_prob.C->data, ctx->ldc, ctx);
+            };
+            gemm_func();    // warm up
+
+            perf_counter_t llc_miss(PERF_EVENT_LLC_MISS);
+            llc_miss.start();
+            double start_time = current_sec();
+            for(int i=0;i<loops;i++)
+                gemm_func();
+            double cost_per_loop = (current_sec()-start_time) / loops;
+            unsigned long long misses = llc_miss.stop() / loops;
+
+            double gflops = (double)sgemm_flop(ctx->m,ctx->n,ctx->k,ctx->alpha,ctx->beta)/(cost_per_loop*1e9);
+            size_t c_traffic = selected ? c_bytes : 2*c_bytes;
+            std::string miss_str = llc_miss.valid() ? byte_2_str(misses*ctx->cacheline_size) : "n/a";
+            printf(" %4lu %4lu %4lu %4lu %4lu %4lu %8s %6.2f(%2.2f) %9.3f %15s %16s\n",
+                ctx->m, ctx->n, ctx->k, ctx->mc, ctx->nc, ctx->kc, selected ? "yes":"no",
+                gflops, gflops/bench_peak_gflops<T>(ctx, ctx->frequency)*100, cost_per_loop*1e3,
+                byte_2_str(c_traffic).c_str(), miss_str.c_str());
+        }
+        ctx->nt_store = nt_store;
+    }
 };
 
 
@@ -1037,7 +2764,7 @@ int main(int argc, char ** argv){
     args.insert_arg("ldc", "leading dimension of c", "576");
     args.insert_arg("a", "ALPHA value of gemm, double", "1.0");
     args.insert_arg("b", "BETA value of gemm, double", "0");
-    args.insert_arg("f", "CPU frequency, in MHz, double", "2600");
+    args.insert_arg("f", "CPU frequency in MHz for peak. 0 measure the core clock of every timed loop", "0");
 
     args.insert_arg("tune", "tuning blocking params", "0");
     args.insert_arg("use_tuned", "use previously tuned db. if file not exist, ignore", "1");
@@ -1047,19 +2774,45 @@ int main(int argc, char ** argv){
     args.insert_arg("align", "memory alignment for matrix, in byte", std::to_string(MEM_ALIGN_BYTE));
     args.insert_arg("valid", "validate the result", "0");
     args.insert_arg("no_ref", "do not run reference blas", "0");
-    args.insert_arg("cpu", "run on which cpu", "2"); // TODO: cpu_list
-    //args.insert_arg("bench", "benchmark mode, for all config", "1");
+    args.insert_arg("cpu", "cpu list like 0-3,8. first run the single thread bench, more than one restrict worker cpus", "2");
+    args.insert_arg("place", "worker placement in a numa node, compact|core|smt (smt: siblings share one packed A)", "compact");
+    args.insert_arg("bench", "benchmark mode, gemm|numa|ntstore|cacc|edge|pipe|steal|conv|cgemm|level3|autotune|mem|ooc|strassen|kernel|ukernel|pack|plan|suite", "gemm");
+    args.insert_arg("suite", ("shape sets for -bench suite, comma list of " + bench_shape_set_names()).c_str(), "all");
+    args.insert_arg("repeat", "samples per shape for -bench suite", "10");
+    args.insert_arg("ooc_dir", "directory of the operand files of -bench ooc", "/tmp");
+    args.insert_arg("ooc_mem", "memory budget of -bench ooc in MB", "64");
+    args.insert_arg("out", "write -bench suite report, .json for json, else csv, - for stdout", "");
+    args.insert_arg("baseline", "compare -bench suite against a csv report, exit non zero on regression", "");
+    args.insert_arg("threshold", "allowed gflops drop in % vs baseline, if the baseline row has none", "5");
+    args.insert_arg("cache", "operand reuse between bench loops, warm|cold(clflush)|rotating(sets > 2x L3)", "warm");
+    args.insert_arg("c_offset", "C start this many float after an aligned address, like a sub-matrix view", "0");
+    args.insert_arg("plan", "create a plan once per problem and time only its execute, see gemm_plan.h", "0");
+    args.insert_arg("nt_store", "streaming store C if beta==0, K<=kc and C >> L3", "1");
+    args.insert_arg("strassen", "strassen layer cutoff, recurse while M/N/K half >= this. 0 off", "0");
+    args.insert_arg("pipe", "pack next A/B block on a helper thread (smt sibling) while current one is computed", "0");
+    args.insert_arg("c_acc", "K > kc accumulate C in a packed tile ordered L2 buffer, write back to C once", "0");
+    args.insert_arg("threads", "number of threads, used when numa is not off or steal is 1", "1");
+    args.insert_arg("steal", "multi thread by work stealing over C macro tiles, need threads > 1", "0");
+    args.insert_arg("numa", "multi thread mode, off|shared|replicate", "off");
     args.insert_arg("mc", "MC", std::to_string(BLOCK_M));
     args.insert_arg("nc", "NC", std::to_string(BLOCK_N));
     args.insert_arg("kc", "KC", std::to_string(BLOCK_K));
     args.insert_arg("mr", "MR", std::to_string(MR));
     args.insert_arg("nr", "NR", std::to_string(NR));
+    args.insert_arg("kernel", "registered micro kernel by name, e.g. asm_6x16, intrin_avx512_12x32. auto pick best tier by cpuid", "auto");
+    args.insert_arg("jit", "use runtime generated micro kernel of mr*nr, else built-in asm 6x16", "0");
+    args.insert_arg("isa", "jit kernel isa, avx2|avx512", "avx2");
+    args.insert_arg("unroll", "jit kernel k unroll, power of 2", "4");
+    args.insert_arg("prefetch", "jit kernel prefetch distance in k iteration, 0 to disable", "4");
+    args.insert_arg("tune_kernel", "also search jit kernel param (mr/nr/unroll/prefetch/isa) when tuning", "0");
     args.insert_arg("l1_size", "l1d cache size", std::to_string(L1_SIZE));
     args.insert_arg("l2_size", "l2 cache size", std::to_string(L2_SIZE));
     args.insert_arg("l3_size", "l3 cache size", std::to_string(L3_SIZE));
     args.insert_arg("cacheline_size", "cache line size", std::to_string(CACHELINE_SIZE));
     args.insert_arg("page_size","page size", std::to_string(PAGE_SIZE));
     args.insert_arg("tlb_entry_l1d","l1d tlb entry", std::to_string(L1D_TLB_ENTRY));
+    args.insert_arg("tlb_entry_l1d_huge","l1d tlb entry for 2M page", std::to_string(L1D_TLB_ENTRY_HUGE));
+    args.insert_arg("huge_page","back pack buffer with 2M page (hugetlb, or thp fallback)", "0");
 
     if(!args.parse(argc-1, argv+1)) return -1;
     //args.dump_parsed();
@@ -1079,6 +2832,7 @@ int main(int argc, char ** argv){
     double freq = args.get_arg<double>("f");
 
     bool tune  = (args.get_arg<int>("tune")==1)?true:false;
+    bool tune_kernel = (args.get_arg<int>("tune_kernel")==1)?true:false;
     bool use_tuned  = (args.get_arg<int>("use_tuned")==1)?true:false;
 #if 0
     if(args.used_arg("mc") || args.used_arg("nc") || args.used_arg("kc") 
@@ -1096,24 +2850,68 @@ int main(int argc, char ** argv){
     bool valid = (args.get_arg<int>("valid")==1) ? true:false;
     //bool is_bench = (args.get_arg<int>("bench")==1) ? true:false;
     bool no_ref = (args.get_arg<int>("no_ref") == 1) ? true:false;
-    int cpu = args.get_arg<int>("cpu");
+    std::vector<int> cpu_list;
+    parse_cpu_list(args.get_arg_str("cpu"), cpu_list);
+    if(cpu_list.empty()){
+        std::cerr<<"invalid -cpu "<<args.get_arg_str("cpu")<<std::endl;
+        return -1;
+    }
+    place_t place = args.get_arg_choice<place_t>("place", {
+                        {"compact", PLACE_COMPACT}, {"core", PLACE_CORE}, {"smt", PLACE_SMT}});
     int mc = args.get_arg<int>("mc");
     int nc = args.get_arg<int>("nc");
     int kc = args.get_arg<int>("kc");
     int mr = args.get_arg<int>("mr");
     int nr = args.get_arg<int>("nr");
+    std::string kernel = args.get_arg_str("kernel");
+    bool jit = (args.get_arg<int>("jit")==1) ? true:false;
+    sgemm_jit_config_t jit_cfg;
+    jit_cfg.mr = mr;
+    jit_cfg.nr = nr;
+    jit_cfg.unroll = args.get_arg<int>("unroll");
+    jit_cfg.prefetch = args.get_arg<int>("prefetch");
+    jit_cfg.isa = args.get_arg_choice<sgemm_isa_t>("isa", {
+                        {"avx2", SGEMM_ISA_AVX2},
+                        {"avx512", SGEMM_ISA_AVX512}
+                    });
     int l1_size = args.get_arg<int>("l1_size");
     int l2_size = args.get_arg<int>("l2_size");
     int l3_size = args.get_arg<int>("l3_size");
     int cacheline_size = args.get_arg<int>("cacheline_size");
     int page_size = args.get_arg<int>("page_size");
     int tlb_entry_l1d = args.get_arg<int>("tlb_entry_l1d");
+    int tlb_entry_l1d_huge = args.get_arg<int>("tlb_entry_l1d_huge");
+    bool huge_page = (args.get_arg<int>("huge_page")==1) ? true:false;
+    std::string bench = args.get_arg_str("bench");
+    std::string suite = args.get_arg_str("suite");
+    int repeat = args.get_arg<int>("repeat");
+    std::string ooc_dir = args.get_arg_str("ooc_dir");
+    size_t ooc_mem = args.get_arg<int>("ooc_mem");
+    std::string out = args.get_arg_str("out");
+    std::string baseline = args.get_arg_str("baseline");
+    double threshold = args.get_arg<double>("threshold");
+    bool nt_store = (args.get_arg<int>("nt_store")==1) ? true:false;
+    bool c_acc = (args.get_arg<int>("c_acc")==1) ? true:false;
+    bool pipe = (args.get_arg<int>("pipe")==1) ? true:false;
+    bool steal = (args.get_arg<int>("steal")==1) ? true:false;
+    int strassen = args.get_arg<int>("strassen");
+    int c_offset = args.get_arg<int>("c_offset");
+    bool plan = (args.get_arg<int>("plan")==1) ? true:false;
+    bench_cache_t bench_cache = args.get_arg_choice<bench_cache_t>("cache", {
+                        {"warm", BENCH_CACHE_WARM},
+                        {"cold", BENCH_CACHE_COLD},
+                        {"rotating", BENCH_CACHE_ROTATING}
+                    });
+    int threads = args.get_arg<int>("threads");
+    numa_mode_t numa_mode = args.get_arg_choice<numa_mode_t>("numa", {
+                        {"off", NUMA_MODE_OFF},
+                        {"shared", NUMA_MODE_SHARED},
+                        {"replicate", NUMA_MODE_REPLICATE}
+                    });
 
     std::vector<int> affinity;
-    affinity.push_back(cpu);
-    set_current_affinity(affinity); // TODO: need disable intel HT
-    std::vector<int> current_aff;
-    get_current_affinity(current_aff);
+    affinity.push_back(cpu_list[0]);
+    set_current_affinity(affinity);
 
     // construct the ctx
     gemm_context_t gemm_ctx;
@@ -1135,8 +2933,37 @@ int main(int argc, char ** argv){
     gemm_ctx.kc = kc;
     gemm_ctx.mr = mr;
     gemm_ctx.nr = nr;
+    if(!jit){
+        const sgemm_kernel_desc_t * desc = (kernel == "auto") ?
+                        sgemm_kernel_best() : sgemm_kernel_find(kernel.c_str());
+        if(!desc && kernel == "auto"){
+            std::cerr<<"no micro kernel for this cpu, need at least sse4.2"<<std::endl;
+            return -1;
+        }
+        if(!desc){
+            std::cerr<<"no such kernel "<<kernel<<", available:";
+            for(int i=0;i<sgemm_kernel_count();i++)
+                std::cerr<<" "<<sgemm_kernel_get(i)->name;
+            std::cerr<<std::endl;
+            return -1;
+        }
+        if(!sgemm_set_kernel(&gemm_ctx, desc)){
+            std::cerr<<"kernel "<<kernel<<" need "<<sgemm_isa_str(desc->isa)<<", not on this cpu"<<std::endl;
+            return -1;
+        }
+        gemm_ctx.mc = CEIL_WRAP(mc, gemm_ctx.mr);
+        gemm_ctx.nc = CEIL_WRAP(nc, gemm_ctx.nr);
+    }
+    if(jit){
+        if(!sgemm_set_jit_kernel(&gemm_ctx, &jit_cfg)){
+            std::cerr<<"jit kernel "<<jit_cfg.to_str()<<" not valid on this cpu"<<std::endl;
+            return -1;
+        }
+        gemm_ctx.mc = CEIL_WRAP(mc, mr);
+        gemm_ctx.nc = CEIL_WRAP(nc, nr);
+    }
 
-    gemm_ctx.cpu_list   = current_aff; // TODO: multiple thread
+    gemm_ctx.cpu_list   = cpu_list;
     gemm_ctx.l1_size    = l1_size;
     gemm_ctx.l2_size    = l2_size;
     gemm_ctx.l3_size    = l3_size;
@@ -1144,19 +2971,89 @@ int main(int argc, char ** argv){
     gemm_ctx.tlb_entry_l1d  = tlb_entry_l1d;
     gemm_ctx.cacheline_size = cacheline_size;
     gemm_ctx.page_size      = page_size;
+    gemm_ctx.tlb_entry_l1d_huge = tlb_entry_l1d_huge;
+    if(huge_page){
+        // page_size follow what the pack buffer really get
+        gemm_ctx.huge_page = huge_page_probe();
+        if(gemm_ctx.huge_page == HUGE_PAGE_NONE)
+            std::cerr<<"no hugetlb page reserved and thp disabled, use "<<page_size<<" page"<<std::endl;
+        else
+            gemm_ctx.page_size = HUGE_PAGE_SIZE;
+    }
 
-    gemm_ctx.frequency = freq;
+    // no -f, start from a probe of the kernel isa, every timed loop measure its own
+    gemm_ctx.freq_measure = freq <= 0;
+    gemm_ctx.frequency = gemm_ctx.freq_measure ? freq_probe_mhz(gemm_ctx.kernel_isa()) : freq;
+
+    gemm_ctx.nt_store  = nt_store;
+    gemm_ctx.c_acc     = c_acc;
+    gemm_ctx.pipe      = pipe;
+    gemm_ctx.strassen_cutoff = strassen > 0 ? strassen : 0;
+    gemm_ctx.bench_cache = bench_cache;
+    gemm_ctx.c_offset  = c_offset;
+    gemm_ctx.plan      = plan;
+    gemm_ctx.numa_mode = numa_mode;
+    gemm_ctx.threads   = threads;
+    gemm_ctx.steal     = steal;
+    gemm_ctx.place     = place;
+    if(gemm_ctx.num_threads() > 1 && place != PLACE_SMT){
+        // siblings that do not share a packed A split the L2 of their core
+        std::vector<numa_node_t> nodes;
+        std::vector<numa_worker_t> workers;
+        numa_discover_nodes(nodes);
+        numa_assign_workers(nodes, threads, workers, place,
+            cpu_list.size() > 1 ? cpu_list : std::vector<int>());
+        gemm_ctx.smt_share = MAX(workers_per_core(workers), (size_t)1);
+    }
 
     //int current_cpu = get_current_cpu();
     //printf("current runing on cpu %d\n", current_cpu);
 
-    // force single thread openblas
+    // force single thread openblas, or same threads as opt in multi thread mode
     //if(!no_ref)
-    openblas_set_num_threads(1);
+    openblas_set_num_threads(gemm_ctx.num_threads());
 
     gemm_bench<float> gb;
     if(tune){
-        gb.tune(&gemm_ctx);
+        gb.tune(&gemm_ctx, tune_kernel);
+    }else if(bench == "numa"){
+        gb.numa_bench(&gemm_ctx, use_tuned);
+    }else if(bench == "ntstore"){
+        gb.ntstore_bench(&gemm_ctx);
+    }else if(bench == "cacc"){
+        gb.cacc_bench(&gemm_ctx);
+    }else if(bench == "edge"){
+        gb.edge_bench(&gemm_ctx);
+    }else if(bench == "conv"){
+        gb.conv_bench(&gemm_ctx);
+    }else if(bench == "cgemm"){
+        gb.cgemm_bench(&gemm_ctx);
+    }else if(bench == "level3"){
+        gb.level3_bench(&gemm_ctx);
+    }else if(bench == "autotune"){
+        gb.autotune_bench(&gemm_ctx);
+    }else if(bench == "mem"){
+        gb.mem_bench(&gemm_ctx);
+    }else if(bench == "ooc"){
+        gb.ooc_bench(&gemm_ctx, ooc_dir, ooc_mem);
+    }else if(bench == "steal"){
+        gb.steal_bench(&gemm_ctx);
+    }else if(bench == "pipe"){
+        gb.pipe_bench(&gemm_ctx);
+    }else if(bench == "strassen"){
+        gb.strassen_bench(&gemm_ctx);
+    }else if(bench == "kernel"){
+        gb.kernel_bench(&gemm_ctx);
+    }else if(bench == "ukernel"){
+        gb.ukernel_bench(&gemm_ctx);
+    }else if(bench == "pack"){
+        gb.pack_bench(&gemm_ctx);
+    }else if(bench == "plan"){
+        gb.plan_bench(&gemm_ctx, use_tuned);
+    }else if(bench == "suite"){
+        int regressions = gb.suite_bench(&gemm_ctx, suite, repeat, no_ref, use_tuned,
+                                out, baseline, threshold);
+        return regressions == 0 ? 0 : 1;
     }else
         gb.run(&gemm_ctx, valid, no_ref, one_shot, use_tuned);
 
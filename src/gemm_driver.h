@@ -2,6 +2,8 @@
 #define __GEMM_DRIVER_H
 
 #include "util.h"
+#include "topology.h"
+#include "kernel/sgemm_jit.h"
 
 #include <stddef.h>
 #include <stdlib.h>
@@ -40,6 +42,19 @@ typedef enum {
     IDENT_B_MATRIX
 }identifier_t;
 
+typedef enum {
+    NUMA_MODE_OFF = 0,      // single thread
+    NUMA_MODE_SHARED,       // multi thread, all threads share one packed B panel
+    NUMA_MODE_REPLICATE     // multi thread, one packed B panel per numa node, M split across nodes
+}numa_mode_t;
+
+// how the benchmark reuse A/B/C between loops, not used by gemm itself
+typedef enum {
+    BENCH_CACHE_WARM = 0,   // same A/B/C every loop, small problem run from L2/L3
+    BENCH_CACHE_COLD,       // clflush A/B/C before every loop, flush not timed
+    BENCH_CACHE_ROTATING    // cycle a pool of A/B/C sets, pool larger than 2x L3
+}bench_cache_t;
+
 // cblas helper function
 static inline CBLAS_ORDER to_blas_layout(layout_t layout){
     if(layout == LAYOUT_ROW_MAJOR)
@@ -71,6 +86,26 @@ static inline const char * to_layout_str(layout_t layout){
     return "n/a major";
 }
 
+static inline const char * to_numa_mode_str(numa_mode_t mode){
+    if(mode == NUMA_MODE_OFF)
+        return "off";
+    if(mode == NUMA_MODE_SHARED)
+        return "shared";
+    if(mode == NUMA_MODE_REPLICATE)
+        return "replicate";
+    return "n/a numa";
+}
+
+static inline const char * to_bench_cache_str(bench_cache_t cache){
+    if(cache == BENCH_CACHE_WARM)
+        return "warm";
+    if(cache == BENCH_CACHE_COLD)
+        return "cold";
+    if(cache == BENCH_CACHE_ROTATING)
+        return "rotating";
+    return "n/a cache";
+}
+
 static inline const char * to_trans_str(trans_t trans){
     if(trans == TRANS_NO_TRANS)
         return "CblasNoTrans";
@@ -109,19 +144,62 @@ public:
     size_t      mr;
     size_t      nr;
 
+// micro kernel, set by sgemm_set_kernel()/sgemm_set_jit_kernel(). nullptr use the built-in asm 6x16,
+// which need avx2+fma, so set one from sgemm_kernel_best() on unknown host
+    const sgemm_kernel_desc_t * kernel_desc {nullptr};  // registered kernel, nullptr if jit or default
+    bool                    jit {false};
+    sgemm_jit_config_t      jit_cfg;
+    sgemm_micro_kernel_t    micro_kernel {nullptr};
+    sgemm_micro_kernel_t    micro_kernel_nt {nullptr};  // streaming store pair of micro_kernel
+    size_t                  kernel_vector_bytes {32};   // C alignment needed by micro_kernel_nt
+
+    sgemm_isa_t kernel_isa() const {
+        if(jit)
+            return jit_cfg.isa;
+        if(kernel_desc)
+            return kernel_desc->isa;
+        return SGEMM_ISA_AVX2;
+    }
+
 // hw parameters
     //size_t      cpu_id;
     size_t      l1_size;
     size_t      l2_size;
     size_t      l3_size;
     size_t      tlb_entry_l1d;
+    size_t      tlb_entry_l1d_huge; // l1d tlb entry for 2M page, separate array on intel
     size_t      cacheline_size;
-    size_t      page_size;
-    std::vector<int>    cpu_list;
+    size_t      page_size;          // backing page size of pack buffers
+    huge_page_t huge_page {HUGE_PAGE_NONE};
+    std::vector<int>    cpu_list;   // cpu_list[0] run single thread, more than one restrict worker cpus
+    size_t      smt_share {1};      // hw threads of a core running gemm, each see l2_size/smt_share
+
+    size_t l2_per_thread() const {
+        return l2_size / MAX(smt_share, (size_t)1);
+    }
 
     double      frequency;  // MHz
 
+// threading
+    numa_mode_t numa_mode {NUMA_MODE_OFF};
+    size_t      threads {1};    // ignored if numa_mode is off and steal is false
+    bool        steal {false};  // work stealing over C macro tiles, take precedence over numa_mode
+    place_t     place {PLACE_COMPACT};  // worker order inside a numa node, see topology.h
+
+    size_t num_threads() const {
+        return (numa_mode != NUMA_MODE_OFF || steal) ? threads : 1;
+    }
+
     bool        cur_use_tuned {false};  // use tuned param from db or default, only a flag
+    bool        nt_store {true};        // allow streaming store of C when beta==0 and C >> L3
+    bool        c_acc {false};          // K > kc accumulate C in a packed L2 buffer, write back once
+    bool        pipe {false};           // pack next A/B block on a helper thread (smt sibling) while the current is computed
+    size_t      strassen_cutoff {0};    // sgemm_strassen() recurse while half of M/N/K >= this, 0 off
+    bench_cache_t bench_cache {BENCH_CACHE_WARM};   // benchmark only, operand reuse between loops
+    size_t      c_offset {0};           // benchmark only, C start this many float after an aligned address
+    bool        plan {false};           // benchmark only, time sgemm_plan_execute of a plan made once per problem
+    bool        freq_measure {false};   // benchmark only, measure core clock around timed loop, else frequency is fixed
+    double      mem_bw {0};             // benchmark only, GB/s of stream triad, 0 if not probed. for roofline
 
     void serialize_layout_trans(std::ostream & os){
         std::string al, bl, cl;
@@ -243,24 +321,27 @@ public:
 template<typename T>
 class matrix_t{
 public:
+    // offset_ (element) shift data after the aligned start, to test sub-matrix view
     matrix_t(size_t row_, size_t col_, size_t ldim_,
-        layout_t layout_, trans_t trans_, size_t alignment_)
+        layout_t layout_, trans_t trans_, size_t alignment_, size_t offset_ = 0)
     {
         this->row = row_;
         this->col = col_;
         this->ldim = ldim_;
-        // TODO ldim should be multiple of alignment!
+        // ldim need not be multiple of alignment, only row 0 is aligned (plus offset)
         this->layout = layout_;
         this->trans = trans_;
         this->alignment = alignment_;
+        this->offset = offset_;
 
         size_t elements = matrix_elem_t()(row_, col_, ldim_, layout_, trans_);
-        this->data = (T *) __aligned_malloc(sizeof(T)*elements, alignment_);
+        this->base = (T *) __aligned_malloc(sizeof(T)*(elements+offset_), alignment_);
+        this->data = this->base + offset_;
         rand_vector(this->data, elements);
     }
     ~matrix_t(){
-        if(data)
-            __aligned_free(this->data);
+        if(base)
+            __aligned_free(this->base);
     }
 
     size_t dtype_size() const {
@@ -274,8 +355,10 @@ public:
         this->layout = rhs.layout;
         this->trans = rhs.trans;
         this->alignment = rhs.alignment;
+        this->offset = rhs.offset;
         size_t elements = matrix_elem_t()(rhs.row, rhs.col, rhs.ldim, rhs.layout, rhs.trans);
-        this->data = (T *) __aligned_malloc(sizeof(T)*elements, alignment);
+        this->base = (T *) __aligned_malloc(sizeof(T)*(elements+offset), alignment);
+        this->data = this->base + offset;
         memcpy(this->data, rhs.data, sizeof(T)*elements);
     }
 
@@ -288,6 +371,8 @@ public:
     }
 
     T           *data {nullptr};
+    T           *base {nullptr};    // allocated, data = base + offset
+    size_t      offset {0};
     size_t      row;
     size_t      col;
     size_t      ldim;   // leading dimension
@@ -0,0 +1,560 @@
+#include "gemm_level3.h"
+#include "gemm_opt.h"
+#include "kernel/sgemm_micro_kernel.h"
+#include "kernel/strsm_micro_kernel.h"
+
+#include <string.h>
+#include <stddef.h>
+
+typedef enum {
+    L3_GE = 0,      // general
+    L3_SY,          // symmetric, only the stored triangle is read, the other is its mirror
+    L3_TR           // triangular, 0 outside the stored triangle, diagonal 1 if unit
+}l3_shape_t;
+
+/*
+* element (i, j) of an operand is p[i*rs + j*cs], so transpose is a swap of rs/cs and
+* a negative stride walk it backward. row major lda is {lda, 1}, its transpose {1, lda}
+*/
+struct l3_view_t {
+    const float *   p;
+    ptrdiff_t       rs;
+    ptrdiff_t       cs;
+    l3_shape_t      shape {L3_GE};
+    bool            lower {false};      // stored triangle of SY/TR, in (i, j) of the view
+    bool            unit {false};       // TR only
+
+    float at(int i, int j) const {
+        if(shape == L3_GE)
+            return p[i*rs + j*cs];
+        bool in = lower ? i >= j : i <= j;
+        if(shape == L3_SY)
+            return in ? p[i*rs + j*cs] : p[j*rs + i*cs];
+        if(!in)
+            return 0.f;
+        if(i == j && unit)
+            return 1.f;
+        return p[i*rs + j*cs];
+    }
+    l3_view_t t() const {
+        l3_view_t v = *this;
+        v.rs = cs;
+        v.cs = rs;
+        v.lower = !lower;
+        return v;
+    }
+};
+
+static l3_view_t l3_view(const float * p, ptrdiff_t rs, ptrdiff_t cs){
+    l3_view_t v;
+    v.p = p;
+    v.rs = rs;
+    v.cs = cs;
+    return v;
+}
+
+// op(A) of a row major A, shape/uplo in the (i, j) of op(A)
+static l3_view_t l3_view_op(const float * A, int lda, trans_t trans, l3_shape_t shape, uplo_t uplo, diag_t diag){
+    bool ta = trans == TRANS_TRANS || trans == TRANS_CONJ_TRANS;
+    l3_view_t v = l3_view(A, ta ? 1 : lda, ta ? lda : 1);
+    v.shape = shape;
+    v.lower = (uplo == UPLO_LOWER) != ta;
+    v.unit = diag == DIAG_UNIT;
+    return v;
+}
+
+/*
+* block (i0, j0) of m x n as a dense view: 1 if g is set (general, stored side, or mirror
+* of a symmetric one), 0 if the block is all zero (outside a triangle), -1 if it cross the
+* diagonal and has to be read element by element
+*/
+static int l3_block_ge(const l3_view_t & v, int i0, int m, int j0, int n, l3_view_t & g){
+    g = l3_view(v.p, v.rs, v.cs);
+    if(v.shape == L3_GE)
+        return 1;
+    if(i0 < j0 + n && j0 < i0 + m)
+        return -1;
+    bool in = v.lower ? i0 >= j0 + n : j0 >= i0 + m;
+    if(in)
+        return 1;
+    if(v.shape == L3_TR)
+        return 0;
+    g.rs = v.cs;
+    g.cs = v.rs;
+    return 1;
+}
+
+// A operand, mc x kc at (i0, k0) times alpha, mr panels zero filled past mc. false if all zero
+static bool l3_pack_a(const l3_view_t & v, int i0, int mc, int k0, int kc, float alpha, float * dest, int mr){
+    l3_view_t g;
+    int kind = l3_block_ge(v, i0, mc, k0, kc, g);
+    if(kind == 0)
+        return false;
+    for(int m=0; m<mc; m += mr){
+        int mr_size = MIN(mc-m, mr);
+        if(kind == 1 && g.cs == 1){
+            for(int i=0; i<mr_size; i++){
+                const float * s = g.p + (i0+m+i)*g.rs + k0;
+                for(int k=0; k<kc; k++)
+                    dest[k*mr + i] = alpha*s[k];
+            }
+        }else if(kind == 1){
+            for(int k=0; k<kc; k++){
+                const float * s = g.p + (i0+m)*g.rs + (k0+k)*g.cs;
+                for(int i=0; i<mr_size; i++)
+                    dest[k*mr + i] = alpha*s[i*g.rs];
+            }
+        }else{
+            for(int k=0; k<kc; k++)
+                for(int i=0; i<mr_size; i++)
+                    dest[k*mr + i] = alpha*v.at(i0+m+i, k0+k);
+        }
+        for(int k=0; k<kc; k++)
+            for(int i=mr_size; i<mr; i++)
+                dest[k*mr + i] = 0.f;
+        dest += mr*kc;
+    }
+    return true;
+}
+
+// B operand, kc x nc at (k0, j0), nr panels zero filled past nc. false if all zero
+static bool l3_pack_b(const l3_view_t & v, int k0, int kc, int j0, int nc, float * dest, int nr){
+    l3_view_t g;
+    int kind = l3_block_ge(v, k0, kc, j0, nc, g);
+    if(kind == 0)
+        return false;
+    for(int n=0; n<nc; n += nr){
+        int nr_size = MIN(nc-n, nr);
+        if(kind == 1 && g.cs == 1){
+            for(int k=0; k<kc; k++){
+                const float * s = g.p + (k0+k)*g.rs + j0+n;
+                memcpy(dest + k*nr, s, nr_size*sizeof(float));
+            }
+        }else if(kind == 1){
+            for(int j=0; j<nr_size; j++){
+                const float * s = g.p + k0*g.rs + (j0+n+j)*g.cs;
+                for(int k=0; k<kc; k++)
+                    dest[k*nr + j] = s[k*g.rs];
+            }
+        }else{
+            for(int k=0; k<kc; k++)
+                for(int j=0; j<nr_size; j++)
+                    dest[k*nr + j] = v.at(k0+k, j0+n+j);
+        }
+        if(nr_size < nr)
+            for(int k=0; k<kc; k++)
+                memset(dest + k*nr + nr_size, 0, (nr-nr_size)*sizeof(float));
+        dest += nr*kc;
+    }
+    return true;
+}
+
+typedef enum {
+    L3_KEEP_ALL = 0,
+    L3_KEEP_LOWER,      // only row >= col of the global C is written
+    L3_KEEP_UPPER
+}l3_keep_t;
+
+// 0 nothing of the tile is kept, 1 all of it, 2 part
+static inline int l3_tile_keep(int gi, int m, int gj, int n, l3_keep_t keep){
+    if(keep == L3_KEEP_LOWER)
+        return gi >= gj + n - 1 ? 1 : (gi + m - 1 < gj ? 0 : 2);
+    if(keep == L3_KEEP_UPPER)
+        return gj >= gi + m - 1 ? 1 : (gj + n - 1 < gi ? 0 : 2);
+    return 1;
+}
+
+/*
+* C += packA * packB, C block at global (i0, j0). per mr row panel, a run of full tiles
+* kept whole is handed to sgemm_macro_kernel_n_tn in one call, an edge or diagonal tile
+* is computed into the temp and the kept part added, a tile not kept is skipped
+*/
+static void l3_macro_kernel(int mc, int nc, int kc,
+    const float * packA, const float * packB, float * C, int ldc,
+    int i0, int j0, l3_keep_t keep, float * tile, const gemm_context_t * ctx)
+{
+    sgemm_micro_kernel_t micro_kernel = ctx->micro_kernel ? ctx->micro_kernel : sgemm_micro_kernel_n_tn;
+    int mr = ctx->mr;
+    int nr = ctx->nr;
+    for(int mm=0; mm<mc; mm += mr){
+        int mr_size = MIN(mc-mm, mr);
+        const float * pa = packA + mm*kc;
+        int gi = i0 + mm;
+        int run = -1;
+        // one step past nc to flush the last run
+        for(int nn=0; nn<=nc; nn += nr){
+            int nr_size = MIN(nc-nn, nr);
+            int gj = j0 + nn;
+            int state = nn < nc ? l3_tile_keep(gi, mr_size, gj, nr_size, keep) : 0;
+            if(state == 1 && mr_size == mr && nr_size == nr){
+                if(run < 0)
+                    run = nn;
+                continue;
+            }
+            if(run >= 0){
+                sgemm_macro_kernel_n_tn(mr, nn-run, kc, 1.f, pa, packB + run*kc, 1.f,
+                    C + mm*ldc + run, ldc, ctx);
+                run = -1;
+            }
+            if(state == 0)
+                continue;
+            memset(tile, 0, mr*nr*sizeof(float));
+            micro_kernel(mr, nr, kc, 1.f, pa, packB + nn*kc, 1.f, tile, nr);
+            float * c = C + mm*ldc + nn;
+            for(int i=0; i<mr_size; i++){
+                for(int j=0; j<nr_size; j++){
+                    bool in = keep == L3_KEEP_ALL || (keep == L3_KEEP_LOWER ? gi+i >= gj+j : gi+i <= gj+j);
+                    if(in)
+                        c[i*ldc + j] += tile[i*nr + j];
+                }
+            }
+        }
+    }
+}
+
+// pack buffers of one call. tri hold the packed diagonal block of trsm
+struct l3_ws_t {
+    int     mc, nc, kc;
+    float * a;
+    float * b;
+    float * tri;
+    size_t  a_bytes, b_bytes, tri_bytes;
+    std::vector<float> tile;
+    const gemm_context_t * ctx;
+
+    l3_ws_t(const gemm_context_t * c) : ctx(c) {
+        int mr = ctx->mr;
+        int nr = ctx->nr;
+        mc = MAX((int)ctx->mc / mr * mr, mr);
+        nc = CEIL_WRAP(ctx->nc, nr);
+        kc = ctx->kc;
+        // trsm diagonal block is up to min(mc, kc) rows (left) or min(nc, kc) (right), padded to mr
+        int bs = CEIL_WRAP(MIN(MAX(mc, nc), kc), mr);
+        a_bytes = (size_t)mc*kc*sizeof(float);
+        b_bytes = (size_t)nc*(kc + mr)*sizeof(float);
+        tri_bytes = (size_t)bs*(bs + mr)/2*sizeof(float);
+        a = sgemm_alloc_pack(a_bytes, ctx);
+        b = sgemm_alloc_pack(b_bytes, ctx);
+        tri = sgemm_alloc_pack(tri_bytes, ctx);
+        tile.resize(mr*nr);
+    }
+    ~l3_ws_t(){
+        sgemm_free_pack(a, a_bytes, ctx);
+        sgemm_free_pack(b, b_bytes, ctx);
+        sgemm_free_pack(tri, tri_bytes, ctx);
+    }
+};
+
+/*
+* C(M x N) += alpha * a(M x K at (ai, ak)) * b(K x N at (bk, bj)), blocked as sgemm_n_nn.
+* a kc block of a or b that is all zero (triangle) is not packed nor multiplied
+*/
+static void l3_gemm(int M, int N, int K, float alpha,
+    const l3_view_t & a, int ai, int ak, const l3_view_t & b, int bk, int bj,
+    float * C, int ldc, l3_ws_t & ws)
+{
+    const gemm_context_t * ctx = ws.ctx;
+    for(int mm=0; mm<M; mm += ws.mc){
+        int mc_size = MIN(M-mm, ws.mc);
+        for(int kk=0; kk<K; kk += ws.kc){
+            int kc_size = MIN(K-kk, ws.kc);
+            if(!l3_pack_a(a, ai+mm, mc_size, ak+kk, kc_size, alpha, ws.a, ctx->mr))
+                continue;
+            for(int nn=0; nn<N; nn += ws.nc){
+                int nc_size = MIN(N-nn, ws.nc);
+                if(!l3_pack_b(b, bk+kk, kc_size, bj+nn, nc_size, ws.b, ctx->nr))
+                    continue;
+                l3_macro_kernel(mc_size, nc_size, kc_size, ws.a, ws.b, C + mm*ldc + nn, ldc,
+                    0, 0, L3_KEEP_ALL, ws.tile.data(), ctx);
+            }
+        }
+    }
+}
+
+static inline uplo_t l3_flip(uplo_t uplo){
+    return uplo == UPLO_UPPER ? UPLO_LOWER : UPLO_UPPER;
+}
+static inline side_t l3_flip(side_t side){
+    return side == SIDE_LEFT ? SIDE_RIGHT : SIDE_LEFT;
+}
+
+void cblas_ssyrk_opt(layout_t Layout, uplo_t Uplo, trans_t Trans,
+                int N, int K,
+                float alpha,
+                const float *A, int lda,
+                float beta,
+                float *C, int ldc,
+                const gemm_context_t * ctx)
+{
+    if(Layout == LAYOUT_COL_MAJOR){
+        // C^T has the other triangle, the col major A is the transposed row major one
+        bool ta = Trans == TRANS_TRANS || Trans == TRANS_CONJ_TRANS;
+        cblas_ssyrk_opt(LAYOUT_ROW_MAJOR, l3_flip(Uplo), ta ? TRANS_NO_TRANS : TRANS_TRANS,
+            N, K, alpha, A, lda, beta, C, ldc, ctx);
+        return;
+    }
+    if(N <= 0)
+        return;
+    bool lower = Uplo == UPLO_LOWER;
+    if(beta != 1.f){
+        for(int i=0; i<N; i++){
+            int j0 = lower ? 0 : i;
+            int j1 = lower ? i+1 : N;
+            scale_C(1, j1-j0, beta, C + i*ldc + j0, ldc);
+        }
+    }
+    if(K <= 0 || alpha == 0.f)
+        return;
+
+    l3_ws_t ws(ctx);
+    l3_view_t a = l3_view_op(A, lda, Trans, L3_GE, Uplo, DIAG_NON_UNIT);
+    l3_view_t bt = a.t();
+    l3_keep_t keep = lower ? L3_KEEP_LOWER : L3_KEEP_UPPER;
+    for(int nn=0; nn<N; nn += ws.nc){
+        int nc_size = MIN(N-nn, ws.nc);
+        // rows of C that meet the triangle in these columns
+        int m0 = lower ? nn : 0;
+        int m1 = lower ? N : nn + nc_size;
+        for(int kk=0; kk<K; kk += ws.kc){
+            int kc_size = MIN(K-kk, ws.kc);
+            l3_pack_b(bt, kk, kc_size, nn, nc_size, ws.b, ctx->nr);
+            for(int mm=m0; mm<m1; mm += ws.mc){
+                int mc_size = MIN(m1-mm, ws.mc);
+                l3_pack_a(a, mm, mc_size, kk, kc_size, alpha, ws.a, ctx->mr);
+                l3_macro_kernel(mc_size, nc_size, kc_size, ws.a, ws.b, C + mm*ldc + nn, ldc,
+                    mm, nn, keep, ws.tile.data(), ctx);
+            }
+        }
+    }
+}
+
+void cblas_ssymm_opt(layout_t Layout, side_t Side, uplo_t Uplo,
+                int M, int N,
+                float alpha,
+                const float *A, int lda,
+                const float *B, int ldb,
+                float beta,
+                float *C, int ldc,
+                const gemm_context_t * ctx)
+{
+    if(Layout == LAYOUT_COL_MAJOR){
+        // C^T = B^T*A (left), A seen row major is its own transpose with the other triangle
+        cblas_ssymm_opt(LAYOUT_ROW_MAJOR, l3_flip(Side), l3_flip(Uplo), N, M,
+            alpha, A, lda, B, ldb, beta, C, ldc, ctx);
+        return;
+    }
+    if(M <= 0 || N <= 0)
+        return;
+    scale_C(M, N, beta, C, ldc);
+    if(alpha == 0.f)
+        return;
+    l3_ws_t ws(ctx);
+    l3_view_t a = l3_view_op(A, lda, TRANS_NO_TRANS, L3_SY, Uplo, DIAG_NON_UNIT);
+    l3_view_t b = l3_view(B, ldb, 1);
+    if(Side == SIDE_LEFT)
+        l3_gemm(M, N, M, alpha, a, 0, 0, b, 0, 0, C, ldc, ws);
+    else
+        l3_gemm(M, N, N, alpha, b, 0, 0, a, 0, 0, C, ldc, ws);
+}
+
+void cblas_strmm_opt(layout_t Layout, side_t Side, uplo_t Uplo, trans_t Trans_a, diag_t Diag,
+                int M, int N,
+                float alpha,
+                const float *A, int lda,
+                float *B, int ldb,
+                const gemm_context_t * ctx)
+{
+    if(Layout == LAYOUT_COL_MAJOR){
+        // B^T = alpha*B^T*op(A)^T, A seen row major is A^T with the other triangle
+        cblas_strmm_opt(LAYOUT_ROW_MAJOR, l3_flip(Side), l3_flip(Uplo), Trans_a, Diag, N, M,
+            alpha, A, lda, B, ldb, ctx);
+        return;
+    }
+    if(M <= 0 || N <= 0)
+        return;
+    if(alpha == 0.f){
+        scale_C(M, N, 0.f, B, ldb);
+        return;
+    }
+    l3_ws_t ws(ctx);
+    l3_view_t a = l3_view_op(A, lda, Trans_a, L3_TR, Uplo, Diag);
+    l3_view_t b = l3_view(B, ldb, 1);
+    int mr = ctx->mr;
+    int nr = ctx->nr;
+
+    if(Side == SIDE_LEFT){
+        // row block I = op(A)(I, I)*B(I) + op(A)(I, K)*B(K), K the blocks not yet overwritten
+        int bs = MIN(ws.mc, ws.kc);
+        int nb = CEIL(M, bs);
+        for(int t=0; t<nb; t++){
+            int blk = a.lower ? nb-1-t : t;
+            int i0 = blk*bs;
+            int ib = MIN(M-i0, bs);
+            // diagonal block first, it read B(I) before it is overwritten
+            l3_pack_a(a, i0, ib, i0, ib, alpha, ws.a, mr);
+            for(int nn=0; nn<N; nn += ws.nc){
+                int nc_size = MIN(N-nn, ws.nc);
+                l3_pack_b(b, i0, ib, nn, nc_size, ws.b, nr);
+                scale_C(ib, nc_size, 0.f, B + i0*ldb + nn, ldb);
+                l3_macro_kernel(ib, nc_size, ib, ws.a, ws.b, B + i0*ldb + nn, ldb,
+                    0, 0, L3_KEEP_ALL, ws.tile.data(), ctx);
+            }
+            int k0 = a.lower ? 0 : i0 + ib;
+            int k1 = a.lower ? i0 : M;
+            if(k1 > k0)
+                l3_gemm(ib, N, k1-k0, alpha, a, i0, k0, b, k0, 0, B + i0*ldb, ldb, ws);
+        }
+    }else{
+        // col block J = B(J)*op(A)(J, J) + B(K)*op(A)(K, J)
+        int bs = MIN(ws.nc, ws.kc);
+        int nb = CEIL(N, bs);
+        for(int t=0; t<nb; t++){
+            int blk = a.lower ? t : nb-1-t;
+            int j0 = blk*bs;
+            int jb = MIN(N-j0, bs);
+            l3_pack_b(a, j0, jb, j0, jb, ws.b, nr);
+            for(int mm=0; mm<M; mm += ws.mc){
+                int mc_size = MIN(M-mm, ws.mc);
+                l3_pack_a(b, mm, mc_size, j0, jb, alpha, ws.a, mr);
+                scale_C(mc_size, jb, 0.f, B + mm*ldb + j0, ldb);
+                l3_macro_kernel(mc_size, jb, jb, ws.a, ws.b, B + mm*ldb + j0, ldb,
+                    0, 0, L3_KEEP_ALL, ws.tile.data(), ctx);
+            }
+            int k0 = a.lower ? j0 + jb : 0;
+            int k1 = a.lower ? N : j0;
+            if(k1 > k0)
+                l3_gemm(M, jb, k1-k0, alpha, b, 0, k0, a, k0, j0, B + j0, ldb, ws);
+        }
+    }
+}
+
+/*
+* solve T*X = X in place, T the n x n diagonal block at (t0, t0) of t, X n x w. an upper T
+* is turned lower by reversing the order of rows and columns (J*T*J), X rows reversed too.
+* ws.tri per mr row panel p: -T(p rows, 0 .. p*mr) as a gemm A panel, then the mr x mr
+* tile with inverted diagonal. X is packed in nr panels of n_pad rows, and per panel
+*   row panel p -= solved rows above      gemm micro kernel, k = p*mr, C is the packed panel
+*   row panel p  = inv(T(p, p)) * p       strsm micro kernel
+*/
+static void l3_trsm_diag(int n, const l3_view_t & t, int t0, l3_view_t x, int w, l3_ws_t & ws){
+    const gemm_context_t * ctx = ws.ctx;
+    sgemm_micro_kernel_t micro_kernel = ctx->micro_kernel ? ctx->micro_kernel : sgemm_micro_kernel_n_tn;
+    strsm_micro_kernel_t trsm_kernel = strsm_micro_kernel_select(ctx->kernel_isa(), ctx->nr);
+    int mr = ctx->mr;
+    int nr = ctx->nr;
+    bool rev = !t.lower;
+    if(rev){
+        x.p += (n-1)*x.rs;
+        x.rs = -x.rs;
+    }
+    auto T = [&](int i, int k){
+        return rev ? t.at(t0+n-1-i, t0+n-1-k) : t.at(t0+i, t0+k);
+    };
+    int np = CEIL(n, mr);
+    int n_pad = np*mr;
+
+    float * d = ws.tri;
+    for(int p=0; p<np; p++){
+        for(int k=0; k<p*mr; k++)
+            for(int i=0; i<mr; i++)
+                d[k*mr + i] = (p*mr+i < n) ? -T(p*mr+i, k) : 0.f;
+        d += p*mr*mr;
+        for(int i=0; i<mr; i++){
+            int r = p*mr + i;
+            for(int k=0; k<mr; k++){
+                float v = 0.f;
+                if(r < n && k < i)
+                    v = T(r, p*mr+k);
+                else if(r < n && k == i)
+                    v = 1.f / T(r, r);
+                d[i*mr + k] = v;
+            }
+        }
+        d += mr*mr;
+    }
+
+    for(int j0=0; j0<w; j0 += ws.nc){
+        int wc = MIN(w-j0, ws.nc);
+        int nq = CEIL(wc, nr);
+        for(int q=0; q<nq; q++){
+            float * bq = ws.b + q*nr*n_pad;
+            int wq = MIN(wc - q*nr, nr);
+            for(int r=0; r<n_pad; r++){
+                if(r >= n){
+                    memset(bq + r*nr, 0, nr*sizeof(float));
+                    continue;
+                }
+                const float * s = x.p + r*x.rs + (j0 + q*nr)*x.cs;
+                for(int j=0; j<nr; j++)
+                    bq[r*nr + j] = j < wq ? s[j*x.cs] : 0.f;
+            }
+            const float * tp = ws.tri;
+            for(int p=0; p<np; p++){
+                float * bp = bq + p*mr*nr;
+                if(p > 0)
+                    micro_kernel(mr, nr, p*mr, 1.f, tp, bq, 1.f, bp, nr);
+                tp += p*mr*mr;
+                trsm_kernel(mr, nr, tp, bp);
+                tp += mr*mr;
+            }
+            float * xo = (float *)x.p;
+            for(int r=0; r<n; r++)
+                for(int j=0; j<wq; j++)
+                    xo[r*x.rs + (j0 + q*nr + j)*x.cs] = bq[r*nr + j];
+        }
+    }
+}
+
+void cblas_strsm_opt(layout_t Layout, side_t Side, uplo_t Uplo, trans_t Trans_a, diag_t Diag,
+                int M, int N,
+                float alpha,
+                const float *A, int lda,
+                float *B, int ldb,
+                const gemm_context_t * ctx)
+{
+    if(Layout == LAYOUT_COL_MAJOR){
+        // X^T*op(A)^T = alpha*B^T, same swap as strmm
+        cblas_strsm_opt(LAYOUT_ROW_MAJOR, l3_flip(Side), l3_flip(Uplo), Trans_a, Diag, N, M,
+            alpha, A, lda, B, ldb, ctx);
+        return;
+    }
+    if(M <= 0 || N <= 0)
+        return;
+    scale_C(M, N, alpha, B, ldb);
+    if(alpha == 0.f)
+        return;
+    l3_ws_t ws(ctx);
+    l3_view_t a = l3_view_op(A, lda, Trans_a, L3_TR, Uplo, Diag);
+    l3_view_t b = l3_view(B, ldb, 1);
+
+    if(Side == SIDE_LEFT){
+        // op(A)(I, I)*X(I) = B(I) - op(A)(I, K)*X(K), K the solved blocks
+        int bs = MIN(ws.mc, ws.kc);
+        int nb = CEIL(M, bs);
+        for(int t=0; t<nb; t++){
+            int blk = a.lower ? t : nb-1-t;
+            int i0 = blk*bs;
+            int ib = MIN(M-i0, bs);
+            int k0 = a.lower ? 0 : i0 + ib;
+            int k1 = a.lower ? i0 : M;
+            if(k1 > k0)
+                l3_gemm(ib, N, k1-k0, -1.f, a, i0, k0, b, k0, 0, B + i0*ldb, ldb, ws);
+            l3_trsm_diag(ib, a, i0, l3_view(B + i0*ldb, ldb, 1), N, ws);
+        }
+    }else{
+        // X(J)*op(A)(J, J) = B(J) - X(K)*op(A)(K, J), solved as op(A)(J, J)^T * X(J)^T
+        int bs = MIN(ws.nc, ws.kc);
+        int nb = CEIL(N, bs);
+        l3_view_t at = a.t();
+        for(int t=0; t<nb; t++){
+            int blk = a.lower ? nb-1-t : t;
+            int j0 = blk*bs;
+            int jb = MIN(N-j0, bs);
+            int k0 = a.lower ? j0 + jb : 0;
+            int k1 = a.lower ? N : j0;
+            if(k1 > k0)
+                l3_gemm(M, jb, k1-k0, -1.f, b, 0, k0, a, k0, j0, B + j0, ldb, ws);
+            l3_trsm_diag(jb, at, j0, l3_view(B + j0, 1, ldb), M, ws);
+        }
+    }
+}
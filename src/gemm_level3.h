@@ -0,0 +1,93 @@
+#ifndef __GEMM_LEVEL3_H
+#define __GEMM_LEVEL3_H
+
+#include "gemm_driver.h"
+
+/*
+* level 3 blas on the gemm blocking: same mc/nc/kc, packed mr/nr panels and micro kernel.
+*
+*   ssyrk   C = alpha*op(A)*op(A)^T + beta*C, only the uplo triangle of C is touched. a micro
+*           tile fully in the triangle go through sgemm_macro_kernel_n_tn, a tile across the
+*           diagonal through a temp, a tile outside is skipped, so ~half the gemm work
+*   ssymm   C = alpha*A*B + beta*C (left) or alpha*B*A (right), A symmetric. plain gemm, the
+*           packer mirror the stored triangle, so the other half is never read
+*   strmm   B = alpha*op(A)*B (left) or alpha*B*op(A) (right), in place. block (I, K) of op(A)
+*           outside the triangle is never packed nor multiplied, block order keep every read
+*           of B before it is overwritten
+*   strsm   solve op(A)*X = alpha*B (left) or X*op(A) = alpha*B (right), X over B. left
+*           looking: block I is first updated by the solved blocks (gemm, A packed negated,
+*           sgemm_macro_kernel_n_tn), then solved by the diagonal block: per mr row panel the
+*           gemm micro kernel subtract the solved rows, then strsm_micro_kernel (see
+*           kernel/strsm_micro_kernel.h) with the inverted diagonal finish the mr x nr tile,
+*           all in the packed B panel
+*
+* the triangle dimension is cut in blocks of min(kc, mc), a diagonal block is one kc step.
+* col major is turned into the row major problem on the same buffer (C^T, uplo and side
+* swapped). single thread, any shape, edge tiles through a mr*nr temp.
+*/
+typedef enum {
+    UPLO_UPPER = 0,
+    UPLO_LOWER
+}uplo_t;
+
+typedef enum {
+    SIDE_LEFT = 0,
+    SIDE_RIGHT
+}side_t;
+
+typedef enum {
+    DIAG_NON_UNIT = 0,
+    DIAG_UNIT
+}diag_t;
+
+static inline CBLAS_UPLO to_blas_uplo(uplo_t uplo){
+    return uplo == UPLO_UPPER ? CblasUpper : CblasLower;
+}
+static inline CBLAS_SIDE to_blas_side(side_t side){
+    return side == SIDE_LEFT ? CblasLeft : CblasRight;
+}
+static inline CBLAS_DIAG to_blas_diag(diag_t diag){
+    return diag == DIAG_NON_UNIT ? CblasNonUnit : CblasUnit;
+}
+static inline const char * to_uplo_str(uplo_t uplo){
+    return uplo == UPLO_UPPER ? "u" : "l";
+}
+static inline const char * to_side_str(side_t side){
+    return side == SIDE_LEFT ? "l" : "r";
+}
+static inline const char * to_diag_str(diag_t diag){
+    return diag == DIAG_NON_UNIT ? "n" : "u";
+}
+
+void cblas_ssyrk_opt(layout_t Layout, uplo_t Uplo, trans_t Trans,
+                int N, int K,
+                float alpha,
+                const float *A, int lda,
+                float beta,
+                float *C, int ldc,
+                const gemm_context_t * ctx);
+
+void cblas_ssymm_opt(layout_t Layout, side_t Side, uplo_t Uplo,
+                int M, int N,
+                float alpha,
+                const float *A, int lda,
+                const float *B, int ldb,
+                float beta,
+                float *C, int ldc,
+                const gemm_context_t * ctx);
+
+void cblas_strmm_opt(layout_t Layout, side_t Side, uplo_t Uplo, trans_t Trans_a, diag_t Diag,
+                int M, int N,
+                float alpha,
+                const float *A, int lda,
+                float *B, int ldb,
+                const gemm_context_t * ctx);
+
+void cblas_strsm_opt(layout_t Layout, side_t Side, uplo_t Uplo, trans_t Trans_a, diag_t Diag,
+                int M, int N,
+                float alpha,
+                const float *A, int lda,
+                float *B, int ldb,
+                const gemm_context_t * ctx);
+
+#endif
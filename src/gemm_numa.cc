@@ -0,0 +1,238 @@
+#include "gemm_driver.h"
+#include "gemm_opt.h"
+#include "topology.h"
+#include "kernel/sgemm_pack.h"
+
+#include <string.h>
+#include <thread>
+#include <immintrin.h>
+
+/*
+* numa aware multi thread sgemm. C row major, A row major, B row major
+*
+* loop order follow blis, the packed B panel is shared by a group of threads:
+*
+*   for nn in N, step nc
+*     for kk in K, step kc
+*       group pack B(kc*nc) cooperatively, each thread take a range of NR panels
+*       barrier
+*       for mm in [m_start, m_end) of this thread, step mc
+*         pack A(mc*kc), private to this thread
+*         macro kernel
+*       barrier
+*
+* NUMA_MODE_SHARED:
+*   one group with all threads. B buffer is first touched by thread 0, so threads
+*   on the other socket load every B cache line of micro kernel across UPI.
+* NUMA_MODE_REPLICATE:
+*   one group per numa node. each node pack its own copy of B into node local memory,
+*   first touched by a thread pinned on that node.
+*
+* M is split on MR boundary over all teams in node order, so each node own a
+* continuous row range of A and C.
+*
+* a team is the workers on one physical core. with ctx->place PLACE_SMT the two hw
+* threads of a core are one team: both pack half the rows of one A block into a shared
+* buffer, then each run the macro kernel on half the NR panels of B, so the core hold one
+* A block in L2 instead of two. other placement have one worker per team, and if several
+* of them still land on one core (threads > cores) mc is divided by that count so their A
+* blocks together fit the L2 one A block was tuned for.
+*/
+
+struct numa_group_t {
+    float *         B_pack {nullptr};
+    spin_barrier_t *barrier {nullptr};
+    int             num_threads {0};
+};
+
+struct numa_team_t {
+    float *         A_pack {nullptr};
+    spin_barrier_t *barrier {nullptr};
+    int             num_threads {0};
+};
+
+struct numa_worker_arg_t {
+    int             cpu;
+    numa_group_t *  group;
+    int             group_idx;      // index of thread inside group
+    numa_team_t *   team;
+    int             team_idx;       // index of thread inside team
+    int             m_start;        // row range of the team
+    int             m_end;
+};
+
+static float * numa_alloc_touch(size_t bytes, const gemm_context_t * ctx){
+    float * buf = sgemm_alloc_pack(bytes, ctx);
+    memset(buf, 0, bytes);  // first touch, page is placed on the node of current cpu
+    return buf;
+}
+
+static void sgemm_n_nn_numa_worker(const numa_worker_arg_t * arg,
+                int M, int N, int K,
+                float alpha,
+                const float *A, int lda,
+                const float *B, int ldb,
+                float beta,
+                float *C, int ldc,
+                const gemm_context_t * ctx)
+{
+    int nc, nc_size, kc, kc_size, mc, mc_size;
+    int mm, nn, kk;
+    int mr, nr;
+    mr = ctx->mr;
+    nr = ctx->nr;
+    mc = ctx->mc;
+    nc = ctx->nc;
+    kc = ctx->kc;
+
+    std::vector<int> affinity;
+    affinity.push_back(arg->cpu);
+    set_current_affinity(affinity);
+
+    numa_group_t * group = arg->group;
+    numa_team_t * team = arg->team;
+    int team_size = team->num_threads;
+    if(arg->group_idx == 0)
+        group->B_pack = numa_alloc_touch(nc*kc*sizeof(float), ctx);
+    if(arg->team_idx == 0)
+        team->A_pack = numa_alloc_touch(mc*kc*sizeof(float), ctx);
+    team->barrier->wait();
+    float * A_pack = team->A_pack;
+    bool nt_store = sgemm_use_nt_store(M, N, K, beta, C, ldc, ctx);
+
+    for(nn=0; nn<N; nn += nc){
+        nc_size = MIN(N-nn, nc);
+        int panels = CEIL(nc_size, nr);
+        int p_start = panels * arg->group_idx / group->num_threads;
+        int p_end = panels * (arg->group_idx+1) / group->num_threads;
+        int n_start = p_start * nr;
+        int n_size = MIN(p_end*nr, nc_size) - n_start;
+        for(kk=0; kk<K; kk += kc){
+            kc_size = MIN(K-kk, kc);
+
+            group->barrier->wait(); // previous B panel is consumed by all
+            if(n_size > 0)
+                sgemm_pack(LAYOUT_ROW_MAJOR, TRANS_NO_TRANS, IDENT_B_MATRIX,
+                    0, n_size, kc_size,
+                    alpha, B + kk*ldb + nn + n_start, ldb, group->B_pack + n_start*kc_size, ctx);
+            group->barrier->wait();
+
+            // NR panels of this B block each team member compute on
+            int t_start = panels * arg->team_idx / team_size * nr;
+            int t_size = MIN(panels * (arg->team_idx+1) / team_size * nr, nc_size) - t_start;
+            for(mm=arg->m_start; mm<arg->m_end; mm += mc){
+                mc_size = MIN(arg->m_end-mm, mc);
+                // each member pack its MR panels of the shared A block
+                int mr_panels = CEIL(mc_size, mr);
+                int r_start = mr_panels * arg->team_idx / team_size * mr;
+                int r_size = MIN(mr_panels * (arg->team_idx+1) / team_size * mr, mc_size) - r_start;
+                if(team_size > 1)
+                    team->barrier->wait();  // previous A block is consumed by the team
+                if(r_size > 0)
+                    sgemm_pack(LAYOUT_ROW_MAJOR, TRANS_NO_TRANS, IDENT_A_MATRIX,
+                        r_size, 0, kc_size,
+                        alpha, A + (mm+r_start)*lda + kk, lda, A_pack + r_start*kc_size, ctx);
+                if(team_size > 1)
+                    team->barrier->wait();
+                if(t_size <= 0)
+                    continue;
+                float * c_block = C + mm*ldc + nn + t_start;
+                const float * b_block = group->B_pack + t_start*kc_size;
+
+                if(nt_store){
+                    sgemm_macro_kernel_n_tn_nt(mc_size, t_size, kc_size,
+                        alpha, A_pack, b_block,
+                        beta, c_block, ldc, ctx);
+                    continue;
+                }
+
+                if( kk==0 )
+                    scale_C(mc_size, t_size, beta, c_block, ldc);
+
+                sgemm_macro_kernel_n_tn(mc_size, t_size, kc_size,
+                    alpha, A_pack, b_block,
+                    beta, c_block, ldc, ctx);
+            }
+        }
+    }
+    if(nt_store)
+        _mm_sfence();
+
+    group->barrier->wait();
+    if(arg->group_idx == 0)
+        sgemm_free_pack(group->B_pack, nc*kc*sizeof(float), ctx);
+    if(arg->team_idx == 0)
+        sgemm_free_pack(A_pack, mc*kc*sizeof(float), ctx);
+}
+
+void sgemm_n_nn_numa(
+                int M, int N, int K,
+                float alpha,
+                const float *A, int lda,
+                const float *B, int ldb,
+                float beta,
+                float *C, int ldc,
+                const gemm_context_t * ctx)
+{
+    // sysfs topology does not change, discover once
+    static const std::vector<numa_node_t> nodes = [](){
+        std::vector<numa_node_t> n;
+        numa_discover_nodes(n);
+        return n;
+    }();
+    std::vector<numa_worker_t> workers;
+    numa_assign_workers(nodes, MAX(ctx->threads, (size_t)1), workers, ctx->place,
+        ctx->cpu_list.size() > 1 ? ctx->cpu_list : std::vector<int>());
+
+    int num_workers = workers.size();
+    int num_groups = (ctx->numa_mode == NUMA_MODE_REPLICATE) ? nodes.size() : 1;
+    std::vector<numa_group_t> groups(num_groups);
+    std::vector<numa_worker_arg_t> args(num_workers);
+
+    // team of consecutive workers on one core, only for smt placement
+    std::vector<int> team_of(num_workers);
+    int num_teams = 0;
+    for(int w=0;w<num_workers;w++){
+        bool join = ctx->place == PLACE_SMT && w > 0 && workers[w].core == workers[w-1].core &&
+                    workers[w].node_idx == workers[w-1].node_idx;
+        team_of[w] = join ? team_of[w-1] : num_teams++;
+    }
+    std::vector<numa_team_t> teams(num_teams);
+
+    // siblings not in one team each hold an A block in the shared L2
+    gemm_context_t tctx = *ctx;
+    size_t share = (ctx->place == PLACE_SMT) ? 1 : workers_per_core(workers);
+    if(share > 1)
+        tctx.mc = MAX(tctx.mc / share / tctx.mr * tctx.mr, tctx.mr);
+
+    int mr = ctx->mr;
+    int m_blocks = CEIL(M, mr);
+    for(int w=0;w<num_workers;w++){
+        int g = (ctx->numa_mode == NUMA_MODE_REPLICATE) ? workers[w].node_idx : 0;
+        int t = team_of[w];
+        args[w].cpu = workers[w].cpu;
+        args[w].group = &groups[g];
+        args[w].group_idx = groups[g].num_threads++;
+        args[w].team = &teams[t];
+        args[w].team_idx = teams[t].num_threads++;
+        args[w].m_start = MIN(m_blocks * t / num_teams * mr, M);
+        args[w].m_end = MIN(m_blocks * (t+1) / num_teams * mr, M);
+    }
+    for(int g=0;g<num_groups;g++)
+        groups[g].barrier = new spin_barrier_t(groups[g].num_threads);
+    for(int t=0;t<num_teams;t++)
+        teams[t].barrier = new spin_barrier_t(teams[t].num_threads);
+
+    std::vector<std::thread> threads;
+    for(int w=0;w<num_workers;w++){
+        threads.push_back(std::thread(sgemm_n_nn_numa_worker, &args[w],
+            M, N, K, alpha, A, lda, B, ldb, beta, C, ldc, &tctx));
+    }
+    for(auto & t : threads)
+        t.join();
+
+    for(int g=0;g<num_groups;g++)
+        delete groups[g].barrier;
+    for(int t=0;t<num_teams;t++)
+        delete teams[t].barrier;
+}
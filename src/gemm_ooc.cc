@@ -0,0 +1,245 @@
+#include "gemm_ooc.h"
+#include "gemm_opt.h"
+#include "kernel/sgemm_pack.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fstream>
+
+bool sgemm_ooc_open(const char * path, size_t rows, size_t cols, bool create, sgemm_ooc_file_t & f){
+    size_t bytes = rows*cols*sizeof(float);
+    int fd = open(path, create ? (O_RDWR | O_CREAT) : O_RDONLY, 0644);
+    if(fd < 0){
+        std::cerr<<"gemm_opt: can't open "<<path<<std::endl;
+        return false;
+    }
+    if(create){
+        if(ftruncate(fd, bytes) != 0){
+            std::cerr<<"gemm_opt: can't size "<<path<<" to "<<bytes<<" bytes"<<std::endl;
+            close(fd);
+            return false;
+        }
+    }else{
+        struct stat s;
+        if(fstat(fd, &s) != 0 || (size_t)s.st_size < bytes){
+            std::cerr<<"gemm_opt: "<<path<<" smaller than "<<rows<<"x"<<cols<<" float"<<std::endl;
+            close(fd);
+            return false;
+        }
+    }
+    void * p = mmap(nullptr, bytes, create ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+    if(p == MAP_FAILED){
+        std::cerr<<"gemm_opt: can't map "<<path<<std::endl;
+        close(fd);
+        return false;
+    }
+    f.fd = fd;
+    f.data = (float*)p;
+    f.rows = rows;
+    f.cols = cols;
+    f.bytes = bytes;
+    f.writable = create;
+    return true;
+}
+
+void sgemm_ooc_close(sgemm_ooc_file_t & f){
+    if(f.data){
+        if(f.writable)
+            msync(f.data, f.bytes, MS_SYNC);
+        munmap(f.data, f.bytes);
+    }
+    if(f.fd >= 0)
+        close(f.fd);
+    f = sgemm_ooc_file_t();
+}
+
+// prefetch, page range covering [off, off+len)
+static void ooc_willneed(const sgemm_ooc_file_t & f, size_t off, size_t len, size_t page){
+    size_t b = off / page * page;
+    madvise((char*)f.data + b, off + len - b, MADV_WILLNEED);
+}
+
+// sync (if written) and drop from the process and page cache. only page fully in the range,
+// the one shared with the next panel is still in use
+static void ooc_release(const sgemm_ooc_file_t & f, size_t off, size_t len, size_t page){
+    size_t b = CEIL_WRAP(off, page);
+    size_t e = (off + len == f.bytes) ? f.bytes : (off + len) / page * page;
+    if(e <= b)
+        return ;
+    if(f.writable)
+        msync((char*)f.data + b, e - b, MS_SYNC);
+    madvise((char*)f.data + b, e - b, MADV_DONTNEED);
+    posix_fadvise(f.fd, b, e - b, POSIX_FADV_DONTNEED);
+}
+
+// out of the process only, B is read again by the next panel, from page cache if still there
+static void ooc_drop(const sgemm_ooc_file_t & f, size_t off, size_t len, size_t page){
+    size_t b = CEIL_WRAP(off, page);
+    size_t e = (off + len == f.bytes) ? f.bytes : (off + len) / page * page;
+    if(e > b)
+        madvise((char*)f.data + b, e - b, MADV_DONTNEED);
+}
+
+static size_t ooc_rss(){
+    std::ifstream statm("/proc/self/statm");
+    size_t vm = 0, rss = 0;
+    statm>>vm>>rss;
+    return rss * sysconf(_SC_PAGESIZE);
+}
+
+// edge strips, i-k-j so the inner loop vectorize
+static void ooc_plain(int M, int N, int K, float alpha, const float * A, int lda,
+                const float * B, int ldb, float beta, float * C, int ldc)
+{
+    scale_C(M, N, beta, C, ldc);
+    for(int i=0;i<M;i++){
+        float * c_row = C + (size_t)i*ldc;
+        for(int p=0;p<K;p++){
+            float a = alpha * A[(size_t)i*lda + p];
+            const float * b_row = B + (size_t)p*ldb;
+            for(int j=0;j<N;j++)
+                c_row[j] += a * b_row[j];
+        }
+    }
+}
+
+void sgemm_ooc(int M, int N, int K,
+                float alpha,
+                const sgemm_ooc_file_t & A,
+                const sgemm_ooc_file_t & B,
+                float beta,
+                sgemm_ooc_file_t & C,
+                size_t mem_budget,
+                const gemm_context_t * ctx,
+                sgemm_ooc_stats_t * stats)
+{
+    double t_start = current_sec();
+    size_t fs = sizeof(float);
+    size_t page = sysconf(_SC_PAGESIZE);
+    int mc = ctx->mc;
+    int nc = ctx->nc;
+    int kc = ctx->kc;
+    int M0 = M - M % ctx->mr;
+    int N0 = N - N % ctx->nr;
+    int mm, nn, kk, mc_size, nc_size, kc_size;
+    sgemm_ooc_stats_t st;
+
+    // budget: packed A, packed B (all of it, or a block and 2 kc row windows of B), then 2 A
+    // and 2 C panels
+    size_t b_all_bytes = (size_t)K*N0*fs;
+    st.b_resident = N0 && b_all_bytes <= mem_budget / 2;
+    size_t ws_bytes = (size_t)mc*kc*fs + (st.b_resident ? b_all_bytes : ((size_t)nc + 2*N)*kc*fs);
+    size_t left = mem_budget > ws_bytes ? mem_budget - ws_bytes : 0;
+    size_t mb = left / (2*((size_t)K + N)*fs);
+    mb = mb >= (size_t)mc ? mb / mc * mc : MAX(mb / ctx->mr * ctx->mr, ctx->mr);
+    mb = MIN(mb, (size_t)M);
+    st.panel_rows = mb;
+
+    float * A_pack = sgemm_alloc_pack(mc*kc*fs, ctx);
+    float * B_pack = nullptr;
+    madvise(A.data, A.bytes, MADV_SEQUENTIAL);
+    if(st.b_resident){
+        madvise(B.data, B.bytes, MADV_WILLNEED);
+        // block (kk, nn) at kk*N0 + nn*kc_size, same layout as a kc x nc pack
+        B_pack = sgemm_alloc_pack(b_all_bytes, ctx);
+        for(kk=0; kk<K; kk += kc){
+            kc_size = MIN(K-kk, kc);
+            for(nn=0; nn<N0; nn += nc){
+                nc_size = MIN(N0-nn, nc);
+                sgemm_pack(LAYOUT_ROW_MAJOR, TRANS_NO_TRANS, IDENT_B_MATRIX,
+                    0, nc_size, kc_size,
+                    alpha, B.data + (size_t)kk*N + nn, N, B_pack + (size_t)kk*N0 + (size_t)nn*kc_size, ctx);
+            }
+        }
+        madvise(B.data, B.bytes, MADV_DONTNEED);
+    }else{
+        B_pack = sgemm_alloc_pack(nc*kc*fs, ctx);
+    }
+
+    size_t a_row = (size_t)K*fs;
+    size_t c_row = (size_t)N*fs;
+    size_t prev_off = 0, prev_len = 0;
+    if(mb){
+        ooc_willneed(A, 0, mb*a_row, page);
+        if(beta != 0.f)
+            ooc_willneed(C, 0, mb*c_row, page);
+    }
+    for(size_t p0=0; p0<(size_t)M; p0 += mb){
+        size_t rows = MIN((size_t)M - p0, mb);
+        size_t next = p0 + rows;
+        if(next < (size_t)M){
+            size_t next_rows = MIN((size_t)M - next, mb);
+            ooc_willneed(A, next*a_row, next_rows*a_row, page);
+            if(beta != 0.f)
+                ooc_willneed(C, next*c_row, next_rows*c_row, page);
+        }
+
+        int rows_full = p0 < (size_t)M0 ? (int)(MIN(p0 + rows, (size_t)M0) - p0) : 0;
+        const float * a_panel = A.data + p0*K;
+        float * c_panel = C.data + p0*N;
+        // kk outer, the A and C panel are resident anyway. B not packed once is then read kc
+        // rows at a time, the next rows read ahead and the used ones dropped
+        for(kk=0; N0 && rows_full && kk<K; kk += kc){
+            kc_size = MIN(K-kk, kc);
+            if(!st.b_resident && kk + kc_size < K)
+                ooc_willneed(B, (kk + kc_size)*c_row, MIN(K-kk-kc_size, kc)*c_row, page);
+            for(mm=0; mm<rows_full; mm += mc){
+                mc_size = MIN(rows_full-mm, mc);
+                sgemm_pack(LAYOUT_ROW_MAJOR, TRANS_NO_TRANS, IDENT_A_MATRIX,
+                    mc_size, 0, kc_size,
+                    alpha, a_panel + (size_t)mm*K + kk, K, A_pack, ctx);
+                for(nn=0; nn<N0; nn += nc){
+                    nc_size = MIN(N0-nn, nc);
+                    float * packB = B_pack;
+                    if(st.b_resident)
+                        packB = B_pack + (size_t)kk*N0 + (size_t)nn*kc_size;
+                    else
+                        sgemm_pack(LAYOUT_ROW_MAJOR, TRANS_NO_TRANS, IDENT_B_MATRIX,
+                            0, nc_size, kc_size,
+                            alpha, B.data + (size_t)kk*N + nn, N, B_pack, ctx);
+                    float * c = c_panel + (size_t)mm*N + nn;
+                    if(kk == 0)
+                        scale_C(mc_size, nc_size, beta, c, N);
+                    sgemm_macro_kernel_n_tn(mc_size, nc_size, kc_size,
+                        alpha, A_pack, packB, beta, c, N, ctx);
+                }
+            }
+            if(!st.b_resident)
+                ooc_drop(B, kk*c_row, kc_size*c_row, page);
+        }
+        // right strip of the full tile rows, then the bottom rows
+        if(N0 < N && rows_full)
+            ooc_plain(rows_full, N-N0, K, alpha, a_panel, K, B.data+N0, N, beta, c_panel+N0, N);
+        if(rows_full < (int)rows)
+            ooc_plain(rows-rows_full, N, K, alpha, a_panel + (size_t)rows_full*K, K, B.data, N,
+                beta, c_panel + (size_t)rows_full*N, N);
+        if(N0 < N || rows_full < (int)rows)
+            ooc_drop(B, 0, B.bytes, page);
+
+        // this panel writeback start now, the one before must be on disk before it is dropped
+        sync_file_range(C.fd, p0*c_row, rows*c_row, SYNC_FILE_RANGE_WRITE);
+        if(prev_len){
+            double t = current_sec();
+            ooc_release(C, prev_off, prev_len, page);
+            st.wait_sec += current_sec() - t;
+        }
+        ooc_release(A, p0*a_row, rows*a_row, page);
+        prev_off = p0*c_row;
+        prev_len = rows*c_row;
+        st.panels++;
+        st.rss_peak = MAX(st.rss_peak, ooc_rss());
+    }
+    if(prev_len)
+        ooc_release(C, prev_off, prev_len, page);
+
+    sgemm_free_pack(A_pack, mc*kc*fs, ctx);
+    sgemm_free_pack(B_pack, st.b_resident ? b_all_bytes : nc*kc*fs, ctx);
+
+    st.read_bytes = (size_t)M*K*fs + (size_t)K*N*fs*(st.b_resident ? 1 : st.panels) +
+                    (beta != 0.f ? (size_t)M*N*fs : 0);
+    st.write_bytes = (size_t)M*N*fs;
+    st.sec = current_sec() - t_start;
+    if(stats)
+        *stats = st;
+}
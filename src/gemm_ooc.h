@@ -0,0 +1,59 @@
+#ifndef __GEMM_OOC_H
+#define __GEMM_OOC_H
+
+#include "gemm_driver.h"
+
+/*
+* out of core sgemm, C = alpha*A*B + beta*C with A/B/C dense row major float files bigger than
+* the memory, mapped by sgemm_ooc_open(). A and C are walked in row panels of mb rows (a multiple
+* of mc), each panel run the usual mc/kc/nc blocking:
+*
+*   for panel in M, step mb
+*     madvise(WILLNEED) next A panel (and C panel if beta != 0), kernel read it ahead
+*     for mm in panel, step mc; for kk in K, step kc
+*       pack A, for nn in N, step nc: packed B block, macro kernel into C
+*     start writeback of the C panel, wait the one before and drop it, drop the A panel
+*
+* B is packed once and kept for all panels if K*N fit half the budget, else packed per block from
+* its mapping like sgemm_n_nn (read again every panel, mostly from page cache). mb is from what
+* is left of the budget: 2 A panels and 2 C panels (current + ahead / in writeback). dropped
+* range is released from the process (MADV_DONTNEED) and the page cache (POSIX_FADV_DONTNEED),
+* so resident memory stay near the budget whatever M is.
+* M%mr rows and N%nr columns go to a plain loop. single thread.
+*/
+
+struct sgemm_ooc_file_t {
+    int     fd {-1};
+    float * data {nullptr};
+    size_t  rows {0};
+    size_t  cols {0};
+    size_t  bytes {0};
+    bool    writable {false};
+};
+
+// map rows x cols float of path. create: O_CREAT, size set to rows*cols, writable. false if fail
+bool sgemm_ooc_open(const char * path, size_t rows, size_t cols, bool create, sgemm_ooc_file_t & f);
+void sgemm_ooc_close(sgemm_ooc_file_t & f);
+
+struct sgemm_ooc_stats_t {
+    size_t  panel_rows {0};     // mb
+    size_t  panels {0};
+    bool    b_resident {false}; // B packed once
+    size_t  read_bytes {0};     // A + B (+ C if beta != 0) from the files, B once per panel if not resident
+    size_t  write_bytes {0};    // C
+    size_t  rss_peak {0};       // resident set of the process, sampled per panel
+    double  sec {0};
+    double  wait_sec {0};       // blocked on C writeback of the panel before
+};
+
+void sgemm_ooc(int M, int N, int K,
+                float alpha,
+                const sgemm_ooc_file_t & A,
+                const sgemm_ooc_file_t & B,
+                float beta,
+                sgemm_ooc_file_t & C,
+                size_t mem_budget,
+                const gemm_context_t * ctx,
+                sgemm_ooc_stats_t * stats);
+
+#endif
@@ -1,7 +1,10 @@
 #include "gemm_driver.h"
+#include "gemm_opt.h"
 #include "kernel/sgemm_micro_kernel.h"
 #include "kernel/sgemm_pack.h"
 #include "gemm_config.h"
+#include <immintrin.h>
+#include <string.h>
 
 //#define BLOCK_K 128
 //#define BLOCK_M 256
@@ -63,8 +66,8 @@ void sgemm_macro_kernel(
 #endif
 
 // C row major, A col major, B row major
-extern "C"
-void sgemm_macro_kernel_n_tn(
+static inline void sgemm_macro_kernel_n_tn_impl(
+        sgemm_micro_kernel_t micro_kernel,
         int    mc,
         int    nc,
         int    kc,
@@ -92,7 +95,7 @@ void sgemm_macro_kernel_n_tn(
         offset_b = 0;
         for(nn=0; nn<nc; nn += nr){
             nr_size = MIN(nc-nn, nr);
-            sgemm_micro_kernel_n_tn(mr_size, nr_size, kc,
+            micro_kernel(mr_size, nr_size, kc,
                 alpha,
                 packA + offset_a,
                 packB + offset_b,
@@ -107,6 +110,94 @@ void sgemm_macro_kernel_n_tn(
     }
 }
 
+extern "C"
+void sgemm_macro_kernel_n_tn(
+        int    mc,
+        int    nc,
+        int    kc,
+        float  alpha,
+        const float * packA,
+        const float * packB,
+        float  beta,
+        float * C,
+        int    ldc,
+        const gemm_context_t * ctx)
+{
+    sgemm_macro_kernel_n_tn_impl(ctx->micro_kernel ? ctx->micro_kernel : sgemm_micro_kernel_n_tn,
+        mc, nc, kc, alpha, packA, packB, beta, C, ldc, ctx);
+}
+
+extern "C"
+void sgemm_macro_kernel_n_tn_nt(
+        int    mc,
+        int    nc,
+        int    kc,
+        float  alpha,
+        const float * packA,
+        const float * packB,
+        float  beta,
+        float * C,
+        int    ldc,
+        const gemm_context_t * ctx)
+{
+    sgemm_macro_kernel_n_tn_impl(ctx->micro_kernel ? ctx->micro_kernel_nt : sgemm_micro_kernel_n_tn_nt,
+        mc, nc, kc, alpha, packA, packB, beta, C, ldc, ctx);
+}
+
+/*
+* streaming store of C is only a win if C is written once, not re-read by
+* a later kc block, and C is too big to stay in cache anyway.
+* vmovntps need C tile aligned to vector width, every row.
+*/
+bool sgemm_use_nt_store(int M, int N, int K, float beta,
+                const float *C, int ldc, const gemm_context_t * ctx)
+{
+    if(!ctx->nt_store || beta != 0.f)
+        return false;
+    if((size_t)K > ctx->kc)
+        return false;
+    if(ctx->micro_kernel && !ctx->micro_kernel_nt)
+        return false;
+    size_t align = ctx->micro_kernel ? ctx->kernel_vector_bytes : 32;
+    if(((size_t)C % align) || ((ldc*sizeof(float)) % align))
+        return false;
+    return (size_t)M*N*sizeof(float) > NT_STORE_C_L3_RATIO * ctx->l3_size;
+}
+
+bool sgemm_set_jit_kernel(gemm_context_t * ctx, const sgemm_jit_config_t * cfg){
+    if(!cfg){
+        const sgemm_kernel_desc_t * best = sgemm_kernel_best();
+        return best && sgemm_set_kernel(ctx, best);
+    }
+    sgemm_jit_config_t nt_cfg = *cfg;
+    nt_cfg.epilogue = SGEMM_EPILOGUE_NT;
+    sgemm_micro_kernel_t kernel = sgemm_jit_get_kernel(*cfg);
+    if(!kernel)
+        return false;
+    ctx->kernel_desc = nullptr;
+    ctx->jit = true;
+    ctx->jit_cfg = *cfg;
+    ctx->micro_kernel = kernel;
+    ctx->micro_kernel_nt = sgemm_jit_get_kernel(nt_cfg);
+    ctx->kernel_vector_bytes = sgemm_isa_vector_bytes(cfg->isa);
+    ctx->mr = cfg->mr;
+    ctx->nr = cfg->nr;
+    return true;
+}
+
+bool sgemm_set_kernel(gemm_context_t * ctx, const sgemm_kernel_desc_t * desc){
+    if(!sgemm_isa_supported(desc->isa))
+        return false;
+    ctx->jit = false;
+    ctx->kernel_desc = desc;
+    ctx->micro_kernel = desc->kernel;
+    ctx->micro_kernel_nt = desc->kernel_nt;
+    ctx->kernel_vector_bytes = sgemm_isa_vector_bytes(desc->isa);
+    ctx->mr = desc->mr;
+    ctx->nr = desc->nr;
+    return true;
+}
+
 // C col major, A col major, B row major
 extern "C"
 void sgemm_macro_kernel_t_tn(
@@ -123,7 +214,7 @@ void sgemm_macro_kernel_t_tn(
 {
 }
 
-static void scale_C(int mc, int nc, float beta, float * C, int ldc){
+void scale_C(int mc, int nc, float beta, float * C, int ldc){
     float * c_itr = C;
     if(beta == 1.f){
         ;
@@ -149,6 +240,241 @@ static void scale_C(int mc, int nc, float beta, float * C, int ldc){
     }
 }
 
+float * sgemm_alloc_pack(size_t bytes, const gemm_context_t * ctx){
+    if(ctx->huge_page != HUGE_PAGE_NONE){
+        float * buf = (float*)__huge_malloc(bytes);
+        if(buf)
+            return buf;
+        std::cerr<<"fail to alloc huge page backed pack buffer, "<<bytes<<" bytes"<<std::endl;
+        assert(0);
+    }
+    return (float*)__aligned_malloc(bytes, ctx->page_size);
+}
+
+void sgemm_free_pack(float * buf, size_t bytes, const gemm_context_t * ctx){
+    if(ctx->huge_page != HUGE_PAGE_NONE)
+        __huge_free(buf, bytes);
+    else
+        __aligned_free(buf);
+}
+
+// per thread buffer of small workspace, allocated on first use, freed at thread exit
+struct sgemm_tls_ws_t {
+    float * buf {nullptr};
+    bool    busy {false};
+    ~sgemm_tls_ws_t(){
+        if(buf)
+            __aligned_free(buf);
+    }
+};
+static thread_local sgemm_tls_ws_t tls_ws;
+static thread_local sgemm_ws_stats_t ws_last;
+
+void sgemm_ws_alloc(int M, int N, int K, const gemm_context_t * ctx, sgemm_ws_t & ws,
+                size_t c_acc_nc)
+{
+    size_t fs = sizeof(float);
+    size_t nc = c_acc_nc ? c_acc_nc : ctx->nc;
+    size_t kc = MIN((size_t)K, ctx->kc);
+    size_t m = CEIL_WRAP(MIN((size_t)M, ctx->mc), ctx->mr);
+    size_t n = CEIL_WRAP(MIN((size_t)N, nc), ctx->nr);
+    // each part on its own cache line
+    ws.a_bytes = CEIL_WRAP(m*kc*fs, CACHELINE_SIZE);
+    ws.b_bytes = CEIL_WRAP(n*kc*fs, CACHELINE_SIZE);
+    ws.c_bytes = c_acc_nc ? CEIL_WRAP(m*n*fs, CACHELINE_SIZE) : 0;
+    size_t bytes = ws.a_bytes + ws.b_bytes + ws.c_bytes;
+
+    // a nested call (kernel calling back into gemm) find the buffer busy, go to heap
+    ws.tls = bytes <= PACK_TLS_BYTES && ctx->huge_page == HUGE_PAGE_NONE && !tls_ws.busy;
+    if(ws.tls){
+        if(!tls_ws.buf)
+            tls_ws.buf = (float*)__aligned_malloc(PACK_TLS_BYTES, ctx->page_size);
+        tls_ws.busy = true;
+        ws.A_pack = tls_ws.buf;
+        ws.B_pack = ws.A_pack + ws.a_bytes/fs;
+        ws.C_acc = ws.c_bytes ? ws.B_pack + ws.b_bytes/fs : nullptr;
+    }else{
+        ws.A_pack = sgemm_alloc_pack(ws.a_bytes, ctx);
+        ws.B_pack = sgemm_alloc_pack(ws.b_bytes, ctx);
+        ws.C_acc = ws.c_bytes ? sgemm_alloc_pack(ws.c_bytes, ctx) : nullptr;
+    }
+    ws_last.bytes = bytes;
+    ws_last.full_bytes = (ctx->mc*ctx->kc + nc*ctx->kc + (c_acc_nc ? ctx->mc*nc : 0))*fs;
+    ws_last.tls = ws.tls;
+}
+
+void sgemm_ws_free(sgemm_ws_t & ws, const gemm_context_t * ctx){
+    if(ws.tls){
+        tls_ws.busy = false;
+    }else{
+        sgemm_free_pack(ws.A_pack, ws.a_bytes, ctx);
+        sgemm_free_pack(ws.B_pack, ws.b_bytes, ctx);
+        if(ws.C_acc)
+            sgemm_free_pack(ws.C_acc, ws.c_bytes, ctx);
+    }
+    ws.A_pack = ws.B_pack = ws.C_acc = nullptr;
+}
+
+struct sgemm_tls_scratch_t {
+    float * buf[SCRATCH_SLOTS] {};
+    size_t  bytes[SCRATCH_SLOTS] {};
+    bool    busy[SCRATCH_SLOTS] {};
+    ~sgemm_tls_scratch_t(){
+        for(int i=0; i<SCRATCH_SLOTS; i++)
+            if(buf[i])
+                __aligned_free(buf[i]);
+    }
+};
+static thread_local sgemm_tls_scratch_t tls_scratch;
+
+float * sgemm_scratch_get(sgemm_scratch_slot_t slot, size_t bytes){
+    sgemm_tls_scratch_t & s = tls_scratch;
+    if(bytes > SCRATCH_TLS_BYTES || s.busy[slot])
+        return (float*)__aligned_malloc(bytes, CACHELINE_SIZE);
+    if(s.bytes[slot] < bytes){
+        if(s.buf[slot])
+            __aligned_free(s.buf[slot]);
+        s.bytes[slot] = CEIL_WRAP(bytes, (size_t)PAGE_SIZE);
+        s.buf[slot] = (float*)__aligned_malloc(s.bytes[slot], CACHELINE_SIZE);
+    }
+    s.busy[slot] = true;
+    return s.buf[slot];
+}
+
+void sgemm_scratch_put(sgemm_scratch_slot_t slot, float * buf){
+    sgemm_tls_scratch_t & s = tls_scratch;
+    if(s.busy[slot] && buf == s.buf[slot])
+        s.busy[slot] = false;
+    else
+        __aligned_free(buf);
+}
+
+sgemm_ws_stats_t sgemm_ws_last(){
+    return ws_last;
+}
+
+void sgemm_ws_reset(){
+    ws_last = sgemm_ws_stats_t();
+}
+
+/*
+* c_acc mode, for K > kc. C of a mc*nc block is accumulated across all kc blocks in a
+* contiguous buffer, tile ordered (every mr*nr tile is mr*nr continuous float, tiles of
+* a row next to each other), and written back to the strided C once with beta:
+*
+*   for mm in M, step mc
+*     for nn in N, step nc_acc
+*       zero C_acc
+*       for kk in K, step kc
+*         pack A(mc*kc), pack B(kc*nc_acc)
+*         macro kernel into C_acc, ldc=nr
+*       C = beta*C + C_acc
+*
+* nc_acc clip nc so C_acc fit 1/C_ACC_L2_RATIO of L2. C_acc tile is read and written
+* per kc block from L2 with unit stride, instead of the mr rows of ldc stride of C.
+* cost is A packed once per nc_acc block instead of once per mm/kk
+*/
+size_t sgemm_c_acc_nc(const gemm_context_t * ctx){
+    size_t nc = ctx->l2_size / C_ACC_L2_RATIO / (ctx->mc*sizeof(float));
+    nc = nc / ctx->nr * ctx->nr;
+    return MAX(MIN(nc, ctx->nc), ctx->nr);
+}
+
+static void sgemm_macro_kernel_n_tn_acc(
+        int    mc,
+        int    nc,
+        int    kc,
+        float  alpha,
+        const float * packA,
+        const float * packB,
+        float * C_acc,
+        const gemm_context_t * ctx)
+{
+    sgemm_micro_kernel_t micro_kernel = ctx->micro_kernel ? ctx->micro_kernel : sgemm_micro_kernel_n_tn;
+    int mr = ctx->mr;
+    int nr = ctx->nr;
+    int mm, nn;
+    for(mm=0; mm<mc; mm += mr){
+        for(nn=0; nn<nc; nn += nr){
+            micro_kernel(mr, nr, kc, alpha,
+                packA + mm*kc,
+                packB + nn*kc,
+                1.f, C_acc, nr);
+            C_acc += mr*nr;
+        }
+    }
+}
+
+static void sgemm_c_acc_write_back(int mc, int nc, float beta, const float * C_acc,
+    float * C, int ldc, const gemm_context_t * ctx)
+{
+    int mr = ctx->mr;
+    int nr = ctx->nr;
+    int mm, nn, i, j;
+    for(mm=0; mm<mc; mm += mr){
+        for(nn=0; nn<nc; nn += nr){
+            float * c_tile = C + mm*ldc + nn;
+            for(i=0; i<mr; i++){
+                float * c_row = c_tile + i*ldc;
+                const float * acc_row = C_acc + i*nr;
+                if(beta == 0.f){
+                    for(j=0; j<nr; j++)
+                        c_row[j] = acc_row[j];
+                }else if(beta == 1.f){
+                    for(j=0; j<nr; j++)
+                        c_row[j] += acc_row[j];
+                }else{
+                    for(j=0; j<nr; j++)
+                        c_row[j] = beta*c_row[j] + acc_row[j];
+                }
+            }
+            C_acc += mr*nr;
+        }
+    }
+}
+
+void sgemm_n_nn_acc(
+                int M, int N, int K,
+                float alpha,
+                const float *A, int lda,
+                const float *B, int ldb,
+                float beta,
+                float *C, int ldc,
+                const gemm_context_t * ctx)
+{
+    int mc = ctx->mc;
+    int kc = ctx->kc;
+    int nc = sgemm_c_acc_nc(ctx);
+    int mm, nn, kk, mc_size, nc_size, kc_size;
+
+    sgemm_ws_t ws;
+    sgemm_ws_alloc(M, N, K, ctx, ws, nc);
+    float * A_pack = ws.A_pack;
+    float * B_pack = ws.B_pack;
+    float * C_acc = ws.C_acc;
+
+    for(mm=0; mm<M; mm += mc){
+        mc_size = MIN(M-mm, mc);
+        for(nn=0; nn<N; nn += nc){
+            nc_size = MIN(N-nn, nc);
+            memset(C_acc, 0, mc_size*nc_size*sizeof(float));
+            for(kk=0; kk<K; kk += kc){
+                kc_size = MIN(K-kk, kc);
+                sgemm_pack(LAYOUT_ROW_MAJOR, TRANS_NO_TRANS, IDENT_A_MATRIX,
+                    mc_size, 0, kc_size,
+                    alpha, A + mm*lda + kk, lda, A_pack, ctx);
+                sgemm_pack(LAYOUT_ROW_MAJOR, TRANS_NO_TRANS, IDENT_B_MATRIX,
+                    0, nc_size, kc_size,
+                    alpha, B + kk*ldb + nn, ldb, B_pack, ctx);
+                sgemm_macro_kernel_n_tn_acc(mc_size, nc_size, kc_size,
+                    alpha, A_pack, B_pack, C_acc, ctx);
+            }
+            sgemm_c_acc_write_back(mc_size, nc_size, beta, C_acc, C+mm*ldc+nn, ldc, ctx);
+        }
+    }
+    sgemm_ws_free(ws, ctx);
+}
+
 // C row major, A row major, B row major
 static void sgemm_n_nn(
                 int M, int N, int K,
@@ -193,17 +519,40 @@ static void sgemm_n_nn(
     __aligned_free(A_pack);
     __aligned_free(B_pack);
 #endif
+    // kernels only write full mr x nr tiles, the rest of C is padded by sgemm_n_nn_edge
+    int M0 = M - M % ctx->mr;
+    int N0 = N - N % ctx->nr;
+    if(M0 != M || N0 != N){
+        if(M0 && N0)
+            sgemm_n_nn(M0,N0,K,alpha,A,lda,B,ldb,beta,C,ldc,ctx);
+        sgemm_n_nn_edge(M,N,K,M0,N0,alpha,A,lda,B,ldb,beta,C,ldc,ctx);
+        return ;
+    }
+    if(ctx->steal && ctx->threads > 1){
+        sgemm_n_nn_steal(M,N,K,alpha,A,lda,B,ldb,beta,C,ldc,ctx,true,nullptr);
+        return ;
+    }
+    if(ctx->numa_mode != NUMA_MODE_OFF){
+        sgemm_n_nn_numa(M,N,K,alpha,A,lda,B,ldb,beta,C,ldc,ctx);
+        return ;
+    }
+    if(ctx->c_acc && (size_t)K > ctx->kc){
+        sgemm_n_nn_acc(M,N,K,alpha,A,lda,B,ldb,beta,C,ldc,ctx);
+        return ;
+    }
+    if(ctx->pipe){
+        sgemm_n_nn_pipe(M,N,K,alpha,A,lda,B,ldb,beta,C,ldc,ctx,nullptr);
+        return ;
+    }
     int nc, nc_size, kc, kc_size, mc, mc_size;
     int mm, nn, kk;
-    int page_size;
-    int mr;
-    mr = ctx->mr;
     mc = ctx->mc;
     nc = ctx->nc;
     kc = ctx->kc;
-    page_size = ctx->page_size;
 
 #if 0
+    int mr = ctx->mr;
+    int page_size = ctx->page_size;
     // alloc A, A should align in one PAGE_SIZE for every mr*kc panel
     int block_bytes = mr*kc*sizeof(float);
     if(block_bytes > page_size){
@@ -214,14 +563,16 @@ static void sgemm_n_nn(
     int num_pages = (mc-1)/mr + 1;
     float * A_pack = (float*)__aligned_malloc(num_pages * page_size, page_size);
 #endif
-    // alloc A
-    float * A_pack = (float*)__aligned_malloc(mc*kc*sizeof(float), page_size);
-
-    // alloc B
-    float * B_pack = (float*)__aligned_malloc(nc*kc*sizeof(float), page_size);
+    // alloc A and B, sized to the problem. with huge page, whole mc*kc block usually sit in 1 page
+    sgemm_ws_t ws;
+    sgemm_ws_alloc(M, N, K, ctx, ws);
+    float * A_pack = ws.A_pack;
+    float * B_pack = ws.B_pack;
 
     //printf("[%s] a num tlb:%d, bytes a:%lu, bytes b:%lu\n", __func__, num_pages, num_pages * page_size,nc*kc*sizeof(float) );
 
+    bool nt_store = sgemm_use_nt_store(M, N, K, beta, C, ldc, ctx);
+
     for(mm=0; mm<M; mm += mc){
         mc_size = MIN(M-mm, mc);
         for(kk=0; kk<K; kk += kc){
@@ -235,6 +586,14 @@ static void sgemm_n_nn(
                     0, nc_size, kc_size,
                     alpha, B + kk*ldb + nn, ldb, B_pack, ctx);
 
+                if(nt_store){
+                    // C fully overwritten, no need scale_C
+                    sgemm_macro_kernel_n_tn_nt(mc_size, nc_size, kc_size,
+                        alpha, A_pack, B_pack,
+                        beta, C+mm*ldc+nn, ldc, ctx);
+                    continue;
+                }
+
                 if( kk==0 )
                     scale_C(mc_size, nc_size, beta, C+mm*ldc+nn, ldc);
 
@@ -244,8 +603,9 @@ static void sgemm_n_nn(
             }
         }
     }
-    __aligned_free(A_pack);
-    __aligned_free(B_pack);
+    if(nt_store)
+        _mm_sfence();   // order streaming stores before C is visible to others
+    sgemm_ws_free(ws, ctx);
 }
 
 static void sgemm_n_nt(
@@ -371,4 +731,100 @@ void cblas_sgemm_opt(layout_t Layout, trans_t Trans_a, trans_t Trans_b,
             }
         }
     }
-}
\ No newline at end of file
+}
+/*
+* M%mr rows and N%nr columns of C left by a M0 x N0 cblas_sgemm_opt() call, row major NN, run
+* through the packed path too: the N%nr columns of B copied into a K x nr panel and the M%mr rows
+* of A into a mr x K one, zero padded, each strip computed into a temp C of the padded size and
+* copied back. right strip M0 x nr, bottom mr x N0, corner mr x nr. a single bottom row is a
+* gemv, mr times the flop padded and B packed for one row, so it stay a plain loop. single thread
+*/
+void sgemm_n_nn_edge(
+                int M, int N, int K, int M0, int N0,
+                float alpha,
+                const float *A, int lda,
+                const float *B, int ldb,
+                float beta,
+                float *C, int ldc,
+                const gemm_context_t * ctx)
+{
+    if(M0 == M && N0 == N)
+        return ;
+    int mr = ctx->mr;
+    int nr = ctx->nr;
+    size_t fs = sizeof(float);
+    gemm_context_t ectx = *ctx;
+    ectx.numa_mode = NUMA_MODE_OFF;
+    ectx.steal = false;
+    ectx.pipe = false;
+    ectx.nt_store = false;
+    ectx.k = K;
+    ectx.alpha = alpha;
+    ectx.beta = beta;
+
+    if(M - M0 == 1){
+        float * c_row = C + (size_t)M0*ldc;
+        const float * a_row = A + (size_t)M0*lda;
+        scale_C(1, N, beta, c_row, ldc);
+        for(int p=0; p<K; p++){
+            float a = alpha * a_row[p];
+            const float * b_row = B + (size_t)p*ldb;
+            for(int j=0; j<N; j++)
+                c_row[j] += a * b_row[j];
+        }
+        M = M0;
+    }
+    // only the padding is zeroed, the rest is copied over
+    float * A_pad = nullptr;
+    float * B_pad = nullptr;
+    int m1 = M - M0;
+    int n1 = N - N0;
+    if(m1){
+        A_pad = sgemm_scratch_get(SCRATCH_EDGE_A, (size_t)mr*K*fs);
+        for(int i=0; i<m1; i++)
+            memcpy(A_pad + (size_t)i*K, A + (size_t)(M0+i)*lda, K*fs);
+        memset(A_pad + (size_t)m1*K, 0, (size_t)(mr-m1)*K*fs);
+    }
+    if(n1){
+        B_pad = sgemm_scratch_get(SCRATCH_EDGE_B, (size_t)K*nr*fs);
+        for(int p=0; p<K; p++){
+            float * d = B_pad + (size_t)p*nr;
+            memcpy(d, B + (size_t)p*ldb + N0, n1*fs);
+            memset(d + n1, 0, (nr-n1)*fs);
+        }
+    }
+    // rows x cols of c from a rows_pad x cols_pad run, c read in only if beta need it
+    auto strip = [&](int rows, int rows_pad, int cols, int cols_pad,
+                    const float * a, int a_ld, const float * b, int b_ld, float * c){
+        float * t = sgemm_scratch_get(SCRATCH_EDGE_C, (size_t)rows_pad*cols_pad*fs);
+        for(int i=0; i<rows_pad; i++){
+            float * d = t + (size_t)i*cols_pad;
+            int n = 0;
+            if(i < rows && beta != 0.f){
+                memcpy(d, c + (size_t)i*ldc, cols*fs);
+                n = cols;
+            }
+            memset(d + n, 0, (cols_pad-n)*fs);
+        }
+        ectx.m = rows_pad;
+        ectx.n = cols_pad;
+        ectx.lda = a_ld;
+        ectx.ldb = b_ld;
+        ectx.ldc = cols_pad;
+        sgemm_n_nn(rows_pad, cols_pad, K, alpha, a, a_ld, b, b_ld, beta, t, cols_pad, &ectx);
+        for(int i=0; i<rows; i++)
+            memcpy(c + (size_t)i*ldc, t + (size_t)i*cols_pad, cols*fs);
+        sgemm_scratch_put(SCRATCH_EDGE_C, t);
+    };
+    if(N0 < N && M0)
+        strip(M0, M0, N-N0, nr, A, lda, B_pad, nr, C + N0);
+    if(M0 < M && N0)
+        strip(M-M0, mr, N0, N0, A_pad, K, B, ldb, C + (size_t)M0*ldc);
+    if(M0 < M && N0 < N)
+        strip(M-M0, mr, N-N0, nr, A_pad, K, B_pad, nr, C + (size_t)M0*ldc + N0);
+
+    if(A_pad)
+        sgemm_scratch_put(SCRATCH_EDGE_A, A_pad);
+    if(B_pad)
+        sgemm_scratch_put(SCRATCH_EDGE_B, B_pad);
+}
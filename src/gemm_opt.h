@@ -0,0 +1,180 @@
+#ifndef __GEMM_OPT_H
+#define __GEMM_OPT_H
+
+#include "gemm_driver.h"
+
+// the last parameter is added only for convenience. row major NN take any M/N, M%mr rows and
+// N%nr columns by sgemm_n_nn_edge
+void cblas_sgemm_opt(layout_t Layout, trans_t Trans_a, trans_t Trans_b,
+                int M, int N, int K,
+                float alpha,
+                const float *A, int lda,
+                const float *B, int ldb,
+                float beta,
+                float *C, int ldc,
+                const gemm_context_t * ctx);
+
+// C row major, A col major, B row major
+extern "C"
+void sgemm_macro_kernel_n_tn(
+        int    mc,
+        int    nc,
+        int    kc,
+        float  alpha,
+        const float * packA,
+        const float * packB,
+        float  beta,
+        float * C,
+        int    ldc,
+        const gemm_context_t * ctx);
+
+// streaming store variant, caller need sfence after last macro kernel
+extern "C"
+void sgemm_macro_kernel_n_tn_nt(
+        int    mc,
+        int    nc,
+        int    kc,
+        float  alpha,
+        const float * packA,
+        const float * packB,
+        float  beta,
+        float * C,
+        int    ldc,
+        const gemm_context_t * ctx);
+
+bool sgemm_use_nt_store(int M, int N, int K, float beta,
+                const float *C, int ldc, const gemm_context_t * ctx);
+
+/*
+* switch ctx to a jit generated micro kernel, mr/nr follow the kernel.
+* cfg nullptr restore the default, sgemm_kernel_best(). return false if cfg is not valid on this host
+*/
+bool sgemm_set_jit_kernel(gemm_context_t * ctx, const sgemm_jit_config_t * cfg);
+// switch ctx to a registered kernel, see sgemm_kernel_find(). false if host lack the isa
+bool sgemm_set_kernel(gemm_context_t * ctx, const sgemm_kernel_desc_t * desc);
+
+void scale_C(int mc, int nc, float beta, float * C, int ldc);
+
+// pack workspace, huge page backed if ctx->huge_page is set
+float * sgemm_alloc_pack(size_t bytes, const gemm_context_t * ctx);
+void sgemm_free_pack(float * buf, size_t bytes, const gemm_context_t * ctx);
+
+/*
+* pack workspace of one call, sized to the problem: A is ceil(min(M,mc), mr) x min(K,kc), B
+* ceil(min(N,nc), nr) x min(K,kc), not the full mc*kc/nc*kc. if the total fit PACK_TLS_BYTES
+* (and no huge page) it is carved from a per thread buffer kept across calls, so a small gemm
+* touch no fresh page. c_acc_nc != 0 is the c_acc mode: B at that nc, plus the mc x nc C_acc
+*/
+struct sgemm_ws_t {
+    float * A_pack {nullptr};
+    float * B_pack {nullptr};
+    float * C_acc {nullptr};
+    size_t  a_bytes {0};
+    size_t  b_bytes {0};
+    size_t  c_bytes {0};
+    bool    tls {false};
+};
+void sgemm_ws_alloc(int M, int N, int K, const gemm_context_t * ctx, sgemm_ws_t & ws,
+                size_t c_acc_nc = 0);
+void sgemm_ws_free(sgemm_ws_t & ws, const gemm_context_t * ctx);
+
+// workspace of the last sgemm_ws_alloc() of this thread, for the driver report
+struct sgemm_ws_stats_t {
+    size_t  bytes {0};          // a + b + c bytes
+    size_t  full_bytes {0};     // same at full mc/nc/kc, what it was before right sizing
+    bool    tls {false};
+};
+sgemm_ws_stats_t sgemm_ws_last();
+void sgemm_ws_reset();
+
+// C edge of a M0 x N0 (multiple of mr/nr) call, taken by sgemm_n_nn for any M/N: the M%mr rows
+// and N%nr columns zero padded to a full tile and run on the same micro kernel, a lone M%mr row
+// by a plain loop. single thread
+void sgemm_n_nn_edge(
+                int M, int N, int K, int M0, int N0,
+                float alpha,
+                const float *A, int lda,
+                const float *B, int ldb,
+                float beta,
+                float *C, int ldc,
+                const gemm_context_t * ctx);
+
+/*
+* scratch of one call besides the pack workspace: the transposed operand copy of libgemm_opt.so
+* and the zero padded strips of sgemm_n_nn_edge. each slot is a per thread buffer grown to the
+* largest request up to SCRATCH_TLS_BYTES and kept across calls, so a small gemm does no malloc.
+* bigger (or nested, slot busy) request is a plain allocation. put() every get()
+*/
+enum sgemm_scratch_slot_t {
+    SCRATCH_A_TRANS = 0,
+    SCRATCH_B_TRANS,
+    SCRATCH_EDGE_A,
+    SCRATCH_EDGE_B,
+    SCRATCH_EDGE_C,
+    SCRATCH_SLOTS,
+};
+float * sgemm_scratch_get(sgemm_scratch_slot_t slot, size_t bytes);
+void sgemm_scratch_put(sgemm_scratch_slot_t slot, float * buf);
+
+// c_acc mode, C accumulated in a packed tile ordered buffer across kc blocks, see gemm_opt.cc.
+// single thread, taken by cblas_sgemm_opt() if ctx->c_acc and K > kc
+void sgemm_n_nn_acc(
+                int M, int N, int K,
+                float alpha,
+                const float *A, int lda,
+                const float *B, int ldb,
+                float beta,
+                float *C, int ldc,
+                const gemm_context_t * ctx);
+// nc of c_acc mode, ctx->nc clipped so the mc*nc accumulator fit 1/C_ACC_L2_RATIO of L2
+size_t sgemm_c_acc_nc(const gemm_context_t * ctx);
+
+// pipelined pack, see gemm_pipe.cc. stats is optional, if set the stages are timed
+struct sgemm_pipe_stats_t {
+    int     stages {0};         // macro kernel calls, each one B pack and maybe an A pack
+    int     helper_cpu {-1};    // smt sibling the helper was pinned on, -1 if caller mask inherited
+    double  pack_sec {0};       // helper time inside sgemm_pack
+    double  wait_sec {0};       // caller time spinning for a packed stage, the pack not hidden
+    double  total_sec {0};
+};
+void sgemm_n_nn_pipe(
+                int M, int N, int K,
+                float alpha,
+                const float *A, int lda,
+                const float *B, int ldb,
+                float beta,
+                float *C, int ldc,
+                const gemm_context_t * ctx,
+                sgemm_pipe_stats_t * stats);
+
+// multi thread, work stealing over C macro tiles, see gemm_steal.cc. taken by
+// cblas_sgemm_opt() if ctx->steal and threads > 1. allow_steal false is a static split
+struct sgemm_steal_stats_t {
+    int     tile_m {0};
+    int     tile_n {0};
+    int     tiles {0};
+    int     steals {0};                 // successful steal, each move half a victim range
+    std::vector<int> worker_tasks;      // tiles run by each worker
+};
+void sgemm_n_nn_steal(
+                int M, int N, int K,
+                float alpha,
+                const float *A, int lda,
+                const float *B, int ldb,
+                float beta,
+                float *C, int ldc,
+                const gemm_context_t * ctx,
+                bool allow_steal,
+                sgemm_steal_stats_t * stats);
+
+// multi thread, numa aware. in gemm_numa.cc
+void sgemm_n_nn_numa(
+                int M, int N, int K,
+                float alpha,
+                const float *A, int lda,
+                const float *B, int ldb,
+                float beta,
+                float *C, int ldc,
+                const gemm_context_t * ctx);
+
+#endif
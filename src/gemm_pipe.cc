@@ -0,0 +1,171 @@
+#include "gemm_driver.h"
+#include "gemm_opt.h"
+#include "topology.h"
+#include "kernel/sgemm_pack.h"
+
+#include <thread>
+#include <atomic>
+#include <immintrin.h>
+
+/*
+* pipelined pack, single compute thread. C row major, A row major, B row major
+*
+* same loop as sgemm_n_nn(), flattened into a list of stages, one per macro kernel:
+*
+*   for mm in M, step mc
+*     for kk in K, step kc
+*       for nn in N, step nc
+*         stage i: A(mm,kk) in A_pack[a_slot], B(kk,nn) in B_pack[i%2]
+*
+* a helper thread, pinned on the smt sibling of the caller, pack stage i+1 (its B, and
+* its A if it start a new mm/kk) into the other slot while the caller run the macro kernel
+* of stage i. handoff is two counters, no lock:
+*   packed      helper store i+1 after stage i is packed, caller spin until packed > i
+*   consumed    caller store i+1 after stage i is computed, helper spin until
+*               consumed >= i-1 before it overwrite the slot of stage i-2
+* a stage whose A is new always come after at least one stage of the previous A, so slot
+* of A group g-2 is also free by then.
+*
+* result is bit identical to sgemm_n_nn(), pack and kernel are the same calls.
+*/
+
+struct pipe_stage_t {
+    int     mm, mc_size;
+    int     kk, kc_size;
+    int     nn, nc_size;
+    int     a_slot;
+    bool    new_a;      // first stage of this mm/kk, A need pack
+};
+
+struct pipe_shared_t {
+    std::atomic<int>    packed {0};
+    std::atomic<int>    consumed {0};
+    double              pack_sec {0};   // helper only, read after join
+};
+
+static void sgemm_pipe_helper(pipe_shared_t * sh, int cpu,
+                const std::vector<pipe_stage_t> * stages,
+                float alpha,
+                const float *A, int lda,
+                const float *B, int ldb,
+                float ** A_pack, float ** B_pack,
+                bool timing,
+                const gemm_context_t * ctx)
+{
+    if(cpu >= 0){
+        std::vector<int> affinity;
+        affinity.push_back(cpu);
+        set_current_affinity(affinity);
+    }
+    int num = stages->size();
+    double t = 0;
+    for(int i=0; i<num; i++){
+        const pipe_stage_t & s = (*stages)[i];
+        spin_wait_ge(sh->consumed, i-1);
+        if(timing)
+            t = current_sec();
+        if(s.new_a)
+            sgemm_pack(LAYOUT_ROW_MAJOR, TRANS_NO_TRANS, IDENT_A_MATRIX,
+                s.mc_size, 0, s.kc_size,
+                alpha, A + s.mm*lda + s.kk, lda, A_pack[s.a_slot], ctx);
+        sgemm_pack(LAYOUT_ROW_MAJOR, TRANS_NO_TRANS, IDENT_B_MATRIX,
+            0, s.nc_size, s.kc_size,
+            alpha, B + s.kk*ldb + s.nn, ldb, B_pack[i%2], ctx);
+        if(timing)
+            sh->pack_sec += current_sec() - t;
+        sh->packed.store(i+1, std::memory_order_release);
+    }
+}
+
+void sgemm_n_nn_pipe(
+                int M, int N, int K,
+                float alpha,
+                const float *A, int lda,
+                const float *B, int ldb,
+                float beta,
+                float *C, int ldc,
+                const gemm_context_t * ctx,
+                sgemm_pipe_stats_t * stats)
+{
+    int mc = ctx->mc;
+    int nc = ctx->nc;
+    int kc = ctx->kc;
+    int mm, nn, kk;
+
+    std::vector<pipe_stage_t> stages;
+    int a_group = 0;
+    for(mm=0; mm<M; mm += mc){
+        for(kk=0; kk<K; kk += kc){
+            for(nn=0; nn<N; nn += nc){
+                pipe_stage_t s;
+                s.mm = mm;  s.mc_size = MIN(M-mm, mc);
+                s.kk = kk;  s.kc_size = MIN(K-kk, kc);
+                s.nn = nn;  s.nc_size = MIN(N-nn, nc);
+                s.a_slot = a_group % 2;
+                s.new_a = (nn == 0);
+                stages.push_back(s);
+            }
+            a_group++;
+        }
+    }
+
+    // sized to the problem as sgemm_ws_alloc(), on heap as the pack thread share it
+    size_t a_bytes = CEIL_WRAP((size_t)MIN(M, mc), ctx->mr)*MIN(K, kc)*sizeof(float);
+    size_t b_bytes = CEIL_WRAP((size_t)MIN(N, nc), ctx->nr)*MIN(K, kc)*sizeof(float);
+    float * A_pack[2];
+    float * B_pack[2];
+    for(int i=0;i<2;i++){
+        A_pack[i] = sgemm_alloc_pack(a_bytes, ctx);
+        B_pack[i] = sgemm_alloc_pack(b_bytes, ctx);
+    }
+
+    bool nt_store = sgemm_use_nt_store(M, N, K, beta, C, ldc, ctx);
+    bool timing = stats != nullptr;
+    int helper_cpu = smt_sibling_cpu(get_current_cpu());
+    double t_start = current_sec();
+    double wait_sec = 0;
+
+    pipe_shared_t sh;
+    std::thread helper(sgemm_pipe_helper, &sh, helper_cpu, &stages,
+        alpha, A, lda, B, ldb, A_pack, B_pack, timing, ctx);
+
+    int num = stages.size();
+    for(int i=0; i<num; i++){
+        const pipe_stage_t & s = stages[i];
+        if(timing){
+            double t = current_sec();
+            spin_wait_ge(sh.packed, i+1);
+            wait_sec += current_sec() - t;
+        }else{
+            spin_wait_ge(sh.packed, i+1);
+        }
+        float * c_block = C + s.mm*ldc + s.nn;
+        if(nt_store){
+            sgemm_macro_kernel_n_tn_nt(s.mc_size, s.nc_size, s.kc_size,
+                alpha, A_pack[s.a_slot], B_pack[i%2],
+                beta, c_block, ldc, ctx);
+        }else{
+            if(s.kk == 0)
+                scale_C(s.mc_size, s.nc_size, beta, c_block, ldc);
+            sgemm_macro_kernel_n_tn(s.mc_size, s.nc_size, s.kc_size,
+                alpha, A_pack[s.a_slot], B_pack[i%2],
+                beta, c_block, ldc, ctx);
+        }
+        sh.consumed.store(i+1, std::memory_order_release);
+    }
+    helper.join();
+    if(nt_store)
+        _mm_sfence();
+
+    if(stats){
+        stats->stages = num;
+        stats->helper_cpu = helper_cpu;
+        stats->pack_sec = sh.pack_sec;
+        stats->wait_sec = wait_sec;
+        stats->total_sec = current_sec() - t_start;
+    }
+    for(int i=0;i<2;i++){
+        sgemm_free_pack(A_pack[i], a_bytes, ctx);
+        sgemm_free_pack(B_pack[i], b_bytes, ctx);
+    }
+}
@@ -0,0 +1,142 @@
+#include "gemm_plan.h"
+#include "gemm_opt.h"
+#include "gemm_config.h"
+
+#include <immintrin.h>
+
+static void sgemm_plan_split(int total, int block, std::vector<sgemm_plan_block_t> & blocks){
+    blocks.clear();
+    for(int i=0; i<total; i+=block)
+        blocks.push_back({i, MIN(total-i, block)});
+}
+
+sgemm_plan_t * sgemm_plan_create(layout_t layout, trans_t trans_a, trans_t trans_b,
+                int M, int N, int K,
+                int lda, int ldb, int ldc,
+                const gemm_context_t * ctx)
+{
+    if(layout != LAYOUT_ROW_MAJOR ||
+        !(trans_a == TRANS_NO_TRANS || trans_a == TRANS_CONJ_NO_TRANS) ||
+        !(trans_b == TRANS_NO_TRANS || trans_b == TRANS_CONJ_NO_TRANS)){
+        std::cerr<<"sgemm plan: only row major NN is supported, "<<to_layout_str(layout)<<
+            " "<<to_trans_str(trans_a)<<" "<<to_trans_str(trans_b)<<std::endl;
+        return nullptr;
+    }
+    if(M <= 0 || N <= 0 || K < 0 || (M % ctx->mr) || (N % ctx->nr)){
+        std::cerr<<"sgemm plan: M:"<<M<<", N:"<<N<<", K:"<<K<<" not multiple of mr:"<<ctx->mr<<
+            ", nr:"<<ctx->nr<<std::endl;
+        return nullptr;
+    }
+
+    sgemm_plan_t * plan = new sgemm_plan_t;
+    plan->ctx = *ctx;
+    plan->M = M;    plan->N = N;    plan->K = K;
+    plan->lda = lda;    plan->ldb = ldb;    plan->ldc = ldc;
+
+    // blocking never larger than the problem, so small problem get small workspace
+    gemm_context_t & pctx = plan->ctx;
+    pctx.layout = layout;
+    pctx.trans_a = trans_a;
+    pctx.trans_b = trans_b;
+    pctx.m = M;     pctx.n = N;     pctx.k = K;
+    pctx.lda = lda; pctx.ldb = ldb; pctx.ldc = ldc;
+    pctx.mc = MIN(ctx->mc, (size_t)M);
+    pctx.nc = MIN(ctx->nc, (size_t)N);
+    pctx.kc = MAX(MIN(ctx->kc, (size_t)K), (size_t)1);
+    // single thread, as libgemm_opt.so cut off small calls
+    if((size_t)M*N*K < MT_MIN_MNK){
+        pctx.numa_mode = NUMA_MODE_OFF;
+        pctx.steal = false;
+    }
+
+    sgemm_plan_split(M, pctx.mc, plan->m_blocks);
+    sgemm_plan_split(N, pctx.nc, plan->n_blocks);
+    sgemm_plan_split(K, pctx.kc, plan->k_blocks);
+
+    plan->pack_a = sgemm_pack_select(LAYOUT_ROW_MAJOR, TRANS_NO_TRANS, IDENT_A_MATRIX, lda, &pctx);
+    plan->pack_b = sgemm_pack_select(LAYOUT_ROW_MAJOR, TRANS_NO_TRANS, IDENT_B_MATRIX, ldb, &pctx);
+
+    // all but beta and C address, which come with execute. a null C pass the alignment check
+    plan->nt_store = sgemm_use_nt_store(M, N, K, 0.f, nullptr, ldc, &pctx);
+    plan->nt_align = pctx.micro_kernel ? pctx.kernel_vector_bytes : 32;
+
+    bool threaded = (pctx.steal && pctx.threads > 1) || pctx.numa_mode != NUMA_MODE_OFF;
+    if(!threaded && K > 0){
+        plan->A_pack_bytes = pctx.mc*pctx.kc*sizeof(float);
+        plan->B_pack_bytes = pctx.nc*pctx.kc*sizeof(float);
+        plan->A_pack = sgemm_alloc_pack(plan->A_pack_bytes, &pctx);
+        plan->B_pack = sgemm_alloc_pack(plan->B_pack_bytes, &pctx);
+    }
+    return plan;
+}
+
+void sgemm_plan_execute(const sgemm_plan_t * plan,
+                float alpha,
+                const float *A,
+                const float *B,
+                float beta,
+                float *C)
+{
+    const gemm_context_t * ctx = &plan->ctx;
+    int lda = plan->lda;
+    int ldb = plan->ldb;
+    int ldc = plan->ldc;
+    if(plan->K == 0){
+        scale_C(plan->M, plan->N, beta, C, ldc);
+        return;
+    }
+    // same order as sgemm_n_nn()
+    if(ctx->steal && ctx->threads > 1){
+        sgemm_n_nn_steal(plan->M, plan->N, plan->K, alpha, A, lda, B, ldb, beta, C, ldc, ctx, true, nullptr);
+        return;
+    }
+    if(ctx->numa_mode != NUMA_MODE_OFF){
+        sgemm_n_nn_numa(plan->M, plan->N, plan->K, alpha, A, lda, B, ldb, beta, C, ldc, ctx);
+        return;
+    }
+
+    if(ctx->c_acc && (size_t)plan->K > ctx->kc){
+        sgemm_n_nn_acc(plan->M, plan->N, plan->K, alpha, A, lda, B, ldb, beta, C, ldc, ctx);
+        return;
+    }
+    if(ctx->pipe){
+        sgemm_n_nn_pipe(plan->M, plan->N, plan->K, alpha, A, lda, B, ldb, beta, C, ldc, ctx, nullptr);
+        return;
+    }
+
+    bool nt_store = plan->nt_store && beta == 0.f && ((size_t)C % plan->nt_align) == 0;
+    float * A_pack = plan->A_pack;
+    float * B_pack = plan->B_pack;
+
+    // same loop and pack order as sgemm_n_nn(), result is bit identical
+    for(const sgemm_plan_block_t & mb : plan->m_blocks){
+        for(const sgemm_plan_block_t & kb : plan->k_blocks){
+            plan->pack_a(mb.size, 0, kb.size, alpha, A + mb.offset*lda + kb.offset, lda, A_pack, ctx);
+            for(const sgemm_plan_block_t & nb : plan->n_blocks){
+                plan->pack_b(0, nb.size, kb.size, alpha, B + kb.offset*ldb + nb.offset, ldb, B_pack, ctx);
+                float * c_block = C + mb.offset*ldc + nb.offset;
+                if(nt_store){
+                    sgemm_macro_kernel_n_tn_nt(mb.size, nb.size, kb.size,
+                        alpha, A_pack, B_pack, beta, c_block, ldc, ctx);
+                    continue;
+                }
+                if(kb.offset == 0)
+                    scale_C(mb.size, nb.size, beta, c_block, ldc);
+                sgemm_macro_kernel_n_tn(mb.size, nb.size, kb.size,
+                    alpha, A_pack, B_pack, beta, c_block, ldc, ctx);
+            }
+        }
+    }
+    if(nt_store)
+        _mm_sfence();
+}
+
+void sgemm_plan_destroy(sgemm_plan_t * plan){
+    if(!plan)
+        return;
+    if(plan->A_pack)
+        sgemm_free_pack(plan->A_pack, plan->A_pack_bytes, &plan->ctx);
+    if(plan->B_pack)
+        sgemm_free_pack(plan->B_pack, plan->B_pack_bytes, &plan->ctx);
+    delete plan;
+}
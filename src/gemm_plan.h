@@ -0,0 +1,63 @@
+#ifndef __GEMM_PLAN_H
+#define __GEMM_PLAN_H
+
+#include "gemm_driver.h"
+#include "kernel/sgemm_pack.h"
+
+/*
+* fftw style plan. everything cblas_sgemm_opt() decide per call is decided once in
+* sgemm_plan_create() for a fixed problem, then sgemm_plan_execute() only run the
+* loops on new A/B/C pointers:
+*   dispatch    layout/trans branch, pack function for A/B (by ld, see sgemm_pack_select)
+*   kernel      micro kernel and tile of ctx, and if C can be streaming stored
+*   blocking    mc/nc/kc of ctx clipped to the problem, block offset/size list of M/N/K
+*   workspace   packed A/B buffer, sized by the clipped blocking
+*   threads     steal, then numa_mode/threads of ctx, single thread below MT_MIN_MNK
+* ctx is copied, so tuned blocking should be applied to ctx before create, and later
+* change of ctx does not affect the plan.
+*
+* only row major NN, M%mr==0 and N%nr==0 (cblas_sgemm_opt() pad the edge, a plan does not).
+* create return nullptr otherwise. a plan own its workspace, execute the same plan from one thread at a
+* time. multi thread plan (steal, numa_mode not off), c_acc plan with K > kc and pipe plan
+* still alloc their workspace per execute.
+*/
+struct sgemm_plan_block_t {
+    int     offset;
+    int     size;
+};
+
+struct sgemm_plan_t {
+    gemm_context_t      ctx;
+    int                 M, N, K;
+    int                 lda, ldb, ldc;
+
+    sgemm_pack_func_t   pack_a {nullptr};
+    sgemm_pack_func_t   pack_b {nullptr};
+    bool                nt_store {false};   // if beta==0 and C aligned to nt_align at execute
+    size_t              nt_align {32};
+
+    std::vector<sgemm_plan_block_t> m_blocks;
+    std::vector<sgemm_plan_block_t> n_blocks;
+    std::vector<sgemm_plan_block_t> k_blocks;
+
+    float *             A_pack {nullptr};
+    float *             B_pack {nullptr};
+    size_t              A_pack_bytes {0};
+    size_t              B_pack_bytes {0};
+};
+
+sgemm_plan_t * sgemm_plan_create(layout_t layout, trans_t trans_a, trans_t trans_b,
+                int M, int N, int K,
+                int lda, int ldb, int ldc,
+                const gemm_context_t * ctx);
+
+void sgemm_plan_execute(const sgemm_plan_t * plan,
+                float alpha,
+                const float *A,
+                const float *B,
+                float beta,
+                float *C);
+
+void sgemm_plan_destroy(sgemm_plan_t * plan);
+
+#endif
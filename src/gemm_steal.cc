@@ -0,0 +1,252 @@
+#include "gemm_driver.h"
+#include "gemm_opt.h"
+#include "gemm_config.h"
+#include "topology.h"
+#include "kernel/sgemm_pack.h"
+
+#include <thread>
+#include <atomic>
+#include <immintrin.h>
+
+/*
+* work stealing multi thread sgemm. C row major, A row major, B row major
+*
+* C is cut into macro tiles of tile_m x tile_n (mc x nc, shrunk until there are at least
+* STEAL_TASKS_PER_THREAD tiles per thread), each tile is one task that run the whole K:
+*
+*   for kk in K, step kc
+*     pack A(tile_m*kc), pack B(kc*tile_n), private to the worker
+*     macro kernel
+*
+* tiles are numbered row major and every worker start with a continuous slice, so the
+* tiles it run back to back share the A rows (and with K<=kc the packed A is reused).
+* the queue of a worker is a [head, tail) range of tile index in one 64 bit atomic:
+*   owner   take one tile from head, cas
+*   thief   take the back half from tail, cas, then publish it as its own range
+* both end are moved by cas of the same word, no lock. victim order is the workers of
+* the same numa node first (shared L3), nearest index first, then other nodes. a thief
+* take the tiles the victim would reach last, which are next to each other, so its own
+* pack reuse keep working. a worker quit when its range and all victims are empty. a
+* range in flight between victim and thief is still done by the thief.
+*
+* with allow_steal false every worker only run its own slice, same as a static split.
+*/
+
+struct steal_queue_t {
+    alignas(64) std::atomic<unsigned long long> range {0};
+};
+
+static inline unsigned long long steal_range(unsigned head, unsigned tail){
+    return ((unsigned long long)tail << 32) | head;
+}
+static inline unsigned steal_head(unsigned long long r){ return (unsigned)(r & 0xffffffffULL); }
+static inline unsigned steal_tail(unsigned long long r){ return (unsigned)(r >> 32); }
+
+struct steal_shared_t {
+    int             tiles_m;
+    int             tiles_n;
+    int             tile_m;
+    int             tile_n;
+    bool            allow_steal;
+    steal_queue_t * queues;
+    int             num_workers;
+};
+
+struct steal_worker_arg_t {
+    int                 cpu;
+    int                 idx;
+    std::vector<int>    victims;
+    int                 tasks {0};  // written by this worker, read after join
+    int                 steals {0};
+};
+
+// owner side, one tile from the head
+static bool steal_pop_own(steal_queue_t * q, unsigned & tile){
+    unsigned long long r = q->range.load(std::memory_order_acquire);
+    while(steal_head(r) < steal_tail(r)){
+        if(q->range.compare_exchange_weak(r, steal_range(steal_head(r)+1, steal_tail(r)),
+                std::memory_order_acq_rel, std::memory_order_acquire)){
+            tile = steal_head(r);
+            return true;
+        }
+    }
+    return false;
+}
+
+// thief side, back half of the victim, published into the (empty) own queue
+static bool steal_from(steal_queue_t * victim, steal_queue_t * own){
+    unsigned long long r = victim->range.load(std::memory_order_acquire);
+    while(steal_head(r) < steal_tail(r)){
+        unsigned head = steal_head(r);
+        unsigned tail = steal_tail(r);
+        unsigned take = (tail - head + 1) / 2;
+        if(victim->range.compare_exchange_weak(r, steal_range(head, tail - take),
+                std::memory_order_acq_rel, std::memory_order_acquire)){
+            own->range.store(steal_range(tail - take, tail), std::memory_order_release);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void sgemm_n_nn_steal_worker(steal_worker_arg_t * arg,
+                const steal_shared_t * sh,
+                int M, int N, int K,
+                float alpha,
+                const float *A, int lda,
+                const float *B, int ldb,
+                float beta,
+                float *C, int ldc,
+                const gemm_context_t * ctx)
+{
+    int kc = ctx->kc;
+    int kc_size, kk;
+
+    std::vector<int> affinity;
+    affinity.push_back(arg->cpu);
+    set_current_affinity(affinity);
+
+    float * A_pack = sgemm_alloc_pack(sh->tile_m*kc*sizeof(float), ctx);
+    float * B_pack = sgemm_alloc_pack(sh->tile_n*kc*sizeof(float), ctx);
+    bool nt_store = sgemm_use_nt_store(M, N, K, beta, C, ldc, ctx);
+    // what A_pack hold, only meaningful if K fit in one kc block
+    int packed_a_row = -1;
+    bool reuse_a = K <= kc;
+
+    steal_queue_t * own = &sh->queues[arg->idx];
+    unsigned tile;
+    while(1){
+        if(!steal_pop_own(own, tile)){
+            bool stolen = false;
+            if(sh->allow_steal){
+                for(int v : arg->victims){
+                    if(steal_from(&sh->queues[v], own)){
+                        stolen = true;
+                        arg->steals++;
+                        break;
+                    }
+                }
+            }
+            if(!stolen)
+                break;
+            continue;
+        }
+        int tm = tile / sh->tiles_n;
+        int tn = tile % sh->tiles_n;
+        int mm = tm * sh->tile_m;
+        int nn = tn * sh->tile_n;
+        int mc_size = MIN(M-mm, sh->tile_m);
+        int nc_size = MIN(N-nn, sh->tile_n);
+        float * c_block = C + mm*ldc + nn;
+        for(kk=0; kk<K; kk += kc){
+            kc_size = MIN(K-kk, kc);
+            if(!reuse_a || packed_a_row != tm){
+                sgemm_pack(LAYOUT_ROW_MAJOR, TRANS_NO_TRANS, IDENT_A_MATRIX,
+                    mc_size, 0, kc_size,
+                    alpha, A + mm*lda + kk, lda, A_pack, ctx);
+                packed_a_row = tm;
+            }
+            sgemm_pack(LAYOUT_ROW_MAJOR, TRANS_NO_TRANS, IDENT_B_MATRIX,
+                0, nc_size, kc_size,
+                alpha, B + kk*ldb + nn, ldb, B_pack, ctx);
+            if(nt_store){
+                sgemm_macro_kernel_n_tn_nt(mc_size, nc_size, kc_size,
+                    alpha, A_pack, B_pack, beta, c_block, ldc, ctx);
+                continue;
+            }
+            if(kk == 0)
+                scale_C(mc_size, nc_size, beta, c_block, ldc);
+            sgemm_macro_kernel_n_tn(mc_size, nc_size, kc_size,
+                alpha, A_pack, B_pack, beta, c_block, ldc, ctx);
+        }
+        arg->tasks++;
+    }
+    if(nt_store)
+        _mm_sfence();
+    sgemm_free_pack(A_pack, sh->tile_m*kc*sizeof(float), ctx);
+    sgemm_free_pack(B_pack, sh->tile_n*kc*sizeof(float), ctx);
+}
+
+void sgemm_n_nn_steal(
+                int M, int N, int K,
+                float alpha,
+                const float *A, int lda,
+                const float *B, int ldb,
+                float beta,
+                float *C, int ldc,
+                const gemm_context_t * ctx,
+                bool allow_steal,
+                sgemm_steal_stats_t * stats)
+{
+    static const std::vector<numa_node_t> nodes = [](){
+        std::vector<numa_node_t> n;
+        numa_discover_nodes(n);
+        return n;
+    }();
+    std::vector<numa_worker_t> workers;
+    numa_assign_workers(nodes, MAX(ctx->threads, (size_t)1), workers, ctx->place,
+        ctx->cpu_list.size() > 1 ? ctx->cpu_list : std::vector<int>());
+    int num_workers = workers.size();
+
+    // shrink n first (B panel is repacked per tile anyway), then m, keep mr/nr multiple.
+    // workers sharing a core split its L2, so the A block is divided by their count
+    int mr = ctx->mr;
+    int nr = ctx->nr;
+    int share = workers_per_core(workers);
+    int tile_m = MIN(MAX((int)ctx->mc / share / mr * mr, mr), CEIL(M, mr)*mr);
+    int tile_n = MIN((int)ctx->nc, CEIL(N, nr)*nr);
+    int want = num_workers * STEAL_TASKS_PER_THREAD;
+    while(CEIL(M, tile_m)*CEIL(N, tile_n) < want && tile_n > nr)
+        tile_n = MAX(CEIL(tile_n/2, nr)*nr, nr);
+    while(CEIL(M, tile_m)*CEIL(N, tile_n) < want && tile_m > mr)
+        tile_m = MAX(CEIL(tile_m/2, mr)*mr, mr);
+
+    steal_shared_t sh;
+    sh.tile_m = tile_m;
+    sh.tile_n = tile_n;
+    sh.tiles_m = CEIL(M, tile_m);
+    sh.tiles_n = CEIL(N, tile_n);
+    sh.allow_steal = allow_steal;
+    sh.num_workers = num_workers;
+    std::vector<steal_queue_t> queues(num_workers);
+    sh.queues = queues.data();
+
+    int num_tiles = sh.tiles_m * sh.tiles_n;
+    std::vector<steal_worker_arg_t> args(num_workers);
+    for(int w=0;w<num_workers;w++){
+        unsigned head = (unsigned)((long long)num_tiles * w / num_workers);
+        unsigned tail = (unsigned)((long long)num_tiles * (w+1) / num_workers);
+        queues[w].range.store(steal_range(head, tail), std::memory_order_relaxed);
+        args[w].cpu = workers[w].cpu;
+        args[w].idx = w;
+        // same node first, by ring distance, then the rest
+        for(int pass=0; pass<2; pass++){
+            for(int d=1; d<num_workers; d++){
+                int v = (w + d) % num_workers;
+                bool same = workers[v].node_idx == workers[w].node_idx;
+                if(same == (pass == 0))
+                    args[w].victims.push_back(v);
+            }
+        }
+    }
+
+    std::vector<std::thread> threads;
+    for(int w=0;w<num_workers;w++){
+        threads.push_back(std::thread(sgemm_n_nn_steal_worker, &args[w], &sh,
+            M, N, K, alpha, A, lda, B, ldb, beta, C, ldc, ctx));
+    }
+    for(auto & t : threads)
+        t.join();
+
+    if(stats){
+        stats->tile_m = tile_m;
+        stats->tile_n = tile_n;
+        stats->tiles = num_tiles;
+        stats->worker_tasks.clear();
+        stats->steals = 0;
+        for(int w=0;w<num_workers;w++){
+            stats->worker_tasks.push_back(args[w].tasks);
+            stats->steals += args[w].steals;
+        }
+    }
+}
@@ -0,0 +1,269 @@
+#include "gemm_strassen.h"
+#include "gemm_opt.h"
+#include "kernel/sgemm_micro_kernel.h"
+#include "kernel/sgemm_pack.h"
+
+#define STRASSEN_MAX_LEVEL  4
+#define STRASSEN_MAX_TERMS  (1<<STRASSEN_MAX_LEVEL)
+
+// sub matrix and its coef in a sum operand, or a C destination of a product
+struct strassen_term_t {
+    const float *   ptr;
+    float           coef;
+};
+struct strassen_dest_t {
+    float *         ptr;
+    float           coef;
+};
+typedef std::vector<strassen_term_t> strassen_src_t;
+typedef std::vector<strassen_dest_t> strassen_dst_t;
+
+struct strassen_ws_t {
+    float *     A_pack;
+    float *     B_pack;
+    float *     tile;       // mr*nr, product of one micro tile for multi destination
+    size_t      A_bytes;
+    size_t      B_bytes;
+};
+
+/*
+* the 7 products of one level. quad q is row q/2, col q%2 of the half split
+*   M1 = (A11 + A22)(B11 + B22)    C11 += M1, C22 += M1
+*   M2 = (A21 + A22) B11           C21 += M2, C22 -= M2
+*   M3 = A11 (B12 - B22)           C12 += M3, C22 += M3
+*   M4 = A22 (B21 - B11)           C11 += M4, C21 += M4
+*   M5 = (A11 + A12) B22           C11 -= M5, C12 += M5
+*   M6 = (A21 - A11)(B11 + B12)    C22 += M6
+*   M7 = (A12 - A22)(B21 + B22)    C11 += M7
+* winograd variant save 3 additions by chaining the sums (S2 = S1 - A11 ...), which need
+* the sums as temporaries, so the original one is used, every sum is at most 2 terms
+*/
+struct strassen_product_t {
+    int     num_a;  int a_quad[2];  float a_coef[2];
+    int     num_b;  int b_quad[2];  float b_coef[2];
+    int     num_c;  int c_quad[2];  float c_coef[2];
+};
+static const strassen_product_t strassen_products[7] = {
+    {2, {0,3}, {1, 1},  2, {0,3}, {1, 1},  2, {0,3}, {1, 1}},
+    {2, {2,3}, {1, 1},  1, {0,0}, {1, 0},  2, {2,3}, {1,-1}},
+    {1, {0,0}, {1, 0},  2, {1,3}, {1,-1},  2, {1,3}, {1, 1}},
+    {1, {3,0}, {1, 0},  2, {2,0}, {1,-1},  2, {0,2}, {1, 1}},
+    {2, {0,1}, {1, 1},  1, {3,0}, {1, 0},  2, {0,1}, {-1,1}},
+    {2, {2,0}, {1,-1},  2, {0,1}, {1, 1},  1, {3,0}, {1, 0}},
+    {2, {1,3}, {1,-1},  2, {2,3}, {1, 1},  1, {0,0}, {1, 0}},
+};
+
+int sgemm_strassen_levels(int M, int N, int K, const gemm_context_t * ctx){
+    int cutoff = (int)ctx->strassen_cutoff;
+    int mr = ctx->mr;
+    int nr = ctx->nr;
+    if(cutoff <= 0 || (M % mr) || (N % nr))
+        return 0;
+    int levels = 0;
+    while(levels < STRASSEN_MAX_LEVEL){
+        int m = M/(2*mr)*mr;
+        int n = N/(2*nr)*nr;
+        int k = K/2;
+        if(m < cutoff || n < cutoff || k < cutoff)
+            break;
+        M = m;  N = n;  K = k;
+        levels++;
+    }
+    return levels;
+}
+
+// terms of a sum operand at (row, col), for sgemm_pack_sum()
+static int strassen_pack_terms(const strassen_src_t & src, int ld, int row, int col,
+    sgemm_pack_term_t * terms)
+{
+    int n = 0;
+    for(const strassen_term_t & t : src)
+        terms[n++] = {t.ptr + (size_t)row*ld + col, t.coef};
+    return n;
+}
+
+// one micro tile at a time into ws->tile, then added to every destination with its coef
+static void strassen_macro_kernel_multi(int mc, int nc, int kc, float alpha,
+    const float * packA, const float * packB,
+    const strassen_dst_t & dst, int row, int col, int ldc,
+    strassen_ws_t * ws, const gemm_context_t * ctx)
+{
+    sgemm_micro_kernel_t micro_kernel = ctx->micro_kernel ? ctx->micro_kernel : sgemm_micro_kernel_n_tn;
+    int mr = ctx->mr;
+    int nr = ctx->nr;
+    float * tile = ws->tile;
+    for(int mm=0; mm<mc; mm += mr){
+        for(int nn=0; nn<nc; nn += nr){
+            memset(tile, 0, mr*nr*sizeof(float));
+            micro_kernel(mr, nr, kc, alpha, packA + mm*kc, packB + nn*kc, 1.f, tile, nr);
+            for(const strassen_dest_t & d : dst){
+                float * c = d.ptr + (size_t)(row+mm)*ldc + col + nn;
+                for(int i=0; i<mr; i++){
+                    for(int j=0; j<nr; j++)
+                        c[i*ldc + j] += d.coef * tile[i*nr + j];
+                }
+            }
+        }
+    }
+}
+
+/*
+* blocked gemm of sum operands, same loop as sgemm_n_nn(). a sum operand is summed by the
+* packer itself (sgemm_pack_sum), straight into the packed A/B. coef of a single B term and
+* of a single C destination are folded into alpha of A pack, so a product with 1 term
+* operand and 1 destination is exactly the classical path
+*/
+static void strassen_fused(int M, int N, int K, float alpha,
+    const strassen_src_t & A, int lda,
+    const strassen_src_t & B, int ldb,
+    const strassen_dst_t & C, int ldc,
+    strassen_ws_t * ws, const gemm_context_t * ctx)
+{
+    if(M == 0 || N == 0 || K == 0)
+        return;
+    int mc = ctx->mc;
+    int nc = ctx->nc;
+    int kc = ctx->kc;
+    float b_scale = B.size() == 1 ? B[0].coef : 1.f;
+    float alpha_ab = alpha * b_scale * (C.size() == 1 ? C[0].coef : 1.f);
+    sgemm_pack_term_t terms[STRASSEN_MAX_TERMS];
+
+    for(int mm=0; mm<M; mm += mc){
+        int mc_size = MIN(M-mm, mc);
+        for(int kk=0; kk<K; kk += kc){
+            int kc_size = MIN(K-kk, kc);
+            if(A.size() == 1){
+                sgemm_pack(LAYOUT_ROW_MAJOR, TRANS_NO_TRANS, IDENT_A_MATRIX,
+                    mc_size, 0, kc_size,
+                    alpha_ab * A[0].coef, A[0].ptr + (size_t)mm*lda + kk, lda, ws->A_pack, ctx);
+            }else{
+                int n = strassen_pack_terms(A, lda, mm, kk, terms);
+                sgemm_pack_sum(IDENT_A_MATRIX, mc_size, 0, kc_size, alpha_ab, terms, n, lda, ws->A_pack, ctx);
+            }
+            for(int nn=0; nn<N; nn += nc){
+                int nc_size = MIN(N-nn, nc);
+                if(B.size() == 1){
+                    sgemm_pack(LAYOUT_ROW_MAJOR, TRANS_NO_TRANS, IDENT_B_MATRIX,
+                        0, nc_size, kc_size,
+                        alpha, B[0].ptr + (size_t)kk*ldb + nn, ldb, ws->B_pack, ctx);
+                }else{
+                    int n = strassen_pack_terms(B, ldb, kk, nn, terms);
+                    sgemm_pack_sum(IDENT_B_MATRIX, 0, nc_size, kc_size, alpha, terms, n, ldb, ws->B_pack, ctx);
+                }
+                if(C.size() == 1){
+                    sgemm_macro_kernel_n_tn(mc_size, nc_size, kc_size,
+                        alpha, ws->A_pack, ws->B_pack,
+                        1.f, C[0].ptr + (size_t)mm*ldc + nn, ldc, ctx);
+                }else{
+                    strassen_macro_kernel_multi(mc_size, nc_size, kc_size, alpha,
+                        ws->A_pack, ws->B_pack, C, mm, nn, ldc, ws, ctx);
+                }
+            }
+        }
+    }
+}
+
+static strassen_src_t strassen_offset(const strassen_src_t & src, int ld, int row, int col){
+    strassen_src_t r(src);
+    for(strassen_term_t & t : r)
+        t.ptr += (size_t)row*ld + col;
+    return r;
+}
+static strassen_dst_t strassen_offset(const strassen_dst_t & dst, int ld, int row, int col){
+    strassen_dst_t r(dst);
+    for(strassen_dest_t & d : r)
+        d.ptr += (size_t)row*ld + col;
+    return r;
+}
+
+// every term of every listed quadrant (rows*cols each), coef multiplied
+template<typename list_t>
+static list_t strassen_quads(const list_t & src, int ld, int rows, int cols,
+    int num, const int * quad, const float * coef)
+{
+    list_t r;
+    for(int q=0; q<num; q++){
+        for(auto t : src){
+            t.ptr += (size_t)(quad[q]/2)*rows*ld + (quad[q]%2)*cols;
+            t.coef *= coef[q];
+            r.push_back(t);
+        }
+    }
+    return r;
+}
+
+static void strassen_recursive(int M, int N, int K, float alpha,
+    const strassen_src_t & A, int lda,
+    const strassen_src_t & B, int ldb,
+    const strassen_dst_t & C, int ldc,
+    int levels, strassen_ws_t * ws, const gemm_context_t * ctx)
+{
+    int mr = ctx->mr;
+    int nr = ctx->nr;
+    int me = M/(2*mr)*(2*mr);
+    int ne = N/(2*nr)*(2*nr);
+    int ke = K/2*2;
+    if(levels == 0 || me == 0 || ne == 0 || ke == 0){
+        strassen_fused(M, N, K, alpha, A, lda, B, ldb, C, ldc, ws, ctx);
+        return;
+    }
+    int h = me/2;
+    int w = ne/2;
+    int d = ke/2;
+    for(const strassen_product_t & p : strassen_products){
+        strassen_recursive(h, w, d, alpha,
+            strassen_quads(A, lda, h, d, p.num_a, p.a_quad, p.a_coef), lda,
+            strassen_quads(B, ldb, d, w, p.num_b, p.b_quad, p.b_coef), ldb,
+            strassen_quads(C, ldc, h, w, p.num_c, p.c_quad, p.c_coef), ldc,
+            levels-1, ws, ctx);
+    }
+    // peel, C[0:me,0:ne] += A[0:me,ke:K] B[ke:K,0:ne], then right and bottom strip of C
+    if(K > ke)
+        strassen_fused(me, ne, K-ke, alpha, strassen_offset(A, lda, 0, ke), lda,
+            strassen_offset(B, ldb, ke, 0), ldb, C, ldc, ws, ctx);
+    if(N > ne)
+        strassen_fused(me, N-ne, K, alpha, A, lda, strassen_offset(B, ldb, 0, ne), ldb,
+            strassen_offset(C, ldc, 0, ne), ldc, ws, ctx);
+    if(M > me)
+        strassen_fused(M-me, N, K, alpha, strassen_offset(A, lda, me, 0), lda, B, ldb,
+            strassen_offset(C, ldc, me, 0), ldc, ws, ctx);
+}
+
+void sgemm_strassen(layout_t Layout, trans_t Trans_a, trans_t Trans_b,
+                int M, int N, int K,
+                float alpha,
+                const float *A, int lda,
+                const float *B, int ldb,
+                float beta,
+                float *C, int ldc,
+                const gemm_context_t * ctx)
+{
+    bool nn = Layout == LAYOUT_ROW_MAJOR &&
+            (Trans_a == TRANS_NO_TRANS || Trans_a == TRANS_CONJ_NO_TRANS) &&
+            (Trans_b == TRANS_NO_TRANS || Trans_b == TRANS_CONJ_NO_TRANS);
+    int levels = nn ? sgemm_strassen_levels(M, N, K, ctx) : 0;
+    if(levels == 0){
+        cblas_sgemm_opt(Layout, Trans_a, Trans_b, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc, ctx);
+        return;
+    }
+    // every product accumulate into C
+    scale_C(M, N, beta, C, ldc);
+
+    size_t mc = ctx->mc, nc = ctx->nc, kc = ctx->kc;
+    strassen_ws_t ws;
+    ws.A_bytes = mc*kc*sizeof(float);
+    ws.B_bytes = nc*kc*sizeof(float);
+    ws.A_pack = sgemm_alloc_pack(ws.A_bytes, ctx);
+    ws.B_pack = sgemm_alloc_pack(ws.B_bytes, ctx);
+    ws.tile = (float*)__aligned_malloc(ctx->mr*ctx->nr*sizeof(float), 64);
+
+    strassen_recursive(M, N, K, alpha,
+        strassen_src_t{{A, 1.f}}, lda,
+        strassen_src_t{{B, 1.f}}, ldb,
+        strassen_dst_t{{C, 1.f}}, ldc,
+        levels, &ws, ctx);
+
+    sgemm_free_pack(ws.A_pack, ws.A_bytes, ctx);
+    sgemm_free_pack(ws.B_pack, ws.B_bytes, ctx);
+    __aligned_free(ws.tile);
+}
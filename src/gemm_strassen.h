@@ -0,0 +1,37 @@
+#ifndef __GEMM_STRASSEN_H
+#define __GEMM_STRASSEN_H
+
+#include "gemm_driver.h"
+
+/*
+* strassen layer above the blocked path, for very large gemm. C row major, A/B row
+* major NN, M%mr==0 and N%nr==0 like cblas_sgemm_opt(). ctx->strassen_cutoff set the
+* smallest M/N/K a level may produce, 0 disable the layer.
+*
+* each level split M/N/K in half and do 7 products instead of 8, in the form of
+* ABC strassen (huang, smith, henry, van de geijn 2016):
+*   M_i = (X + dX*Y)(V + dV*W),  C_p += g_p*M_i, C_q += g_q*M_i
+* operand of a product is kept as a list of sub matrix pointers with a coef, never
+* summed into a temporary matrix. L levels give 2^L terms per operand and up to 2^L C
+* destinations. at the cutoff the packer read every term and sum them straight into the
+* packed mc*kc of A / kc*nc of B (sgemm_pack_sum), and each micro tile is added to every C
+* destination. workspace is the pack buffers and one mr*nr tile, no matter the levels.
+*
+* odd part of M/N/K (M%(2*mr), N%(2*nr), K%2) at every level is peeled and done by the
+* same fused path at that level, so any full tile shape can use it.
+*/
+
+// levels the layer would recurse for this shape, 0 means the classical path is used
+int sgemm_strassen_levels(int M, int N, int K, const gemm_context_t * ctx);
+
+// same signature as cblas_sgemm_opt(), fall back to it if no level apply
+void sgemm_strassen(layout_t Layout, trans_t Trans_a, trans_t Trans_b,
+                int M, int N, int K,
+                float alpha,
+                const float *A, int lda,
+                const float *B, int ldb,
+                float beta,
+                float *C, int ldc,
+                const gemm_context_t * ctx);
+
+#endif
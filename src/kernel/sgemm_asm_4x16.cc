@@ -136,18 +136,18 @@ void sgemm_asm_4x16(int m, int n, int k,
 
         "vbroadcastss   (%%rax),    %%ymm2                  \n" // A broadcast 0
         "vbroadcastss   4(%%rax),   %%ymm3                  \n" // A broadcast 1
-        "vfmadd231ps    %%ymm0,     %%ymm2,    %%ymm4       \n"
-        "vfmadd231ps    %%ymm1,     %%ymm2,    %%ymm5       \n"
-        "vfmadd231ps    %%ymm0,     %%ymm3,    %%ymm6       \n"
-        "vfmadd231ps    %%ymm1,     %%ymm3,    %%ymm7       \n"
-
-        "vbroadcastss   8(%%rax),   %%ymm2                  \n" // A broadcast 0
-        "vbroadcastss   12(%%rax),  %%ymm3                  \n" // A broadcast 1
         "vfmadd231ps    %%ymm0,     %%ymm2,    %%ymm8       \n"
         "vfmadd231ps    %%ymm1,     %%ymm2,    %%ymm9       \n"
         "vfmadd231ps    %%ymm0,     %%ymm3,    %%ymm10      \n"
         "vfmadd231ps    %%ymm1,     %%ymm3,    %%ymm11      \n"
 
+        "vbroadcastss   8(%%rax),   %%ymm2                  \n" // A broadcast 2
+        "vbroadcastss   12(%%rax),  %%ymm3                  \n" // A broadcast 3
+        "vfmadd231ps    %%ymm0,     %%ymm2,    %%ymm12      \n"
+        "vfmadd231ps    %%ymm1,     %%ymm2,    %%ymm13      \n"
+        "vfmadd231ps    %%ymm0,     %%ymm3,    %%ymm14      \n"
+        "vfmadd231ps    %%ymm1,     %%ymm3,    %%ymm15      \n"
+
         "addq           $16,        %%rax                   \n"
         "addq           $64,        %%rbx                   \n"
         "subq           $1,         %%rsi                   \n"
@@ -169,14 +169,14 @@ void sgemm_asm_4x16(int m, int n, int k,
         "vaddps         (%%rdx),    %%ymm14, %%ymm14        \n"
         "vaddps         32(%%rdx),  %%ymm15, %%ymm15        \n"
 
-        "vmovaps        %%ymm8,     (%%rax)                 \n"
-        "vmovaps        %%ymm9,     32(%%rax)               \n"
-        "vmovaps        %%ymm10,    (%%rbx)                 \n"
-        "vmovaps        %%ymm11,    32(%%rbx)               \n"
-        "vmovaps        %%ymm12,    (%%rcx)                 \n"
-        "vmovaps        %%ymm13,    32(%%rcx)               \n"
-        "vmovaps        %%ymm14,    (%%rdx)                 \n"
-        "vmovaps        %%ymm15,    32(%%rdx)               \n"
+        "vmovups        %%ymm8,     (%%rax)                 \n"
+        "vmovups        %%ymm9,     32(%%rax)               \n"
+        "vmovups        %%ymm10,    (%%rbx)                 \n"
+        "vmovups        %%ymm11,    32(%%rbx)               \n"
+        "vmovups        %%ymm12,    (%%rcx)                 \n"
+        "vmovups        %%ymm13,    32(%%rcx)               \n"
+        "vmovups        %%ymm14,    (%%rdx)                 \n"
+        "vmovups        %%ymm15,    32(%%rdx)               \n"
 
     : // output
     : // input
@@ -20,6 +20,8 @@
 *
 * A pannel col major, B pannel row major
 */
+// build does not assume avx2, only this function is compiled for it
+__attribute__((target("avx2,fma")))
 void sgemm_asm_4x8(int m, int n, int k,
     float alpha,
     const float * A, const float * B,
@@ -306,10 +308,10 @@ void sgemm_asm_4x8(int m, int n, int k,
     "vaddps         (%%rbx), %%ymm1, %%ymm1         \n"
     "vaddps         (%%rcx), %%ymm2, %%ymm2         \n"
     "vaddps         (%%rdx), %%ymm3, %%ymm3         \n"
-    "vmovaps        %%ymm0, (%%rax)                 \n"
-    "vmovaps        %%ymm1, (%%rbx)                 \n"
-    "vmovaps        %%ymm2, (%%rcx)                 \n"
-    "vmovaps        %%ymm3, (%%rdx)                 \n"
+    "vmovups        %%ymm0, (%%rax)                 \n"
+    "vmovups        %%ymm1, (%%rbx)                 \n"
+    "vmovups        %%ymm2, (%%rcx)                 \n"
+    "vmovups        %%ymm3, (%%rdx)                 \n"
     : // output
     : // input
         "r" (k_itr),  // 0
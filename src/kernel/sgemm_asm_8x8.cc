@@ -150,6 +150,8 @@ void sgemm_asm_8x8(int m, int n, int k,
         "vfmadd231ps    %%ymm4,  %%ymm2, %%ymm13        \n"
         "vfmadd231ps    %%ymm5,  %%ymm2, %%ymm14        \n"
         "vfmadd231ps    %%ymm6,  %%ymm2, %%ymm15        \n"
+        "addq           $64,    %%rax                   \n" // past the last pair, for k_rem
+        "addq           $64,    %%rbx                   \n"
         ".LOOP_ITER_DONE:                               \n"
         "                                               \n"
         "movq           %1,     %%rsi                   \n" // k_rem
@@ -268,14 +270,14 @@ void sgemm_asm_8x8(int m, int n, int k,
         "vaddps         (%%r9 ),  %%ymm5,  %%ymm5       \n"
         "vaddps         (%%r10),  %%ymm6,  %%ymm6       \n"
         "vaddps         (%%r11),  %%ymm7,  %%ymm7       \n"
-        "vmovaps        %%ymm0,   (%%rax)               \n"
-        "vmovaps        %%ymm1,   (%%rbx)               \n"
-        "vmovaps        %%ymm2,   (%%rcx)               \n"
-        "vmovaps        %%ymm3,   (%%rdx)               \n"
-        "vmovaps        %%ymm4,   (%%r8)                \n"
-        "vmovaps        %%ymm5,   (%%r9)                \n"
-        "vmovaps        %%ymm6,   (%%r10)               \n"
-        "vmovaps        %%ymm7,   (%%r11)               \n"
+        "vmovups        %%ymm0,   (%%rax)               \n"
+        "vmovups        %%ymm1,   (%%rbx)               \n"
+        "vmovups        %%ymm2,   (%%rcx)               \n"
+        "vmovups        %%ymm3,   (%%rdx)               \n"
+        "vmovups        %%ymm4,   (%%r8)                \n"
+        "vmovups        %%ymm5,   (%%r9)                \n"
+        "vmovups        %%ymm6,   (%%r10)               \n"
+        "vmovups        %%ymm7,   (%%r11)               \n"
     : // output
     : // input
         "r"(k_itr),     // 0
@@ -0,0 +1,129 @@
+#include "sgemm_intrin.h"
+#include <immintrin.h>
+
+#if defined(__clang__)
+#define SGEMM_UNROLL _Pragma("unroll")
+#else
+#define SGEMM_UNROLL _Pragma("GCC unroll 64")
+#endif
+
+// prefetch B this many unrolled iteration ahead
+#define SGEMM_INTRIN_PREFETCH_K 4
+
+#define SGEMM_TARGET_SSE42  __attribute__((target("sse4.2")))
+#define SGEMM_TARGET_AVX    __attribute__((target("avx")))
+#define SGEMM_TARGET_AVX2   __attribute__((target("avx2,fma")))
+#define SGEMM_TARGET_AVX512 __attribute__((target("avx512f")))
+
+/*
+* vector traits. width in float, num_reg is the architectural vector register,
+* tmp_reg is extra register the fmadd need (product of mul+add tier)
+*/
+struct sgemm_vec_sse42_t {
+    typedef __m128 vec_t;
+    enum { width = 4, num_reg = 16, tmp_reg = 1 };
+    SGEMM_TARGET_SSE42 static inline vec_t zero(){ return _mm_setzero_ps(); }
+    SGEMM_TARGET_SSE42 static inline vec_t load(const float * p){ return _mm_loadu_ps(p); }
+    SGEMM_TARGET_SSE42 static inline vec_t broadcast(const float * p){ return _mm_load1_ps(p); }
+    SGEMM_TARGET_SSE42 static inline vec_t fmadd(vec_t a, vec_t b, vec_t c){ return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    SGEMM_TARGET_SSE42 static inline vec_t add(vec_t a, vec_t b){ return _mm_add_ps(a, b); }
+    SGEMM_TARGET_SSE42 static inline void store(float * p, vec_t v){ _mm_storeu_ps(p, v); }
+    SGEMM_TARGET_SSE42 static inline void stream(float * p, vec_t v){ _mm_stream_ps(p, v); }
+};
+
+struct sgemm_vec_avx_t {
+    typedef __m256 vec_t;
+    enum { width = 8, num_reg = 16, tmp_reg = 1 };
+    SGEMM_TARGET_AVX static inline vec_t zero(){ return _mm256_setzero_ps(); }
+    SGEMM_TARGET_AVX static inline vec_t load(const float * p){ return _mm256_loadu_ps(p); }
+    SGEMM_TARGET_AVX static inline vec_t broadcast(const float * p){ return _mm256_broadcast_ss(p); }
+    SGEMM_TARGET_AVX static inline vec_t fmadd(vec_t a, vec_t b, vec_t c){ return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+    SGEMM_TARGET_AVX static inline vec_t add(vec_t a, vec_t b){ return _mm256_add_ps(a, b); }
+    SGEMM_TARGET_AVX static inline void store(float * p, vec_t v){ _mm256_storeu_ps(p, v); }
+    SGEMM_TARGET_AVX static inline void stream(float * p, vec_t v){ _mm256_stream_ps(p, v); }
+};
+
+struct sgemm_vec_avx2_t {
+    typedef __m256 vec_t;
+    enum { width = 8, num_reg = 16, tmp_reg = 0 };
+    SGEMM_TARGET_AVX2 static inline vec_t zero(){ return _mm256_setzero_ps(); }
+    SGEMM_TARGET_AVX2 static inline vec_t load(const float * p){ return _mm256_loadu_ps(p); }
+    SGEMM_TARGET_AVX2 static inline vec_t broadcast(const float * p){ return _mm256_broadcast_ss(p); }
+    SGEMM_TARGET_AVX2 static inline vec_t fmadd(vec_t a, vec_t b, vec_t c){ return _mm256_fmadd_ps(a, b, c); }
+    SGEMM_TARGET_AVX2 static inline vec_t add(vec_t a, vec_t b){ return _mm256_add_ps(a, b); }
+    SGEMM_TARGET_AVX2 static inline void store(float * p, vec_t v){ _mm256_storeu_ps(p, v); }
+    SGEMM_TARGET_AVX2 static inline void stream(float * p, vec_t v){ _mm256_stream_ps(p, v); }
+};
+
+struct sgemm_vec_avx512_t {
+    typedef __m512 vec_t;
+    enum { width = 16, num_reg = 32, tmp_reg = 0 };
+    SGEMM_TARGET_AVX512 static inline vec_t zero(){ return _mm512_setzero_ps(); }
+    SGEMM_TARGET_AVX512 static inline vec_t load(const float * p){ return _mm512_loadu_ps(p); }
+    SGEMM_TARGET_AVX512 static inline vec_t broadcast(const float * p){ return _mm512_set1_ps(*p); }
+    SGEMM_TARGET_AVX512 static inline vec_t fmadd(vec_t a, vec_t b, vec_t c){ return _mm512_fmadd_ps(a, b, c); }
+    SGEMM_TARGET_AVX512 static inline vec_t add(vec_t a, vec_t b){ return _mm512_add_ps(a, b); }
+    SGEMM_TARGET_AVX512 static inline void store(float * p, vec_t v){ _mm512_storeu_ps(p, v); }
+    SGEMM_TARGET_AVX512 static inline void stream(float * p, vec_t v){ _mm512_stream_ps(p, v); }
+};
+
+#define SGEMM_INTRIN_NS      sgemm_intrin_sse42
+#define SGEMM_INTRIN_TARGET  SGEMM_TARGET_SSE42
+#define SGEMM_INTRIN_VEC     sgemm_vec_sse42_t
+#include "sgemm_intrin_body.h"
+#undef SGEMM_INTRIN_NS
+#undef SGEMM_INTRIN_TARGET
+#undef SGEMM_INTRIN_VEC
+
+#define SGEMM_INTRIN_NS      sgemm_intrin_avx
+#define SGEMM_INTRIN_TARGET  SGEMM_TARGET_AVX
+#define SGEMM_INTRIN_VEC     sgemm_vec_avx_t
+#include "sgemm_intrin_body.h"
+#undef SGEMM_INTRIN_NS
+#undef SGEMM_INTRIN_TARGET
+#undef SGEMM_INTRIN_VEC
+
+#define SGEMM_INTRIN_NS      sgemm_intrin_avx2
+#define SGEMM_INTRIN_TARGET  SGEMM_TARGET_AVX2
+#define SGEMM_INTRIN_VEC     sgemm_vec_avx2_t
+#include "sgemm_intrin_body.h"
+#undef SGEMM_INTRIN_NS
+#undef SGEMM_INTRIN_TARGET
+#undef SGEMM_INTRIN_VEC
+
+#define SGEMM_INTRIN_NS      sgemm_intrin_avx512
+#define SGEMM_INTRIN_TARGET  SGEMM_TARGET_AVX512
+#define SGEMM_INTRIN_VEC     sgemm_vec_avx512_t
+#include "sgemm_intrin_body.h"
+#undef SGEMM_INTRIN_NS
+#undef SGEMM_INTRIN_TARGET
+#undef SGEMM_INTRIN_VEC
+
+#define SGEMM_INTRIN_ISA_sse42  SGEMM_ISA_SSE42
+#define SGEMM_INTRIN_ISA_avx    SGEMM_ISA_AVX
+#define SGEMM_INTRIN_ISA_avx2   SGEMM_ISA_AVX2
+#define SGEMM_INTRIN_ISA_avx512 SGEMM_ISA_AVX512
+
+// one line per tile: isa, mr, nr, k unroll
+#define SGEMM_INTRIN_KERNEL_LIST(_)     \
+    _(sse42,    6,   8, 4)              \
+    _(sse42,    4,   8, 4)              \
+    _(avx,      6,  16, 4)              \
+    _(avx,      4,  16, 4)              \
+    _(avx2,     6,  16, 4)              \
+    _(avx2,     4,  24, 4)              \
+    _(avx2,     8,   8, 8)              \
+    _(avx512,   6,  32, 4)              \
+    _(avx512,  12,  32, 4)              \
+    _(avx512,   6,  48, 4)              \
+    _(avx512,  14,  32, 4)
+
+#define SGEMM_INTRIN_KERNEL_DESC(isa, mr, nr, ku)                                   \
+    { "intrin_" #isa "_" #mr "x" #nr, mr, nr, SGEMM_INTRIN_ISA_##isa,              \
+      sgemm_intrin_##isa::sgemm_intrin_kernel<mr, nr, ku, SGEMM_EPILOGUE_ADD>,     \
+      sgemm_intrin_##isa::sgemm_intrin_kernel<mr, nr, ku, SGEMM_EPILOGUE_NT> },
+
+const sgemm_kernel_desc_t sgemm_intrin_kernels[] = {
+    SGEMM_INTRIN_KERNEL_LIST(SGEMM_INTRIN_KERNEL_DESC)
+};
+const int sgemm_intrin_kernels_count = sizeof(sgemm_intrin_kernels)/sizeof(sgemm_intrin_kernels[0]);
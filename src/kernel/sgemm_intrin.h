@@ -0,0 +1,15 @@
+#ifndef __SGEMM_INTRIN_H
+#define __SGEMM_INTRIN_H
+
+#include "sgemm_micro_kernel.h"
+
+/*
+* template micro kernel with intrinsic, portable companion of the inline asm.
+* sgemm_intrin_kernel<MR, NR, KU, EP> is compiled per isa, in namespace
+* sgemm_intrin_sse42 / _avx / _avx2 / _avx512. instantiated tiles are registered
+* by SGEMM_INTRIN_KERNEL_LIST in sgemm_intrin.cc
+*/
+extern const sgemm_kernel_desc_t sgemm_intrin_kernels[];
+extern const int sgemm_intrin_kernels_count;
+
+#endif
@@ -0,0 +1,91 @@
+/*
+* intrinsic micro kernel body, no include guard on purpose.
+* included once per isa by sgemm_intrin.cc, with:
+*   SGEMM_INTRIN_NS         namespace of this isa
+*   SGEMM_INTRIN_TARGET     function target attribute, e.g. __attribute__((target("avx2,fma")))
+*   SGEMM_INTRIN_VEC        vector traits, see sgemm_intrin.cc
+*
+* a template can not carry a target attribute depend on its parameter, and gcc refuse
+* to inline a target specific intrinsic into a function without that target, so the
+* same body is re-compiled per isa instead of templated on the traits.
+*
+* loop over template constant is forced unrolled, so acc[][] live in register.
+*/
+namespace SGEMM_INTRIN_NS {
+
+typedef SGEMM_INTRIN_VEC vec_traits_t;
+typedef vec_traits_t::vec_t vec_t;
+
+// acc += A(k) outer product B(k)
+template<int MR, int NV>
+SGEMM_INTRIN_TARGET __attribute__((always_inline))
+static inline void sgemm_intrin_rank1(vec_t (&acc)[MR][NV], const float * A, const float * B)
+{
+    vec_t b[NV];
+    SGEMM_UNROLL
+    for(int j=0; j<NV; j++)
+        b[j] = vec_traits_t::load(B + j*vec_traits_t::width);
+    SGEMM_UNROLL
+    for(int i=0; i<MR; i++){
+        vec_t a = vec_traits_t::broadcast(A + i);
+        SGEMM_UNROLL
+        for(int j=0; j<NV; j++)
+            acc[i][j] = vec_traits_t::fmadd(a, b[j], acc[i][j]);
+    }
+}
+
+template<int MR, int NR, int KU, sgemm_epilogue_t EP>
+SGEMM_INTRIN_TARGET
+void sgemm_intrin_kernel(int m, int n, int k,
+    float alpha,
+    const float * A,
+    const float * B,
+    float beta,
+    float * C,
+    int ldc)
+{
+    enum { NV = NR / vec_traits_t::width };
+    static_assert(NR % vec_traits_t::width == 0, "NR must be multiple of vector width");
+    static_assert(MR*NV + NV + 1 + vec_traits_t::tmp_reg <= vec_traits_t::num_reg,
+        "accumulator exceed vector register");
+    static_assert(KU >= 1, "k unroll at least 1");
+    (void)m; (void)n; (void)alpha; (void)beta;
+
+    vec_t acc[MR][NV];
+    SGEMM_UNROLL
+    for(int i=0; i<MR; i++)
+        SGEMM_UNROLL
+        for(int j=0; j<NV; j++)
+            acc[i][j] = vec_traits_t::zero();
+
+    int k_itr = k / KU;
+    int k_rem = k % KU;
+    for(int kk=0; kk<k_itr; kk++){
+        _mm_prefetch((const char *)(B + SGEMM_INTRIN_PREFETCH_K*KU*NR), _MM_HINT_T0);
+        SGEMM_UNROLL
+        for(int u=0; u<KU; u++)
+            sgemm_intrin_rank1<MR, NV>(acc, A + u*MR, B + u*NR);
+        A += KU*MR;
+        B += KU*NR;
+    }
+    for(int kk=0; kk<k_rem; kk++){
+        sgemm_intrin_rank1<MR, NV>(acc, A, B);
+        A += MR;
+        B += NR;
+    }
+
+    SGEMM_UNROLL
+    for(int i=0; i<MR; i++){
+        float * c_row = C + i*ldc;
+        SGEMM_UNROLL
+        for(int j=0; j<NV; j++){
+            float * c = c_row + j*vec_traits_t::width;
+            if(EP == SGEMM_EPILOGUE_NT)
+                vec_traits_t::stream(c, acc[i][j]);
+            else
+                vec_traits_t::store(c, vec_traits_t::add(acc[i][j], vec_traits_t::load(c)));
+        }
+    }
+}
+
+}   // namespace SGEMM_INTRIN_NS
@@ -0,0 +1,333 @@
+#include "sgemm_jit.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <assert.h>
+
+/*
+* minimal x86-64 encoder, only the instructions a gemm micro kernel need.
+* vector instruction use 3 byte VEX (ymm) or EVEX (zmm, L'L=2, no mask, no broadcast).
+* EVEX memory operand always use disp32, to not deal with disp8*N compression.
+*
+* generated kernel follow SysV abi, same prototype as sgemm_micro_kernel_t:
+*   edi:m, esi:n, edx:k, xmm0:alpha, rcx:A, r8:B, xmm1:beta, r9:C, [rsp+8]:ldc
+* only caller saved gpr are used (rax,rcx,rdx,r8~r11), so no prologue push/pop.
+*/
+enum {
+    REG_RAX = 0, REG_RCX, REG_RDX, REG_RBX, REG_RSP, REG_RBP, REG_RSI, REG_RDI,
+    REG_R8, REG_R9, REG_R10, REG_R11, REG_R12, REG_R13, REG_R14, REG_R15
+};
+
+#define JIT_CC_Z    0x4
+#define JIT_CC_NZ   0x5
+
+class x64_emitter_t {
+public:
+    x64_emitter_t(bool zmm_):zmm(zmm_){}
+
+    std::vector<uint8_t>    code;
+    bool                    zmm;    // EVEX 512 bit, else VEX 256 bit
+
+    void db(uint8_t b) { code.push_back(b); }
+    void dd(uint32_t d){
+        for(int i=0;i<4;i++)
+            db((d>>(8*i)) & 0xff);
+    }
+
+    // ---- gpr, all 64 bit operand
+    void mov_rr(int dst, int src){ rex_w(src, dst); db(0x89); modrm_rr(src, dst); }
+    void movsxd_rr(int dst, int src){ rex_w(dst, src); db(0x63); modrm_rr(dst, src); }
+    void movsxd_rm(int dst, int base, int disp){ rex_w(dst, base); db(0x63); modrm_mem(dst, base, disp); }
+    void add_rr(int dst, int src){ rex_w(src, dst); db(0x01); modrm_rr(src, dst); }
+    void add_ri(int dst, int32_t imm){ rex_w(0, dst); db(0x81); modrm_rr(0, dst); dd(imm); }
+    void and_ri(int dst, int32_t imm){ rex_w(0, dst); db(0x81); modrm_rr(4, dst); dd(imm); }
+    void shl_ri(int dst, uint8_t imm){ rex_w(0, dst); db(0xc1); modrm_rr(4, dst); db(imm); }
+    void shr_ri(int dst, uint8_t imm){ rex_w(0, dst); db(0xc1); modrm_rr(5, dst); db(imm); }
+    void dec_r(int dst){ rex_w(0, dst); db(0xff); modrm_rr(1, dst); }
+    void test_rr(int a, int b){ rex_w(b, a); db(0x85); modrm_rr(b, a); }
+    void prefetcht0(int base, int disp){
+        if(base & 8)
+            db(0x41);   // REX.B
+        db(0x0f); db(0x18); modrm_mem(1, base, disp);
+    }
+    void ret(){ db(0xc3); }
+    void vzeroupper(){ db(0xc5); db(0xf8); db(0x77); }
+
+    // ---- label, jcc always rel32
+    int new_label(){ labels.push_back(-1); return labels.size()-1; }
+    void bind(int label){ labels[label] = code.size(); }
+    void jcc(int cc, int label){
+        db(0x0f); db(0x80 | cc);
+        fixups.push_back(std::make_pair(code.size(), label));
+        dd(0);
+    }
+    void resolve(){
+        for(auto & f : fixups){
+            assert(labels[f.second] >= 0);
+            int32_t rel = labels[f.second] - (int)(f.first + 4);
+            memcpy(&code[f.first], &rel, 4);
+        }
+    }
+
+    // ---- vector, ymm/zmm by emitter mode
+    void vmovups_load(int dst, int base, int disp)  { vop_rm(1, 0, 0x10, dst, 0, base, disp); }
+    void vmovups_store(int base, int disp, int src) { vop_rm(1, 0, 0x11, src, 0, base, disp); }
+    void vmovntps_store(int base, int disp, int src){ vop_rm(1, 0, 0x2b, src, 0, base, disp); }
+    void vbroadcastss(int dst, int base, int disp)  { vop_rm(2, 1, 0x18, dst, 0, base, disp); }
+    // dst += src1 * src2
+    void vfmadd231ps(int dst, int src1, int src2)   { vop_rr(2, 1, 0xb8, dst, src1, src2); }
+    void vaddps_mem(int dst, int src1, int base, int disp){ vop_rm(1, 0, 0x58, dst, src1, base, disp); }
+    void vzero(int dst){
+        if(zmm)
+            vop_rr(1, 1, 0xef, dst, dst, dst);  // vpxord, avx512f has no vxorps
+        else
+            vop_rr(1, 0, 0x57, dst, dst, dst);  // vxorps
+    }
+
+private:
+    std::vector<int>                    labels;
+    std::vector<std::pair<size_t,int>>  fixups;
+
+    void rex_w(int reg, int rm){
+        db(0x48 | ((reg>>3)&1)<<2 | ((rm>>3)&1));
+    }
+    void modrm_rr(int reg, int rm){
+        db(0xc0 | (reg&7)<<3 | (rm&7));
+    }
+    void modrm_mem(int reg, int base, int disp){
+        int mod;
+        if(disp == 0 && (base&7) != REG_RBP)
+            mod = 0;
+        else if(!zmm && disp >= -128 && disp <= 127)
+            mod = 1;
+        else
+            mod = 2;
+        db(mod<<6 | (reg&7)<<3 | (base&7));
+        if((base&7) == REG_RSP)
+            db(0x24);   // sib, no index
+        if(mod == 1)
+            db((uint8_t)disp);
+        else if(mod == 2)
+            dd((uint32_t)disp);
+    }
+    // map: 1->0F, 2->0F38. pp: 0->none, 1->66
+    void vex(int map, int pp, int reg, int vvvv, int rm, bool rm_is_reg){
+        if(!zmm){
+            db(0xc4);
+            db((~reg>>3&1)<<7 | 1<<6 | (~rm>>3&1)<<5 | map);
+            db((~vvvv&15)<<3 | 1<<2 | pp);  // W0, L1
+            return ;
+        }
+        int x = rm_is_reg ? (~rm>>4&1) : 1;
+        db(0x62);
+        db((~reg>>3&1)<<7 | x<<6 | (~rm>>3&1)<<5 | (~reg>>4&1)<<4 | map);
+        db((~vvvv&15)<<3 | 1<<2 | pp);      // W0
+        db(2<<5 | (~vvvv>>4&1)<<3);         // L'L=2, no mask
+    }
+    void vop_rr(int map, int pp, uint8_t op, int reg, int vvvv, int rm){
+        vex(map, pp, reg, vvvv, rm, true);
+        db(op);
+        modrm_rr(reg, rm);
+    }
+    void vop_rm(int map, int pp, uint8_t op, int reg, int vvvv, int base, int disp){
+        vex(map, pp, reg, vvvv, base, false);
+        db(op);
+        modrm_mem(reg, base, disp);
+    }
+};
+
+static int sgemm_jit_vlen(sgemm_isa_t isa){
+    return isa == SGEMM_ISA_AVX512 ? 16 : 8;
+}
+static int sgemm_jit_num_vreg(sgemm_isa_t isa){
+    return isa == SGEMM_ISA_AVX512 ? 32 : 16;
+}
+
+std::string sgemm_jit_config_t::to_str() const {
+    std::ostringstream oss;
+    oss<<mr<<"x"<<nr<<"-u"<<unroll<<"-pf"<<prefetch<<"-"<<sgemm_isa_str(isa)<<
+        (epilogue == SGEMM_EPILOGUE_NT ? "-nt":"");
+    return oss.str();
+}
+
+void sgemm_jit_config_t::serialize(std::string & str) const {
+    std::ostringstream oss;
+    oss<<mr<<"|"<<nr<<"|"<<unroll<<"|"<<prefetch<<"|"<<(int)isa;
+    str = oss.str();
+}
+
+bool sgemm_jit_config_t::deserialize(const std::string & str){
+    std::istringstream iss(str);
+    unsigned char _d;
+    int _isa;
+    if(!(iss>>mr>>_d>>nr>>_d>>unroll>>_d>>prefetch>>_d>>_isa))
+        return false;
+    isa = (sgemm_isa_t)_isa;
+    return true;
+}
+
+bool sgemm_jit_valid_config(const sgemm_jit_config_t & cfg){
+    // encoder only emit fma, sse4.2/avx tier is intrinsic kernel only
+    if(cfg.isa != SGEMM_ISA_AVX2 && cfg.isa != SGEMM_ISA_AVX512)
+        return false;
+    int vl = sgemm_jit_vlen(cfg.isa);
+    if(cfg.mr < 1 || cfg.nr < vl || cfg.nr % vl)
+        return false;
+    if(cfg.unroll < 1 || cfg.unroll > 16 || (cfg.unroll & (cfg.unroll-1)))
+        return false;
+    if(cfg.prefetch < 0 || cfg.prefetch > 64)
+        return false;
+    int nv = cfg.nr / vl;
+    // accumulator + B vector + at least 1 broadcast
+    if(cfg.mr*nv + nv + 1 > sgemm_jit_num_vreg(cfg.isa))
+        return false;
+    return sgemm_isa_supported(cfg.isa);
+}
+
+/*
+* register allocation, nv = nr/vlen:
+*   v[0, nv)            : B row of current k
+*   v[nv, nv+nb)        : broadcast A, 2 if there is spare reg to break dependency
+*   v[nv+nb, ...)       : accumulator, mr*nv
+*/
+struct sgemm_jit_layout_t {
+    int nv;
+    int nb;
+    int vb;     // vector bytes
+    int b(int j) const { return j; }
+    int bc(int i) const { return nv + (i % nb); }
+    int acc(int i, int j) const { return nv + nb + i*nv + j; }
+};
+
+static void sgemm_jit_emit_k_iter(x64_emitter_t & e, const sgemm_jit_config_t & cfg,
+    const sgemm_jit_layout_t & l, int steps)
+{
+    int a_bytes = cfg.mr * 4;
+    int b_bytes = cfg.nr * 4;
+    for(int s=0; s<steps; s++){
+        if(cfg.prefetch){
+            if(s == 0)
+                for(int off=0; off<steps*a_bytes; off+=64)
+                    e.prefetcht0(REG_RCX, cfg.prefetch*a_bytes + off);
+            for(int off=0; off<b_bytes; off+=64)
+                e.prefetcht0(REG_R8, (s+cfg.prefetch)*b_bytes + off);
+        }
+        for(int j=0; j<l.nv; j++)
+            e.vmovups_load(l.b(j), REG_R8, s*b_bytes + j*l.vb);
+        for(int i=0; i<cfg.mr; i++){
+            e.vbroadcastss(l.bc(i), REG_RCX, s*a_bytes + i*4);
+            for(int j=0; j<l.nv; j++)
+                e.vfmadd231ps(l.acc(i,j), l.bc(i), l.b(j));
+        }
+    }
+    e.add_ri(REG_RCX, steps*a_bytes);
+    e.add_ri(REG_R8, steps*b_bytes);
+}
+
+static void sgemm_jit_emit(x64_emitter_t & e, const sgemm_jit_config_t & cfg){
+    sgemm_jit_layout_t l;
+    int vl = sgemm_jit_vlen(cfg.isa);
+    l.nv = cfg.nr / vl;
+    l.nb = (sgemm_jit_num_vreg(cfg.isa) - cfg.mr*l.nv - l.nv >= 2) ? 2 : 1;
+    l.vb = vl * 4;
+    int log2_unroll = 0;
+    while((1<<log2_unroll) < cfg.unroll)
+        log2_unroll++;
+
+    int lb_loop = e.new_label();
+    int lb_rem = e.new_label();
+    int lb_rem_loop = e.new_label();
+    int lb_post = e.new_label();
+
+    // r10: ldc in byte, rax: k/unroll, r11: k%unroll
+    e.movsxd_rm(REG_R10, REG_RSP, 8);
+    e.shl_ri(REG_R10, 2);
+    e.movsxd_rr(REG_RAX, REG_RDX);
+    e.mov_rr(REG_R11, REG_RAX);
+    e.and_ri(REG_R11, cfg.unroll-1);
+    if(log2_unroll)
+        e.shr_ri(REG_RAX, log2_unroll);
+
+    for(int i=0; i<cfg.mr; i++)
+        for(int j=0; j<l.nv; j++)
+            e.vzero(l.acc(i,j));
+
+    e.test_rr(REG_RAX, REG_RAX);
+    e.jcc(JIT_CC_Z, lb_rem);
+    e.bind(lb_loop);
+    sgemm_jit_emit_k_iter(e, cfg, l, cfg.unroll);
+    e.dec_r(REG_RAX);
+    e.jcc(JIT_CC_NZ, lb_loop);
+
+    e.bind(lb_rem);
+    e.test_rr(REG_R11, REG_R11);
+    e.jcc(JIT_CC_Z, lb_post);
+    e.bind(lb_rem_loop);
+    sgemm_jit_emit_k_iter(e, cfg, l, 1);
+    e.dec_r(REG_R11);
+    e.jcc(JIT_CC_NZ, lb_rem_loop);
+
+    // rdx: C row
+    e.bind(lb_post);
+    e.mov_rr(REG_RDX, REG_R9);
+    for(int i=0; i<cfg.mr; i++){
+        for(int j=0; j<l.nv; j++){
+            if(cfg.epilogue == SGEMM_EPILOGUE_NT){
+                e.vmovntps_store(REG_RDX, j*l.vb, l.acc(i,j));
+            }else{
+                e.vaddps_mem(l.acc(i,j), l.acc(i,j), REG_RDX, j*l.vb);
+                e.vmovups_store(REG_RDX, j*l.vb, l.acc(i,j));
+            }
+        }
+        if(i != cfg.mr-1)
+            e.add_rr(REG_RDX, REG_R10);
+    }
+    e.vzeroupper();
+    e.ret();
+    e.resolve();
+}
+
+static sgemm_micro_kernel_t sgemm_jit_generate(const sgemm_jit_config_t & cfg){
+    x64_emitter_t e(cfg.isa == SGEMM_ISA_AVX512);
+    sgemm_jit_emit(e, cfg);
+
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t bytes = (e.code.size() + page - 1) / page * page;
+    void * mem = mmap(NULL, bytes, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if(mem == MAP_FAILED){
+        std::cerr<<"jit mmap fail for "<<cfg.to_str()<<std::endl;
+        return nullptr;
+    }
+    memcpy(mem, e.code.data(), e.code.size());
+    if(mprotect(mem, bytes, PROT_READ|PROT_EXEC) != 0){
+        std::cerr<<"jit mprotect fail for "<<cfg.to_str()<<std::endl;
+        munmap(mem, bytes);
+        return nullptr;
+    }
+    return (sgemm_micro_kernel_t)mem;
+}
+
+sgemm_micro_kernel_t sgemm_jit_get_kernel(const sgemm_jit_config_t & cfg){
+    // generated code is never freed, config space is small
+    static std::map<std::string, sgemm_micro_kernel_t> cache;
+    static std::mutex lock;
+
+    if(!sgemm_jit_valid_config(cfg))
+        return nullptr;
+    std::string key = cfg.to_str();
+    std::lock_guard<std::mutex> guard(lock);
+    auto it = cache.find(key);
+    if(it != cache.end())
+        return it->second;
+    sgemm_micro_kernel_t kernel = sgemm_jit_generate(cfg);
+    if(kernel)
+        cache[key] = kernel;
+    return kernel;
+}
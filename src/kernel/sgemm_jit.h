@@ -0,0 +1,35 @@
+#ifndef __SGEMM_JIT_H
+#define __SGEMM_JIT_H
+
+#include "sgemm_micro_kernel.h"
+#include <string>
+
+/*
+* runtime generated micro kernel, same contract as sgemm_asm_6x16:
+*   C[mr*nr] (op)= packA[kc*mr] * packB[kc*nr], alpha already applied in pack,
+*   beta handled by scale_C(), full mr*nr tile only.
+*
+* code is emitted by a small built-in x86-64 encoder (VEX for avx2, EVEX for avx512),
+* no external assembler needed. generated kernels are cached per config.
+*/
+struct sgemm_jit_config_t {
+    int                 mr {6};
+    int                 nr {16};
+    int                 unroll {4};     // k unroll, power of 2, 1~16
+    int                 prefetch {4};   // prefetch distance in k iteration, 0 to disable
+    sgemm_isa_t         isa {SGEMM_ISA_AVX2};
+    sgemm_epilogue_t    epilogue {SGEMM_EPILOGUE_ADD};
+
+    std::string to_str() const;
+    // "mr|nr|unroll|prefetch|isa", epilogue is chosen by driver so not serialized
+    void serialize(std::string & str) const;
+    bool deserialize(const std::string & str);
+};
+
+// register budget, vector width and unroll check. also false if host lack the isa
+bool sgemm_jit_valid_config(const sgemm_jit_config_t & cfg);
+
+// generate or fetch from cache. return nullptr if config is not valid
+sgemm_micro_kernel_t sgemm_jit_get_kernel(const sgemm_jit_config_t & cfg);
+
+#endif
@@ -0,0 +1,71 @@
+#include "sgemm_micro_kernel.h"
+#include "sgemm_intrin.h"
+#include "../util.h"
+#include <string.h>
+#include <vector>
+
+bool sgemm_isa_supported(sgemm_isa_t isa){
+    static const bool sse42 = cpuid_support_sse42();
+    static const bool avx = cpuid_support_avx();
+    static const bool avx2 = avx && cpuid_support_avx2() && cpuid_support_fma();
+    static const bool avx512 = avx2 && cpuid_support_avx512_f();
+    if(isa == SGEMM_ISA_SSE42)
+        return sse42;
+    if(isa == SGEMM_ISA_AVX)
+        return avx;
+    if(isa == SGEMM_ISA_AVX2)
+        return avx2;
+    if(isa == SGEMM_ISA_AVX512)
+        return avx512;
+    return false;
+}
+
+static const sgemm_kernel_desc_t sgemm_asm_kernels[] = {
+    {"asm_6x16", 6, 16, SGEMM_ISA_AVX2, sgemm_micro_kernel_n_tn, sgemm_micro_kernel_n_tn_nt},
+    {"asm_4x16", 4, 16, SGEMM_ISA_AVX2, sgemm_asm_4x16, nullptr},
+    {"asm_8x8",  8,  8, SGEMM_ISA_AVX2, sgemm_asm_8x8,  nullptr},
+};
+
+static const std::vector<sgemm_kernel_desc_t> & sgemm_kernel_list(){
+    static const std::vector<sgemm_kernel_desc_t> list = [](){
+        std::vector<sgemm_kernel_desc_t> l;
+        for(const auto & desc : sgemm_asm_kernels)
+            l.push_back(desc);
+        for(int i=0;i<sgemm_intrin_kernels_count;i++)
+            l.push_back(sgemm_intrin_kernels[i]);
+        return l;
+    }();
+    return list;
+}
+
+int sgemm_kernel_count(){
+    return sgemm_kernel_list().size();
+}
+
+const sgemm_kernel_desc_t * sgemm_kernel_get(int idx){
+    return &sgemm_kernel_list()[idx];
+}
+
+const sgemm_kernel_desc_t * sgemm_kernel_find(const char * name){
+    for(const auto & desc : sgemm_kernel_list())
+        if(strcmp(desc.name, name) == 0)
+            return &desc;
+    return nullptr;
+}
+
+/*
+* avx512 is not picked by default: a wider nr change which M/N the full tile
+* kernel can take. the fallback tiers keep mr=6 and a nr dividing 16 for the same reason
+*/
+const sgemm_kernel_desc_t * sgemm_kernel_best(){
+    static const sgemm_kernel_desc_t * best = [](){
+        const char * tiers[] = {"asm_6x16", "intrin_avx_6x16", "intrin_sse42_6x8"};
+        for(const char * name : tiers){
+            const sgemm_kernel_desc_t * desc = sgemm_kernel_find(name);
+            if(desc && sgemm_isa_supported(desc->isa))
+                return desc;
+        }
+        return (const sgemm_kernel_desc_t *)nullptr;
+    }();
+    return best;
+}
@@ -2,6 +2,12 @@
 #define __GEMM_KERNEL_H
 
 
+/*
+* C tile can be any address and ldc any value. C is read by vaddps mem operand and
+* written by vmovups/storeu, same cost as the aligned form when the row happen to be
+* aligned, so no aligned/unaligned kernel pair. only the streaming store epilogue
+* (vmovntps) need every C row aligned to the vector width, see sgemm_use_nt_store()
+*/
 extern "C" void sgemm_micro_kernel_n_tn(int m, int n, int k,
     float alpha,
     const float  *   A,
@@ -10,6 +16,86 @@ extern "C" void sgemm_micro_kernel_n_tn(int m, int n, int k,
     float *  C,
     int ldc);
 
+// streaming store epilogue, C = A*B, C not loaded. need sfence after all stores
+extern "C" void sgemm_micro_kernel_n_tn_nt(int m, int n, int k,
+    float alpha,
+    const float  *   A,
+    const float *   B,
+    float beta,
+    float *  C,
+    int ldc);
+
+typedef void (*sgemm_micro_kernel_t)(int m, int n, int k,
+    float alpha,
+    const float  *   A,
+    const float *   B,
+    float beta,
+    float *  C,
+    int ldc);
+
+// instruction set of a micro kernel. value is stored in tuned db, append only
+typedef enum {
+    SGEMM_ISA_AVX2 = 0,     // ymm, fma3
+    SGEMM_ISA_AVX512,       // zmm, avx512f
+    SGEMM_ISA_SSE42,        // xmm, mul+add. fallback for pre-avx host
+    SGEMM_ISA_AVX           // ymm, mul+add. sandy/ivy bridge, or vm hide fma
+}sgemm_isa_t;
+
+// how the micro kernel write the accumulated tile back to C
+typedef enum {
+    SGEMM_EPILOGUE_ADD = 0, // C += acc, beta is applied before by scale_C()
+    SGEMM_EPILOGUE_NT       // C = acc, streaming store, C not loaded
+}sgemm_epilogue_t;
+
+static inline const char * sgemm_isa_str(sgemm_isa_t isa){
+    if(isa == SGEMM_ISA_AVX2)
+        return "avx2";
+    if(isa == SGEMM_ISA_AVX512)
+        return "avx512";
+    if(isa == SGEMM_ISA_SSE42)
+        return "sse4.2";
+    if(isa == SGEMM_ISA_AVX)
+        return "avx";
+    return "n/a isa";
+}
+
+static inline int sgemm_isa_vector_bytes(sgemm_isa_t isa){
+    if(isa == SGEMM_ISA_SSE42)
+        return 16;
+    if(isa == SGEMM_ISA_AVX512)
+        return 64;
+    return 32;
+}
+
+// cpuid check, result cached. avx2 tier also need fma
+bool sgemm_isa_supported(sgemm_isa_t isa);
+
+// other hand written kernels, same contract as 6x16.
+// sgemm_asm_4x8 does not match current packing and is not registered
+void sgemm_asm_8x8(int m, int n, int k, float alpha, const float * A, const float * B,
+    float beta, float * C, int ldc);
+void sgemm_asm_4x16(int m, int n, int k, float alpha, const float * A, const float * B,
+    float beta, float * C, int ldc);
+
+/*
+* registry of built-in micro kernels, asm and intrinsic, in sgemm_kernel_list.cc.
+* all take full mr*nr tile, packA with mr stride and packB with nr stride
+*/
+struct sgemm_kernel_desc_t {
+    const char *            name;
+    int                     mr;
+    int                     nr;
+    sgemm_isa_t             isa;
+    sgemm_micro_kernel_t    kernel;
+    sgemm_micro_kernel_t    kernel_nt;      // streaming store variant, nullptr if none
+};
+
+int sgemm_kernel_count();
+const sgemm_kernel_desc_t * sgemm_kernel_get(int idx);
+const sgemm_kernel_desc_t * sgemm_kernel_find(const char * name);  // nullptr if not found
+// default kernel of the best tier this host support: asm_6x16, else avx, else sse4.2
+const sgemm_kernel_desc_t * sgemm_kernel_best();
+
 
 #ifdef _KERNEL_SELECT
 //#define sgemm_kernel_c sgemm_micro_kernel
@@ -17,6 +103,7 @@ extern "C" void sgemm_micro_kernel_n_tn(int m, int n, int k,
 //#define sgemm_asm_8x8 sgemm_micro_kernel
 //#define sgemm_asm_4x16 sgemm_micro_kernel
 #define sgemm_asm_6x16 sgemm_micro_kernel_n_tn
+#define sgemm_asm_6x16_nt sgemm_micro_kernel_n_tn_nt
 #endif
 
 #endif
@@ -103,6 +103,7 @@ static void sgemm_pack_n_a_n_generic(int mc, int nc, int kc,
             }
             for(k=0;k<k_rem;k++){
                 v0 = *ss;  ss++;
+                v0 *= alpha;
                 *dd = v0;  dd += mr_size;
             }
             s_ptr += ld;
@@ -120,7 +121,9 @@ static void sgemm_pack_n_a_n_mr16(int mc, int nc, int kc,
     unsigned long long k_itr = kc/16;
     unsigned long long k_rem = kc%16;
     unsigned long long m_itr = mc/6;
-    unsigned long long m_rem = mc%6;
+    // asm m_rem path step k by 8 but count kc/16, so half of k is lost. tail rows
+    // (mr_size<6) go to the generic packer after the asm instead
+    unsigned long long m_rem = 0;
     unsigned long long ld_ = ld;
 #ifdef PACK_A_MULTIPLE_ALPHA
     float * alpha_addr = &alpha;
@@ -146,14 +149,14 @@ static void sgemm_pack_n_a_n_mr16(int mc, int nc, int kc,
     "je                 .LOOP_M_ITR_DONE%=          \n"
 
     ".LOOP_M_ITR%=:                                 \n"
+    "movq           %%rax,              %%r14       \n" // restore src, also used by k_rem
+    "leaq           (%%rcx, %%rcx, 2),  %%r10       \n" // 3*rcx
+    "leaq           (%%rcx, %%rcx, 4),  %%r11       \n" // 5*rcx
+
     "testq          %%rsi,              %%rsi       \n" // test k_itr
     "je             .LOOP_K_ITR_DONE%=              \n"
 
     "movq           %%rsi,              %%rdx       \n" // restore k_itr
-    "movq           %%rax,              %%r14       \n" // restore src
-
-    "leaq           (%%rcx, %%rcx, 2),  %%r10       \n" // 3*rcx
-    "leaq           (%%rcx, %%rcx, 4),  %%r11       \n" // 5*rcx
 
     ".LOOP_K_ITR%=:                                 \n"
     "prefetchnta    64(%%r14)                       \n"
@@ -482,22 +485,27 @@ static void sgemm_pack_n_a_n_mr16(int mc, int nc, int kc,
         ,"m"(alpha_addr) // 7
 #endif
     : // clobber
-        "rax","rbx","rcx","rdx","rsi","rdi",
+        "rax","rbx","rcx","rdx","rsi","rdi","memory",
         "r8","r9","r10","r11","r12","r13","r14","r15",
         "xmm0","xmm1","xmm2","xmm3","xmm4","xmm5","xmm6","xmm7","xmm8","xmm14",
         "ymm0","ymm1","ymm2","ymm3","ymm4","ymm5","ymm6",
         "ymm7","ymm8","ymm9","ymm10","ymm11","ymm12","ymm13",
         "ymm14","ymm15"
     );
+    if(mc%6)
+        sgemm_pack_n_a_n_generic(mc%6, nc, kc, alpha, src + m_itr*6*ld, ld, dest + m_itr*6*kc, ctx);
+}
+static sgemm_pack_func_t sgemm_pack_n_a_n_select(int ld, const gemm_context_t * ctx){
+    // asm packer use ymm, sse4.2 tier host take the generic one
+    if(ctx->mr == 6 && sgemm_isa_supported(SGEMM_ISA_AVX))
+        return sgemm_pack_n_a_n_mr16;
+    return sgemm_pack_n_a_n_generic;
 }
 static void sgemm_pack_n_a_n(int mc, int nc, int kc,
     float alpha, const float * src,
     int ld, float * dest, const gemm_context_t * ctx)
 {
-    if(ctx->mr == 6){
-        return sgemm_pack_n_a_n_mr16(mc, nc, kc, alpha, src, ld, dest, ctx);
-    }
-    return sgemm_pack_n_a_n_generic(mc, nc, kc, alpha, src, ld, dest, ctx);
+    sgemm_pack_n_a_n_select(ld, ctx)(mc, nc, kc, alpha, src, ld, dest, ctx);
 }
 static void sgemm_pack_n_a_t(int mc, int nc, int kc,
     float alpha, const float * src,
@@ -621,21 +629,19 @@ static void sgemm_pack_n_b_n_nr16(int mc, int nc, int kc,
     "movq               %7,             %%r10       \n" // alpha_addr
     "vbroadcastss       (%%r10),        %%ymm15     \n" // alpha
 #endif
+    "shlq               $2,             %%rcx       \n" // n_rem also use ld in byte
     // n_itr
     "testq              %%r8,           %%r8        \n"
     "je                 .B16_LOOP_N_ITR_DONE%=      \n"
 
-    "shlq               $2,             %%rcx       \n"
-
     ".B16_LOOP_N_ITR%=:                             \n"
+    "movq               %%rax,          %%r14       \n" // restore src, also used by k_rem
+    "leaq               (%%rcx, %%rcx, 2),  %%r11   \n" // 3x ld
 
     "testq              %%rsi,          %%rsi       \n"
     "je                 .B16_LOOP_K_ITR_DONE%=      \n"
 
-    "leaq               (%%rcx, %%rcx, 2),  %%r11   \n" // 3x ld
-
     "movq               %%rsi,          %%rdx       \n" // restore k_itr
-    "movq               %%rax,          %%r14       \n" // restore src
     //"movq               %%rbx,          %%r15       \n" // restore dest
     ".B16_LOOP_K_ITR%=:                             \n"
     "vmovups            (%%r14),            %%ymm0  \n"
@@ -741,14 +747,13 @@ static void sgemm_pack_n_b_n_nr16(int mc, int nc, int kc,
     "leaq               (%%rcx, %%rcx, 2),  %%r11   \n" // 3x ld
     
     ".B16_LOOP_N_REM%=:                             \n"
+    "movq               %%rax,          %%r14       \n" // restore src, also used by k_rem
+    "movq               %%rbx,          %%r15       \n" // restore dest
 
     "testq              %%rsi,          %%rsi       \n"
     "je           .B16_LOOP_K_ITR_IN_N_REM_DONE%=   \n"
     "movq               %%rsi,          %%rdx       \n" // k_itr
 
-    "movq               %%rax,          %%r14       \n" // restore src
-    "movq               %%rbx,          %%r15       \n" // restore dest
-
     ".B16_LOOP_K_ITR_IN_N_REM%=:                    \n"
     "vmovss             (%%r14),            %%xmm0  \n"
     "vmovss             (%%r14,%%rcx),      %%xmm1  \n"
@@ -827,7 +832,7 @@ static void sgemm_pack_n_b_n_nr16(int mc, int nc, int kc,
         , "m"(alpha_addr) // 7
 #endif
     : // clobber list
-        "rax","rbx","rcx","rdx","rsi","rdi",
+        "rax","rbx","rcx","rdx","rsi","rdi","memory",
         "r8","r9","r10","r11","r12","r13","r14","r15",
         "xmm0","xmm1","xmm2","xmm3","xmm4","xmm5", "xmm6", "xmm7",
         "ymm0","ymm1","ymm2","ymm3","ymm4","ymm5","ymm6",
@@ -835,14 +840,61 @@ static void sgemm_pack_n_b_n_nr16(int mc, int nc, int kc,
         "ymm14","ymm15"
     );
 }
-static void sgemm_pack_n_b_n(int mc, int nc, int kc,
+/*
+* ld that is a multiple of 2K byte (512/1024/2048/4096 float...) put every row (or
+* every other row) in the same L1 set, and the loads 4K alias with the stores into
+* dest just issued. the B packer walk kc rows down one nr panel, one line per row,
+* each row in a new page so the L2 streamer never lock on, and packing drop to half.
+* A packer read only 6 rows per step, within L1 ways, it keep the plain order
+*/
+#define PACK_LD_ALIAS_BYTES     2048
+static inline bool sgemm_pack_ld_alias(int ld){
+    return ld > 0 && (ld*sizeof(float)) % PACK_LD_ALIAS_BYTES == 0;
+}
+
+/*
+* B with alias ld: go 8 rows at a time across all nr panels instead of kc rows down
+* one panel. the 8 rows are 8 sequential streams that stay in their page, so the
+* L2 streamer can follow them, and only 8 lines sit in the aliased L1 set at once.
+* tail panel (nr_size<16) go to the generic packer
+*/
+#define PACK_B_ROW_GROUP        8
+__attribute__((target("avx")))
+static void sgemm_pack_n_b_n_nr16_rowgrp(int mc, int nc, int kc,
     float alpha, const float * src,
     int ld, float * dest, const gemm_context_t * ctx)
 {
-    if(ctx->nr == 16){
-        return sgemm_pack_n_b_n_nr16(mc,nc,kc,alpha,src,ld,dest,ctx);
+    assert(ctx->nr==16 && "mx16 kernel pack B");
+    int n_full = nc - nc%16;
+    for(int k=0; k<kc; k+=PACK_B_ROW_GROUP){
+        int kg = MIN(kc-k, PACK_B_ROW_GROUP);
+        for(int n=0; n<n_full; n+=16){
+            const float * ss = src + (size_t)k*ld + n;
+            float * dd = dest + (size_t)n*kc + k*16;
+            for(int g=0; g<kg; g++){
+                _mm256_storeu_ps(dd,   _mm256_loadu_ps(ss));
+                _mm256_storeu_ps(dd+8, _mm256_loadu_ps(ss+8));
+                ss += ld;
+                dd += 16;
+            }
+        }
     }
-    return sgemm_pack_n_b_n_generic(mc,nc,kc,alpha,src,ld,dest,ctx);
+    if(nc%16)
+        sgemm_pack_n_b_n_generic(mc, nc%16, kc, alpha, src + n_full, ld, dest + (size_t)n_full*kc, ctx);
+}
+static sgemm_pack_func_t sgemm_pack_n_b_n_select(int ld, const gemm_context_t * ctx){
+    if(ctx->nr == 16 && sgemm_isa_supported(SGEMM_ISA_AVX)){
+        if(sgemm_pack_ld_alias(ld))
+            return sgemm_pack_n_b_n_nr16_rowgrp;
+        return sgemm_pack_n_b_n_nr16;
+    }
+    return sgemm_pack_n_b_n_generic;
+}
+static void sgemm_pack_n_b_n(int mc, int nc, int kc,
+    float alpha, const float * src,
+    int ld, float * dest, const gemm_context_t * ctx)
+{
+    sgemm_pack_n_b_n_select(ld, ctx)(mc,nc,kc,alpha,src,ld,dest,ctx);
 }
 static void sgemm_pack_n_b_t(int mc, int nc, int kc,
     float alpha, const float * src,
@@ -867,6 +919,222 @@ static void sgemm_pack_t_b_t(int mc, int nc, int kc,
 }
 
 
+/*
+* sgemm_pack_sum(), same packed layout as sgemm_pack_n_a_n/sgemm_pack_n_b_n but the source is
+* sum of coef*src terms, read and summed straight into dest (no summed block in between).
+* A: rows of 8 k summed in registers then spread mr_size apart in the panel. B: a packed row
+* of nr_size is the sum of the term rows, contiguous on both sides
+*/
+static void sgemm_pack_sum_a(int mc, int kc, float alpha,
+    const sgemm_pack_term_t * terms, int num_terms, int ld, float * dest, const gemm_context_t * ctx)
+{
+    int mr = ctx->mr;
+    float v[8];
+    for(int m=0; m<mc; m+=mr){
+        int mr_size = MIN(mc-m, mr);
+        float * d_ptr = dest + (size_t)(m/mr)*mr*kc;
+        for(int i=0; i<mr_size; i++){
+            size_t row = (size_t)(m+i)*ld;
+            float * dd = d_ptr + i;
+            for(int k=0; k<kc; k+=8){
+                int k_size = MIN(kc-k, 8);
+                const float * ss = terms[0].src + row + k;
+                float c = alpha * terms[0].coef;
+                for(int j=0; j<k_size; j++)
+                    v[j] = c*ss[j];
+                for(int t=1; t<num_terms; t++){
+                    ss = terms[t].src + row + k;
+                    c = alpha * terms[t].coef;
+                    for(int j=0; j<k_size; j++)
+                        v[j] += c*ss[j];
+                }
+                for(int j=0; j<k_size; j++){
+                    *dd = v[j];  dd += mr_size;
+                }
+            }
+        }
+    }
+}
+
+static void sgemm_pack_sum_b(int nc, int kc,
+    const sgemm_pack_term_t * terms, int num_terms, int ld, float * dest, const gemm_context_t * ctx)
+{
+    int nr = ctx->nr;
+    for(int n=0; n<nc; n+=nr){
+        int nr_size = MIN(nc-n, nr);
+        float * dd = dest + (size_t)(n/nr)*nr*kc;
+        for(int k=0; k<kc; k++){
+            size_t off = (size_t)k*ld + n;
+            const float * ss = terms[0].src + off;
+            float c = terms[0].coef;
+            for(int j=0; j<nr_size; j++)
+                dd[j] = c*ss[j];
+            for(int t=1; t<num_terms; t++){
+                ss = terms[t].src + off;
+                c = terms[t].coef;
+                for(int j=0; j<nr_size; j++)
+                    dd[j] += c*ss[j];
+            }
+            dd += nr_size;
+        }
+    }
+}
+
+// 8 k of the mr rows of one A panel: row sums in ymm, 8x8 transposed (row >= MR_ zero), column j
+// is the MR_ floats of k+j, stored 8 wide at j*MR_ so the next one overwrite the extra, last masked
+template<int MR_>
+__attribute__((target("avx")))
+static inline void sgemm_pack_sum_a_k8(const sgemm_pack_term_t * terms, int num_terms,
+    const float * alpha_coef, size_t off, int ld, float * dd)
+{
+    __m256 r[8];
+    for(int i=0; i<8; i++){
+        if(i >= MR_){
+            r[i] = _mm256_setzero_ps();
+            continue;
+        }
+        size_t o = off + (size_t)i*ld;
+        r[i] = _mm256_mul_ps(_mm256_set1_ps(alpha_coef[0]), _mm256_loadu_ps(terms[0].src + o));
+        for(int t=1; t<num_terms; t++)
+            r[i] = _mm256_add_ps(r[i], _mm256_mul_ps(_mm256_set1_ps(alpha_coef[t]),
+                    _mm256_loadu_ps(terms[t].src + o)));
+    }
+    __m256 t0 = _mm256_unpacklo_ps(r[0], r[1]), t1 = _mm256_unpackhi_ps(r[0], r[1]);
+    __m256 t2 = _mm256_unpacklo_ps(r[2], r[3]), t3 = _mm256_unpackhi_ps(r[2], r[3]);
+    __m256 t4 = _mm256_unpacklo_ps(r[4], r[5]), t5 = _mm256_unpackhi_ps(r[4], r[5]);
+    __m256 t6 = _mm256_unpacklo_ps(r[6], r[7]), t7 = _mm256_unpackhi_ps(r[6], r[7]);
+    __m256 u0 = _mm256_shuffle_ps(t0, t2, 0x44), u1 = _mm256_shuffle_ps(t0, t2, 0xee);
+    __m256 u2 = _mm256_shuffle_ps(t1, t3, 0x44), u3 = _mm256_shuffle_ps(t1, t3, 0xee);
+    __m256 u4 = _mm256_shuffle_ps(t4, t6, 0x44), u5 = _mm256_shuffle_ps(t4, t6, 0xee);
+    __m256 u6 = _mm256_shuffle_ps(t5, t7, 0x44), u7 = _mm256_shuffle_ps(t5, t7, 0xee);
+    _mm256_storeu_ps(dd + 0*MR_, _mm256_permute2f128_ps(u0, u4, 0x20));
+    _mm256_storeu_ps(dd + 1*MR_, _mm256_permute2f128_ps(u1, u5, 0x20));
+    _mm256_storeu_ps(dd + 2*MR_, _mm256_permute2f128_ps(u2, u6, 0x20));
+    _mm256_storeu_ps(dd + 3*MR_, _mm256_permute2f128_ps(u3, u7, 0x20));
+    _mm256_storeu_ps(dd + 4*MR_, _mm256_permute2f128_ps(u0, u4, 0x31));
+    _mm256_storeu_ps(dd + 5*MR_, _mm256_permute2f128_ps(u1, u5, 0x31));
+    _mm256_storeu_ps(dd + 6*MR_, _mm256_permute2f128_ps(u2, u6, 0x31));
+    __m256i mask = _mm256_setr_epi32(0 < MR_ ? -1 : 0, 1 < MR_ ? -1 : 0, 2 < MR_ ? -1 : 0,
+        3 < MR_ ? -1 : 0, 4 < MR_ ? -1 : 0, 5 < MR_ ? -1 : 0, 6 < MR_ ? -1 : 0, 7 < MR_ ? -1 : 0);
+    _mm256_maskstore_ps(dd + 7*MR_, mask, _mm256_permute2f128_ps(u3, u7, 0x31));
+}
+
+// avx, full panels of mr 4/6/8, 8 k at a time by sgemm_pack_sum_a_k8. k tail and the last
+// partial panel by sgemm_pack_sum_a
+template<int MR_>
+__attribute__((target("avx")))
+static void sgemm_pack_sum_a_avx(int mc, int kc, float alpha,
+    const sgemm_pack_term_t * terms, int num_terms, int ld, float * dest, const gemm_context_t * ctx)
+{
+    int m_full = mc - mc%MR_;
+    int k_full = kc - kc%8;
+    float alpha_coef[32];
+    for(int t=0; t<num_terms; t++)
+        alpha_coef[t] = alpha * terms[t].coef;
+    for(int m=0; m<m_full; m+=MR_){
+        float * d_ptr = dest + (size_t)(m/MR_)*MR_*kc;
+        for(int k=0; k<k_full; k+=8)
+            sgemm_pack_sum_a_k8<MR_>(terms, num_terms, alpha_coef, (size_t)m*ld + k, ld, d_ptr + (size_t)k*MR_);
+        if(k_full < kc){
+            // panel stride stay MR_*kc, only k_full..kc of this panel
+            for(int i=0; i<MR_; i++){
+                for(int k=k_full; k<kc; k++){
+                    float v = 0;
+                    for(int t=0; t<num_terms; t++)
+                        v += alpha_coef[t] * terms[t].src[(size_t)(m+i)*ld + k];
+                    d_ptr[(size_t)k*MR_ + i] = v;
+                }
+            }
+        }
+    }
+    if(m_full < mc){
+        sgemm_pack_term_t rest[32];
+        for(int t=0; t<num_terms; t++)
+            rest[t] = {terms[t].src + (size_t)m_full*ld, terms[t].coef};
+        sgemm_pack_sum_a(mc-m_full, kc, alpha, rest, num_terms, ld, dest + (size_t)(m_full/MR_)*MR_*kc, ctx);
+    }
+}
+
+// avx, full 16 wide panel, a packed row is 2 ymm summed over the terms
+__attribute__((target("avx")))
+static void sgemm_pack_sum_b_nr16(int nc, int kc,
+    const sgemm_pack_term_t * terms, int num_terms, int ld, float * dest, const gemm_context_t * ctx)
+{
+    int n_full = nc - nc%16;
+    for(int n=0; n<n_full; n+=16){
+        float * dd = dest + (size_t)n*kc;
+        for(int k=0; k<kc; k++){
+            size_t off = (size_t)k*ld + n;
+            __m256 c = _mm256_set1_ps(terms[0].coef);
+            __m256 v0 = _mm256_mul_ps(c, _mm256_loadu_ps(terms[0].src + off));
+            __m256 v1 = _mm256_mul_ps(c, _mm256_loadu_ps(terms[0].src + off + 8));
+            for(int t=1; t<num_terms; t++){
+                c = _mm256_set1_ps(terms[t].coef);
+                v0 = _mm256_add_ps(v0, _mm256_mul_ps(c, _mm256_loadu_ps(terms[t].src + off)));
+                v1 = _mm256_add_ps(v1, _mm256_mul_ps(c, _mm256_loadu_ps(terms[t].src + off + 8)));
+            }
+            _mm256_storeu_ps(dd, v0);
+            _mm256_storeu_ps(dd+8, v1);
+            dd += 16;
+        }
+    }
+    if(n_full < nc){
+        sgemm_pack_term_t rest[32];
+        for(int t=0; t<num_terms; t++)
+            rest[t] = {terms[t].src + n_full, terms[t].coef};
+        sgemm_pack_sum_b(nc-n_full, kc, rest, num_terms, ld, dest + (size_t)n_full*kc, ctx);
+    }
+}
+
+void sgemm_pack_sum(identifier_t ident, int mc, int nc, int kc, float alpha,
+    const sgemm_pack_term_t * terms, int num_terms, int ld, float * dest, const gemm_context_t * ctx)
+{
+    bool avx = sgemm_isa_supported(SGEMM_ISA_AVX);
+    if(ident == IDENT_A_MATRIX){
+        if(avx && ctx->mr == 6)
+            sgemm_pack_sum_a_avx<6>(mc, kc, alpha, terms, num_terms, ld, dest, ctx);
+        else if(avx && ctx->mr == 4)
+            sgemm_pack_sum_a_avx<4>(mc, kc, alpha, terms, num_terms, ld, dest, ctx);
+        else if(avx && ctx->mr == 8)
+            sgemm_pack_sum_a_avx<8>(mc, kc, alpha, terms, num_terms, ld, dest, ctx);
+        else
+            sgemm_pack_sum_a(mc, kc, alpha, terms, num_terms, ld, dest, ctx);
+    }else{
+        if(avx && ctx->nr == 16)
+            sgemm_pack_sum_b_nr16(nc, kc, terms, num_terms, ld, dest, ctx);
+        else
+            sgemm_pack_sum_b(nc, kc, terms, num_terms, ld, dest, ctx);
+    }
+}
+
+static const sgemm_pack_desc_t sgemm_pack_list[] = {
+    {"pack_n_a_n_generic",  IDENT_A_MATRIX, 0,  SGEMM_ISA_SSE42, sgemm_pack_n_a_n_generic},
+    {"pack_n_a_n_mr16",     IDENT_A_MATRIX, 6,  SGEMM_ISA_AVX,   sgemm_pack_n_a_n_mr16},
+    {"pack_n_b_n_generic",  IDENT_B_MATRIX, 0,  SGEMM_ISA_SSE42, sgemm_pack_n_b_n_generic},
+    {"pack_n_b_n_nr16",     IDENT_B_MATRIX, 16, SGEMM_ISA_AVX,   sgemm_pack_n_b_n_nr16},
+    // picked by sgemm_pack() instead of the above when ld is 2K byte multiple
+    {"pack_n_b_n_nr16_rowgrp", IDENT_B_MATRIX, 16, SGEMM_ISA_AVX, sgemm_pack_n_b_n_nr16_rowgrp},
+};
+
+int sgemm_pack_count(){
+    return sizeof(sgemm_pack_list)/sizeof(sgemm_pack_list[0]);
+}
+const sgemm_pack_desc_t * sgemm_pack_get(int idx){
+    if(idx < 0 || idx >= sgemm_pack_count())
+        return nullptr;
+    return &sgemm_pack_list[idx];
+}
+
+sgemm_pack_func_t sgemm_pack_select(layout_t layout, trans_t trans, identifier_t ident,
+    int ld, const gemm_context_t * ctx)
+{
+    if(layout != LAYOUT_ROW_MAJOR || !(trans == TRANS_NO_TRANS || trans == TRANS_CONJ_NO_TRANS))
+        return nullptr;
+    if(ident == IDENT_A_MATRIX)
+        return sgemm_pack_n_a_n_select(ld, ctx);
+    return sgemm_pack_n_b_n_select(ld, ctx);
+}
+
 /***************************************************************************
  * 
  * 
@@ -18,4 +18,43 @@ void sgemm_pack(layout_t layout, trans_t trans, identifier_t ident,
     float alpha, const float * src,
     int ld, float * dest, const gemm_context_t * ctx);
 
+typedef void (*sgemm_pack_func_t)(int mc, int nc, int kc,
+    float alpha, const float * src,
+    int ld, float * dest, const gemm_context_t * ctx);
+
+/*
+* row major no trans pack of a sum operand, dest = sum of coef*src over the terms (all with the
+* same ld), summed while packing, layout as sgemm_pack(). alpha scale A only, as sgemm_pack().
+* strassen use it for the (X + dX*Y) operands
+*/
+struct sgemm_pack_term_t {
+    const float *   src;
+    float           coef;
+};
+void sgemm_pack_sum(identifier_t ident, int mc, int nc, int kc, float alpha,
+    const sgemm_pack_term_t * terms, int num_terms, int ld, float * dest, const gemm_context_t * ctx);
+
+/*
+* implemented packers (row major, no trans), sgemm_pack() dispatch among them by
+* ctx->mr/nr. listed so they can be benchmarked one by one.
+* A: panel of mr_size rows, dest[k*mr_size + i] = alpha * src[i*ld + k], panel stride mr*kc
+* B: panel of nr_size cols, dest[k*nr_size + j] = src[k*ld + j], panel stride nr*kc
+* last panel may be narrower (mr_size<mr, nr_size<nr)
+*/
+struct sgemm_pack_desc_t {
+    const char *        name;
+    identifier_t        ident;
+    int                 tile;   // mr for A, nr for B this packer is written for, 0 if any
+    sgemm_isa_t         isa;    // sse4.2 for plain c
+    sgemm_pack_func_t   func;
+};
+
+int sgemm_pack_count();
+const sgemm_pack_desc_t * sgemm_pack_get(int idx);
+
+// the packer sgemm_pack() would call for this ld and ctx tile, resolved once by a plan.
+// nullptr if layout/trans has no packer yet (only row major no trans)
+sgemm_pack_func_t sgemm_pack_select(layout_t layout, trans_t trans, identifier_t ident,
+    int ld, const gemm_context_t * ctx);
+
 #endif
\ No newline at end of file
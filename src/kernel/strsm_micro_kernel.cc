@@ -0,0 +1,65 @@
+#include "strsm_micro_kernel.h"
+#include <immintrin.h>
+
+#define STRSM_TARGET_AVX2   __attribute__((target("avx2,fma")))
+// row of B kept in ymm, nr up to 8*STRSM_AVX2_MAX_VEC
+#define STRSM_AVX2_MAX_VEC  4
+
+void strsm_micro_kernel_ln(int mr, int nr, const float * L, float * B){
+    for(int i=0; i<mr; i++){
+        float * bi = B + i*nr;
+        const float * li = L + i*mr;
+        for(int k=0; k<i; k++){
+            float l = li[k];
+            const float * bk = B + k*nr;
+            for(int j=0; j<nr; j++)
+                bi[j] -= l*bk[j];
+        }
+        float d = li[i];
+        for(int j=0; j<nr; j++)
+            bi[j] *= d;
+    }
+}
+
+/*
+* row i is solved once every row above is final, so the rows stay in register as they are
+* solved: b[i] = (b[i] - sum l[i][k]*b[k]) * inv_d[i]. up to 4 ymm per row, 32 column at a time
+*/
+STRSM_TARGET_AVX2
+static void strsm_avx2_impl(int mr, int nr, const float * L, float * B){
+    int nv = nr / 8;
+    for(int v0=0; v0<nv; v0 += STRSM_AVX2_MAX_VEC){
+        int vn = (nv - v0 < STRSM_AVX2_MAX_VEC) ? nv - v0 : STRSM_AVX2_MAX_VEC;
+        __m256 rows[16][STRSM_AVX2_MAX_VEC];
+        for(int i=0; i<mr; i++){
+            const float * li = L + i*mr;
+            __m256 acc[STRSM_AVX2_MAX_VEC];
+            for(int v=0; v<vn; v++)
+                acc[v] = _mm256_loadu_ps(B + i*nr + (v0+v)*8);
+            for(int k=0; k<i; k++){
+                __m256 l = _mm256_broadcast_ss(li + k);
+                for(int v=0; v<vn; v++)
+                    acc[v] = _mm256_fnmadd_ps(l, rows[k][v], acc[v]);
+            }
+            __m256 d = _mm256_broadcast_ss(li + i);
+            for(int v=0; v<vn; v++){
+                rows[i][v] = _mm256_mul_ps(acc[v], d);
+                _mm256_storeu_ps(B + i*nr + (v0+v)*8, rows[i][v]);
+            }
+        }
+    }
+}
+
+void strsm_micro_kernel_ln_avx2(int mr, int nr, const float * L, float * B){
+    if(mr > 16 || nr % 8){
+        strsm_micro_kernel_ln(mr, nr, L, B);
+        return ;
+    }
+    strsm_avx2_impl(mr, nr, L, B);
+}
+
+strsm_micro_kernel_t strsm_micro_kernel_select(sgemm_isa_t isa, int nr){
+    if((isa == SGEMM_ISA_AVX2 || isa == SGEMM_ISA_AVX512) && nr % 8 == 0)
+        return strsm_micro_kernel_ln_avx2;
+    return strsm_micro_kernel_ln;
+}
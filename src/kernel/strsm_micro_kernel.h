@@ -0,0 +1,22 @@
+#ifndef __STRSM_MICRO_KERNEL_H
+#define __STRSM_MICRO_KERNEL_H
+
+#include "sgemm_micro_kernel.h"
+
+/*
+* diagonal block solve of trsm, one mr x nr tile in place:
+*   B := inv(L) * B
+* L is mr x mr lower triangle, row i at L + i*mr, diagonal stored inverted (1 for unit,
+* 0 for a padded row, so padding stay 0). B tile row major, ld nr. the part of the rows
+* above the tile was already subtracted by the gemm micro kernel, see gemm_level3.cc
+*/
+typedef void (*strsm_micro_kernel_t)(int mr, int nr, const float * L, float * B);
+
+void strsm_micro_kernel_ln(int mr, int nr, const float * L, float * B);
+// nr multiple of 8, host need avx2/fma
+void strsm_micro_kernel_ln_avx2(int mr, int nr, const float * L, float * B);
+
+// best one for the isa of the gemm kernel and its nr
+strsm_micro_kernel_t strsm_micro_kernel_select(sgemm_isa_t isa, int nr);
+
+#endif
@@ -0,0 +1,240 @@
+#include "topology.h"
+#include "util.h"
+
+#include <stdlib.h>
+#include <dirent.h>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+#define SYSFS_NODE_DIR  "/sys/devices/system/node"
+#define SYSFS_CPU_ONLINE "/sys/devices/system/cpu/online"
+#define SYSFS_CPU_DIR   "/sys/devices/system/cpu"
+
+static bool read_sysfs_line(const std::string & file, std::string & line){
+    std::ifstream infile(file);
+    if(!infile.good())
+        return false;
+    if(!std::getline(infile, line))
+        return false;
+    return true;
+}
+
+void parse_cpu_list(const std::string & str, std::vector<int> & cpu_list){
+    std::stringstream ss(str);
+    std::string item;
+    while(std::getline(ss, item, ',')){
+        if(item.empty() || item == "\n")
+            continue;
+        size_t dash = item.find('-');
+        if(dash == std::string::npos){
+            cpu_list.push_back(atoi(item.c_str()));
+        }else{
+            int first = atoi(item.substr(0, dash).c_str());
+            int last  = atoi(item.substr(dash+1).c_str());
+            for(int c=first; c<=last; c++)
+                cpu_list.push_back(c);
+        }
+    }
+}
+
+std::string cpu_list_str(const std::vector<int> & cpu_list){
+    std::string str;
+    for(size_t i=0;i<cpu_list.size();i++){
+        str += std::to_string(cpu_list[i]);
+        if(i != (cpu_list.size()-1))
+            str += ",";
+    }
+    return str;
+}
+
+static void online_cpu_list(std::vector<int> & cpu_list){
+    std::string line;
+    if(read_sysfs_line(SYSFS_CPU_ONLINE, line))
+        parse_cpu_list(line, cpu_list);
+    if(cpu_list.empty())
+        get_current_affinity(cpu_list);
+}
+
+static void fake_numa_nodes(int num_nodes, std::vector<numa_node_t> & nodes){
+    std::vector<int> cpus;
+    online_cpu_list(cpus);
+    size_t per_node = (cpus.size() + num_nodes - 1) / num_nodes;
+    for(int n=0;n<num_nodes;n++){
+        numa_node_t node;
+        node.id = n;
+        for(size_t i=n*per_node; i<MIN((n+1)*per_node, cpus.size()); i++)
+            node.cpu_list.push_back(cpus[i]);
+        // less cpu than fake node, share cpu with previous node
+        if(node.cpu_list.empty())
+            node.cpu_list.push_back(cpus[n % cpus.size()]);
+        nodes.push_back(node);
+    }
+}
+
+void numa_discover_nodes(std::vector<numa_node_t> & nodes){
+    nodes.clear();
+    const char * fake = getenv("GEMM_FAKE_NUMA");
+    if(fake && atoi(fake) > 0){
+        fake_numa_nodes(atoi(fake), nodes);
+        return ;
+    }
+
+    DIR * dir = opendir(SYSFS_NODE_DIR);
+    if(dir){
+        struct dirent * ent;
+        while((ent = readdir(dir)) != NULL){
+            std::string name = ent->d_name;
+            if(name.compare(0, 4, "node") != 0 || name.size() <= 4)
+                continue;
+            if(name.find_first_not_of("0123456789", 4) != std::string::npos)
+                continue;
+            numa_node_t node;
+            node.id = atoi(name.c_str()+4);
+            std::string line;
+            if(!read_sysfs_line(std::string(SYSFS_NODE_DIR) + "/" + name + "/cpulist", line))
+                continue;
+            parse_cpu_list(line, node.cpu_list);
+            if(node.cpu_list.empty())   // memory only node
+                continue;
+            nodes.push_back(node);
+        }
+        closedir(dir);
+    }
+
+    if(nodes.empty()){
+        // no numa in sysfs (not NUMA kernel, or container), treat as 1 node
+        numa_node_t node;
+        node.id = 0;
+        online_cpu_list(node.cpu_list);
+        nodes.push_back(node);
+    }
+    std::sort(nodes.begin(), nodes.end(),
+        [](const numa_node_t & a, const numa_node_t & b){ return a.id < b.id; });
+}
+
+static bool read_sysfs_int(const std::string & file, int & value){
+    std::string line;
+    if(!read_sysfs_line(file, line) || line.empty())
+        return false;
+    value = atoi(line.c_str());
+    return true;
+}
+
+// id of the cache domain of given level (unified or data), first cpu that share it
+static int cpu_cache_id(int cpu, int level){
+    std::string base = std::string(SYSFS_CPU_DIR) + "/cpu" + std::to_string(cpu) + "/cache/index";
+    for(int idx=0; idx<8; idx++){
+        int lv;
+        std::string type, shared;
+        std::string dir = base + std::to_string(idx);
+        if(!read_sysfs_int(dir + "/level", lv))
+            break;
+        if(lv != level || !read_sysfs_line(dir + "/type", type) || type == "Instruction")
+            continue;
+        std::vector<int> cpus;
+        if(read_sysfs_line(dir + "/shared_cpu_list", shared))
+            parse_cpu_list(shared, cpus);
+        return cpus.empty() ? cpu : *std::min_element(cpus.begin(), cpus.end());
+    }
+    return cpu;
+}
+
+void cpu_discover_topology(int cpu, cpu_topo_t & topo){
+    std::string dir = std::string(SYSFS_CPU_DIR) + "/cpu" + std::to_string(cpu) + "/topology";
+    int core_id = cpu;
+    int package = 0;
+    read_sysfs_int(dir + "/core_id", core_id);
+    read_sysfs_int(dir + "/physical_package_id", package);
+    topo.cpu = cpu;
+    topo.package = package;
+    topo.core = package*65536 + core_id;
+    topo.smt_idx = 0;
+    topo.smt_count = 1;
+
+    std::string line;
+    std::vector<int> siblings;
+    if(read_sysfs_line(dir + "/thread_siblings_list", line))
+        parse_cpu_list(line, siblings);
+    if(!siblings.empty()){
+        topo.smt_count = siblings.size();
+        for(size_t i=0;i<siblings.size();i++)
+            if(siblings[i] == cpu)
+                topo.smt_idx = i;
+    }
+    topo.l2_id = cpu_cache_id(cpu, 2);
+    topo.l3_id = cpu_cache_id(cpu, 3);
+}
+
+int smt_sibling_cpu(int cpu){
+    std::string line;
+    std::vector<int> siblings;
+    if(!read_sysfs_line(std::string(SYSFS_CPU_DIR) + "/cpu" + std::to_string(cpu) +
+            "/topology/thread_siblings_list", line))
+        return -1;
+    parse_cpu_list(line, siblings);
+    for(int c : siblings)
+        if(c != cpu)
+            return c;
+    return -1;
+}
+
+void numa_assign_workers(const std::vector<numa_node_t> & nodes, size_t threads,
+    std::vector<numa_worker_t> & workers, place_t place, const std::vector<int> & allowed)
+{
+    workers.clear();
+    // nodes with no allowed cpu are dropped, node_idx still index the full vector
+    std::vector<size_t> node_ids;
+    std::vector<std::vector<cpu_topo_t>> node_cpus;
+    for(size_t n=0;n<nodes.size();n++){
+        std::vector<cpu_topo_t> cpus;
+        for(int c : nodes[n].cpu_list){
+            if(!allowed.empty() && std::find(allowed.begin(), allowed.end(), c) == allowed.end())
+                continue;
+            cpu_topo_t topo;
+            cpu_discover_topology(c, topo);
+            cpus.push_back(topo);
+        }
+        if(cpus.empty())
+            continue;
+        if(place == PLACE_CORE)
+            std::stable_sort(cpus.begin(), cpus.end(), [](const cpu_topo_t & a, const cpu_topo_t & b){
+                return a.smt_idx != b.smt_idx ? a.smt_idx < b.smt_idx : a.core < b.core; });
+        else if(place == PLACE_SMT)
+            std::stable_sort(cpus.begin(), cpus.end(), [](const cpu_topo_t & a, const cpu_topo_t & b){
+                return a.core != b.core ? a.core < b.core : a.smt_idx < b.smt_idx; });
+        node_ids.push_back(n);
+        node_cpus.push_back(cpus);
+    }
+    if(node_ids.empty()){
+        if(!allowed.empty())    // no allowed cpu in any node, ignore the list
+            numa_assign_workers(nodes, threads, workers, place);
+        return ;
+    }
+
+    size_t num_nodes = MIN(node_ids.size(), threads);
+    for(size_t n=0;n<num_nodes;n++){
+        // first nodes take the remainder
+        size_t node_threads = threads/num_nodes + ((n < threads%num_nodes) ? 1:0);
+        const std::vector<cpu_topo_t> & cpus = node_cpus[n];
+        for(size_t t=0;t<node_threads;t++){
+            numa_worker_t w;
+            w.node_idx = node_ids[n];
+            w.cpu = cpus[t % cpus.size()].cpu;
+            w.core = cpus[t % cpus.size()].core;
+            workers.push_back(w);
+        }
+    }
+}
+
+size_t workers_per_core(const std::vector<numa_worker_t> & workers){
+    size_t most = workers.empty() ? 0 : 1;
+    for(size_t i=0;i<workers.size();i++){
+        size_t same = 0;
+        for(size_t j=0;j<workers.size();j++)
+            if(workers[j].core == workers[i].core)
+                same++;
+        most = MAX(most, same);
+    }
+    return most;
+}
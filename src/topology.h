@@ -0,0 +1,87 @@
+#ifndef __TOPOLOGY_H
+#define __TOPOLOGY_H
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+/*
+* numa topology discovered from sysfs:
+*   /sys/devices/system/node/node<N>/cpulist
+*
+* if the kernel is booted with numa=fake=<N>, sysfs already show fake nodes.
+* also env GEMM_FAKE_NUMA=<N> split the online cpus into N fake nodes, so the
+* multi-node code path can be tested on a single socket machine.
+*
+* per cpu topology from /sys/devices/system/cpu/cpu<N>/topology and cache/index<N>:
+* physical core, smt index inside the core, and the id of its L2 and L3 domain (the
+* first cpu of the cache shared_cpu_list), so hyperthread does not need to be off.
+*/
+struct cpu_topo_t {
+    int     cpu;
+    int     package;
+    int     core;       // package*65536+core_id, unique over packages
+    int     smt_idx;    // position in thread_siblings_list, 0 is the first hw thread
+    int     smt_count;  // hw threads of this core that are online
+    int     l2_id;
+    int     l3_id;
+};
+
+/*
+* worker placement inside a numa node:
+*   compact     cpus in sysfs order of the node (old behaviour)
+*   core        first hw thread of every physical core, then the second ones. one worker
+*               per core until threads > cores
+*   smt         both hw threads of a core next to each other. consecutive workers on the
+*               same core form a team that pack one A block together and share it in L2
+*/
+typedef enum {
+    PLACE_COMPACT = 0,
+    PLACE_CORE,
+    PLACE_SMT
+}place_t;
+
+static inline const char * to_place_str(place_t place){
+    if(place == PLACE_COMPACT)
+        return "compact";
+    if(place == PLACE_CORE)
+        return "core";
+    if(place == PLACE_SMT)
+        return "smt";
+    return "n/a place";
+}
+struct numa_node_t {
+    int                 id;
+    std::vector<int>    cpu_list;
+};
+
+// worker placement, one per thread
+struct numa_worker_t {
+    int     node_idx;   // index into the node vector, not the node id
+    int     cpu;
+    int     core;       // cpu_topo_t::core
+};
+
+// parse linux cpulist format, like "0-3,8,10-11"
+void parse_cpu_list(const std::string & str, std::vector<int> & cpu_list);
+std::string cpu_list_str(const std::vector<int> & cpu_list);
+
+void numa_discover_nodes(std::vector<numa_node_t> & nodes);
+
+// another hw thread on the same core as cpu, from thread_siblings_list. -1 if smt off
+int smt_sibling_cpu(int cpu);
+
+// sysfs topology of one cpu. missing file (container) leave core=cpu, no smt, cache id=cpu
+void cpu_discover_topology(int cpu, cpu_topo_t & topo);
+
+// spread threads evenly over nodes, each node fill its own cpus first, ordered by place.
+// allowed not empty restrict cpus to that list (ignored if none of it is online). if a node has less cpu than thread
+// assigned, cpu is reused round robin
+void numa_assign_workers(const std::vector<numa_node_t> & nodes, size_t threads,
+    std::vector<numa_worker_t> & workers, place_t place = PLACE_COMPACT,
+    const std::vector<int> & allowed = std::vector<int>());
+
+// most workers that share one physical core, L2 of the core is split by this many
+size_t workers_per_core(const std::vector<numa_worker_t> & workers);
+
+#endif
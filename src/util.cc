@@ -7,16 +7,33 @@
 #include <string.h>
 #include <pthread.h>
 #include <sched.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/perf_event.h>
 #include <iostream>
+#include <fstream>
+#include <string>
 #include <assert.h>
+#include <emmintrin.h>
 
+// monotonic ns clock, cold cache bench time every small call alone
 double current_sec()
 {
-    struct timeval time;
-    if (gettimeofday(&time,NULL)){
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts)){
         return 0;
     }
-    return (double)time.tv_sec + (double)time.tv_usec * .000001;
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+void cache_flush(const void * p, size_t bytes, size_t cacheline_size){
+    const char * c = (const char *)p;
+    for(size_t i=0; i<bytes; i+=cacheline_size)
+        _mm_clflush(c + i);
+    _mm_clflush(c + bytes - 1);
+    _mm_mfence();
 }
 
 
@@ -41,6 +58,70 @@ void __aligned_free(void *p)
     free(((void**)p)[-1]);
 }
 
+#define THP_ENABLED_FILE "/sys/kernel/mm/transparent_hugepage/enabled"
+static bool thp_usable(){
+    // format: "always [madvise] never", selected one in bracket
+    std::ifstream infile(THP_ENABLED_FILE);
+    std::string line;
+    if(!infile.good() || !std::getline(infile, line))
+        return false;
+    return line.find("[always]") != std::string::npos ||
+            line.find("[madvise]") != std::string::npos;
+}
+
+static void * hugetlb_map(size_t bytes){
+    void * p = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    return p == MAP_FAILED ? NULL : p;
+}
+
+huge_page_t huge_page_probe(){
+    void * p = hugetlb_map(HUGE_PAGE_SIZE);
+    if(p){
+        munmap(p, HUGE_PAGE_SIZE);
+        return HUGE_PAGE_HUGETLB;
+    }
+    if(thp_usable())
+        return HUGE_PAGE_THP;
+    return HUGE_PAGE_NONE;
+}
+
+const char * huge_page_str(huge_page_t hp){
+    if(hp == HUGE_PAGE_HUGETLB)
+        return "hugetlb";
+    if(hp == HUGE_PAGE_THP)
+        return "thp";
+    return "none";
+}
+
+void* __huge_malloc(size_t required_bytes){
+    size_t bytes = ((required_bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE) * HUGE_PAGE_SIZE;
+    void * p = hugetlb_map(bytes);
+    if(p)
+        return p;
+
+    // over map 1 huge page, then trim head/tail to get 2M alignment
+    size_t map_bytes = bytes + HUGE_PAGE_SIZE;
+    char * raw = (char*)mmap(NULL, map_bytes, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(raw == MAP_FAILED)
+        return NULL;
+    char * aligned = (char*)(((size_t)raw + HUGE_PAGE_SIZE - 1) & ~((size_t)HUGE_PAGE_SIZE - 1));
+    size_t head = aligned - raw;
+    size_t tail = map_bytes - head - bytes;
+    if(head)
+        munmap(raw, head);
+    if(tail)
+        munmap(aligned + bytes, tail);
+    madvise(aligned, bytes, MADV_HUGEPAGE);
+    return aligned;
+}
+
+void __huge_free(void *p, size_t required_bytes){
+    size_t bytes = ((required_bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE) * HUGE_PAGE_SIZE;
+    munmap(p, bytes);
+}
+
 template<typename T>
 void rand_vector(T* v, int elem){
     int i;
@@ -91,6 +172,73 @@ int get_current_cpu(){
     return sched_getcpu();
 }
 
+#define SPIN_BEFORE_YIELD 4096
+void spin_barrier_t::wait(){
+    int cur_sense = sense.load(std::memory_order_relaxed);
+    if(arrived.fetch_add(1, std::memory_order_acq_rel) == (num_threads-1)){
+        arrived.store(0, std::memory_order_relaxed);
+        sense.store(cur_sense ^ 1, std::memory_order_release);
+        return ;
+    }
+    int spin = 0;
+    while(sense.load(std::memory_order_acquire) == cur_sense){
+        if(++spin < SPIN_BEFORE_YIELD){
+            asm volatile("pause" ::: "memory");
+        }else{
+            sched_yield();  // threads may be more than cpus
+            spin = 0;
+        }
+    }
+}
+
+void spin_wait_ge(const std::atomic<int> & flag, int target){
+    int spin = 0;
+    while(flag.load(std::memory_order_acquire) < target){
+        if(++spin < SPIN_BEFORE_YIELD){
+            asm volatile("pause" ::: "memory");
+        }else{
+            sched_yield();
+            spin = 0;
+        }
+    }
+}
+
+perf_counter_t::perf_counter_t(perf_event_t event){
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    if(event == PERF_EVENT_LLC_MISS)
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    else if(event == PERF_EVENT_CYCLES)
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    else
+        attr.config = PERF_COUNT_HW_REF_CPU_CYCLES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd = syscall(__NR_perf_event_open, &attr, 0 /*this thread*/, -1 /*any cpu*/, -1, 0);
+}
+perf_counter_t::~perf_counter_t(){
+    if(fd >= 0)
+        close(fd);
+}
+void perf_counter_t::start(){
+    if(fd < 0)
+        return ;
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+}
+unsigned long long perf_counter_t::stop(){
+    if(fd < 0)
+        return 0;
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    unsigned long long count = 0;
+    if(read(fd, &count, sizeof(count)) != sizeof(count))
+        return 0;
+    return count;
+}
+
 #ifdef __x86_64
 #define __cpuid(eax,ebx,ecx,edx)    \
     asm volatile(                   \
@@ -123,6 +271,25 @@ void cpuid_vendor_str(char * vendor_str){
     vs.ecx = ecx;
     strncpy(vendor_str, (const char*)vs.str, 12);
 }
+int cpuid_support_sse42(){
+    uint32_t eax,ebx,ecx,edx;
+    eax = 1;
+    ecx = 0;
+    __cpuid(eax,ebx,ecx,edx);
+    uint32_t sse42 = ecx & (1<<20);
+    return sse42 ? 1:0;
+}
+
+// fma3, avx2 does not imply it. cpuid_support_avx() must check first
+int cpuid_support_fma(){
+    uint32_t eax,ebx,ecx,edx;
+    eax = 1;
+    ecx = 0;
+    __cpuid(eax,ebx,ecx,edx);
+    uint32_t fma = ecx & (1<<12);
+    return fma ? 1:0;
+}
+
 int cpuid_support_avx(){
 /*
 1) Detect CPUID.1:ECX.OSXSAVE[bit 27] = 1 (XGETBV enabled for application use 1 )
@@ -199,7 +366,7 @@ OS).
     ecx = 0;        // request XCR0
     asm volatile("xgetbv \n" : "=a"(eax), "=d"(edx): "c"(ecx));
     uint64_t xcr0 = ((uint64_t)edx<<32) | eax;
-    if(!((xcr0 & 0xe) == 0xe) || !((xcr0 & 0x6) == 0x6))
+    if(!((xcr0 & 0xe0) == 0xe0) || !((xcr0 & 0x6) == 0x6))
         return 0;
 
     // step 3
@@ -3,6 +3,7 @@
 
 #include <stddef.h>
 #include <vector>
+#include <atomic>
 
 #ifndef MIN
 #define MIN(a,b) ( ((a)<(b)) ? (a):(b) )
@@ -17,18 +18,52 @@
 #endif
 
 double current_sec();
+// clflush every line of [p, p+bytes) out of all cache level, then mfence
+void cache_flush(const void * p, size_t bytes, size_t cacheline_size);
 void* __aligned_malloc(size_t required_bytes, size_t alignment);
 void __aligned_free(void *p);
 
+/*
+* 2M huge page backed allocation. first try hugetlbfs pool (MAP_HUGETLB), which
+* need vm.nr_hugepages reserved. if fail, fall back to a 2M aligned anonymous map
+* with madvise(MADV_HUGEPAGE), and let THP back it if enabled.
+*/
+#define HUGE_PAGE_SIZE (2*1024*1024)
+typedef enum {
+    HUGE_PAGE_NONE = 0,     // normal 4K page
+    HUGE_PAGE_HUGETLB,      // explicit huge page from hugetlbfs pool
+    HUGE_PAGE_THP           // transparent huge page, via madvise
+}huge_page_t;
+
+// which backing __huge_malloc() is going to get on this host
+huge_page_t huge_page_probe();
+const char * huge_page_str(huge_page_t hp);
+void* __huge_malloc(size_t required_bytes);
+void __huge_free(void *p, size_t required_bytes);  // size must match __huge_malloc()
+
 template<typename T>
 void rand_vector(T* v, int elem);
 
 
-// TODO: need disable Intel HT(HyperThread). with HT on, seems thread use both virtual thread
+// pin current thread. hw thread placement (smt sibling, core) is in topology.h
 void set_current_affinity(const std::vector<int> & affinity);
 void get_current_affinity(std::vector<int> & affinity);
 int get_current_cpu();
 
+// sense reversing barrier, busy wait then yield. cheap enough to call per kc/nc block
+class spin_barrier_t {
+public:
+    spin_barrier_t(int num_threads_):num_threads(num_threads_){}
+    void wait();
+private:
+    int                 num_threads;
+    std::atomic<int>    arrived {0};
+    std::atomic<int>    sense {0};
+};
+
+// busy wait then yield until flag >= target, acquire. lock free handoff of a producer counter
+void spin_wait_ge(const std::atomic<int> & flag, int target);
+
 static inline unsigned long long sgemm_flop(unsigned long long M, unsigned long long N, unsigned long long K,
     float alpha, float beta)
 {
@@ -56,13 +91,37 @@ static inline unsigned long long sgemm_flop(unsigned long long M, unsigned long
     return M*N*(K+1)*2;
 }
 
+/*
+* hw event counter of current thread, via perf_event_open(2).
+* valid() is false if the kernel does not allow (perf_event_paranoid, container),
+* caller should print n/a instead
+*/
+typedef enum {
+    PERF_EVENT_LLC_MISS = 0,    // last level cache miss, each is one line from dram
+    PERF_EVENT_CYCLES,          // core cycles, at actual frequency
+    PERF_EVENT_REF_CYCLES       // reference cycles, at nominal (tsc) frequency
+}perf_event_t;
+
+class perf_counter_t {
+public:
+    perf_counter_t(perf_event_t event);
+    ~perf_counter_t();
+    bool valid() const { return fd >= 0; }
+    void start();
+    unsigned long long stop();  // count since start()
+private:
+    int     fd {-1};
+};
+
 void cpuid_vendor_str(char * vendor_str);
 /* F, CD, ER, PF
 * Introduced with Xeon Phi x200 (Knights Landing) and Xeon E5-26xx V5 (Skylake EP/EX "Purley", expected in H2 2017), 
 * with the last two (ER and PF) being specific to Knights Landing.
 *
 */
+int cpuid_support_sse42();
 int cpuid_support_avx();
+int cpuid_support_fma();
 int cpuid_support_avx2();
 int cpuid_support_avx512_f();
 int cpuid_support_avx512_pf();